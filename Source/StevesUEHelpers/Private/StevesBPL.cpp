@@ -7,6 +7,7 @@
 #include "StevesUiHelpers.h"
 #include "StevesUI/StevesUI.h"
 #include "ContentStreaming.h"
+#include "StevesPoissonDiskSampling.h"
 
 void UStevesBPL::SetWidgetFocus(UWidget* Widget)
 {
@@ -23,6 +24,43 @@ FStevesBalancedRandomStream UStevesBPL::MakeBalancedRandomStream(int64 Seed)
 	return FStevesBalancedRandomStream(Seed);
 }
 
+FStevesSobolRandomStream UStevesBPL::MakeSobolRandomStream(int64 Seed, int NumDimensions)
+{
+	return FStevesSobolRandomStream(Seed, NumDimensions);
+}
+
+FStevesRdRandomStream UStevesBPL::MakeRdRandomStream(int64 Seed, int NumDimensions)
+{
+	return FStevesRdRandomStream(Seed, NumDimensions);
+}
+
+FStevesScrambledHaltonRandomStream UStevesBPL::MakeScrambledHaltonRandomStream(int64 Seed, int NumDimensions)
+{
+	return FStevesScrambledHaltonRandomStream(Seed, NumDimensions);
+}
+
+TArray<FVector2D> UStevesBPL::PoissonDiskPointsInRect(FStevesBalancedRandomStream& Stream,
+	const FVector2D& Min,
+	const FVector2D& Max,
+	float Distance,
+	int MaxAttempts)
+{
+	TArray<FVector2D> Points;
+	StevesPoissonDiskSampling::SampleRect(FBox2D(Min, Max), Distance, Stream, Points, MaxAttempts);
+	return Points;
+}
+
+TArray<FVector> UStevesBPL::PoissonDiskPointsInBox(FStevesBalancedRandomStream& Stream,
+	const FVector& Min,
+	const FVector& Max,
+	float Distance,
+	int MaxAttempts)
+{
+	TArray<FVector> Points;
+	StevesPoissonDiskSampling::SampleBox(FBox(Min, Max), Distance, Stream, Points, MaxAttempts);
+	return Points;
+}
+
 void UStevesBPL::AddViewOriginToStreaming(const FVector& ViewOrigin,
 	float ScreenWidth,
 	float FOV,
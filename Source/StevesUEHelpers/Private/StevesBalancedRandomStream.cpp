@@ -0,0 +1,491 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesBalancedRandomStream.h"
+
+#include "StevesUEHelpersVersion.h"
+
+namespace
+{
+	using StevesRandConstants::kMaxLowDiscrepancyDimensions;
+
+	/// Sobol direction numbers for dimensions 2+, from Joe & Kuo (new-joe-kuo-6.21201)
+	/// Dimension 1 is just the van der Corput sequence
+	struct FSobolPrimitive
+	{
+		uint32 S;
+		uint32 A;
+		uint32 M[5];
+	};
+
+	constexpr FSobolPrimitive SobolPrimitives[kMaxLowDiscrepancyDimensions - 1] =
+	{
+		{1, 0, {1}},
+		{2, 1, {1, 3}},
+		{3, 1, {1, 3, 1}},
+		{3, 2, {1, 1, 1}},
+		{4, 1, {1, 1, 3, 3}},
+		{4, 4, {1, 3, 5, 13}},
+		{5, 2, {1, 1, 5, 5, 17}},
+	};
+
+	struct FSobolDirections
+	{
+		uint32 V[kMaxLowDiscrepancyDimensions][32];
+
+		FSobolDirections()
+		{
+			for (int32 i = 0; i < 32; ++i)
+			{
+				V[0][i] = 1u << (31 - i);
+			}
+
+			for (int32 D = 1; D < kMaxLowDiscrepancyDimensions; ++D)
+			{
+				const FSobolPrimitive& P = SobolPrimitives[D - 1];
+				uint32* Dir = V[D];
+				for (uint32 i = 0; i < P.S; ++i)
+				{
+					Dir[i] = P.M[i] << (31 - i);
+				}
+				for (uint32 i = P.S; i < 32; ++i)
+				{
+					Dir[i] = Dir[i - P.S] ^ (Dir[i - P.S] >> P.S);
+					for (uint32 k = 1; k < P.S; ++k)
+					{
+						if ((P.A >> (P.S - 1 - k)) & 1)
+						{
+							Dir[i] ^= Dir[i - k];
+						}
+					}
+				}
+			}
+		}
+	};
+
+	struct FHaltonDigitWeights
+	{
+		/// Weight of digit i is 1 / Base^(i+1) in 0.64 fixed point
+		uint64 W[kMaxLowDiscrepancyDimensions][32];
+
+		FHaltonDigitWeights()
+		{
+			for (int32 D = 0; D < kMaxLowDiscrepancyDimensions; ++D)
+			{
+				const uint64 Base = StevesRandConstants::kHaltonBases[D];
+				uint64 Weight = MAX_uint64;
+				for (int32 i = 0; i < 32; ++i)
+				{
+					// Once the weight hits 0 the digit can't affect a 64-bit result
+					Weight /= Base;
+					W[D][i] = Weight;
+				}
+			}
+		}
+	};
+
+	struct FRdAlphas
+	{
+		/// Alphas for each dimension count (index 0 = 1 dimension)
+		uint64 A[kMaxLowDiscrepancyDimensions][kMaxLowDiscrepancyDimensions];
+
+		FRdAlphas()
+		{
+			for (int32 N = 1; N <= kMaxLowDiscrepancyDimensions; ++N)
+			{
+				// Generalised golden ratio: unique positive root of x^(N+1) = x + 1
+				double Phi = 2.0;
+				for (int32 i = 0; i < 30; ++i)
+				{
+					Phi = FMath::Pow(1.0 + Phi, 1.0 / (N + 1));
+				}
+
+				double Alpha = 1.0;
+				for (int32 D = 0; D < N; ++D)
+				{
+					Alpha /= Phi;
+					// Scale to 0.64 fixed point; Alpha < 1 so this can't overflow
+					A[N - 1][D] = (uint64)(Alpha * 18446744073709551616.0);
+				}
+			}
+		}
+	};
+
+	/// Swap each group of Shift bits selected by Mask with the group Shift bits above it, in all 4 lanes
+	template <int32 Shift>
+	FORCEINLINE VectorRegister4Int SwapBitGroups4(const VectorRegister4Int& V, int32 Mask)
+	{
+		const VectorRegister4Int M = VectorIntSet1(Mask);
+		return VectorIntOr(VectorShiftLeftImm(VectorIntAnd(V, M), Shift),
+		                   VectorIntAnd(VectorShiftRightImmLogical(V, Shift), M));
+	}
+
+	/// Base 2 radical inverse of 4 consecutive seeds; the same as UIntToUnitFloat(ReverseBits(Seed)) for each
+	FORCEINLINE VectorRegister4Float RadicalInverseBase2x4(uint32 FirstSeed)
+	{
+		VectorRegister4Int V = VectorIntAdd(VectorIntSet1((int32)FirstSeed), MakeVectorRegisterInt(0, 1, 2, 3));
+		V = VectorIntOr(VectorShiftRightImmLogical(V, 16), VectorShiftLeftImm(V, 16));
+		V = SwapBitGroups4<8>(V, 0x00ff00ff);
+		V = SwapBitGroups4<4>(V, 0x0f0f0f0f);
+		V = SwapBitGroups4<2>(V, 0x33333333);
+		V = SwapBitGroups4<1>(V, 0x55555555);
+		// Only the top 24 bits fit in the mantissa, and what's left converts exactly as a signed int
+		V = VectorShiftRightImmLogical(V, 8);
+		return VectorMultiply(VectorIntToFloat(V), VectorSetFloat1(1.0f / 16777216.0f));
+	}
+
+	/// 4 sets of reversed digits to floats; the same as ReversedDigitsToUnitFloat for each
+	FORCEINLINE VectorRegister4Float ReversedDigitsToUnitFloat4(const uint32* Reversed, float InvScale)
+	{
+		return VectorMultiply(VectorIntToFloat(VectorIntLoad(Reversed)), VectorSetFloat1(InvScale));
+	}
+}
+
+const uint32 (*FStevesSobolRandomStream::GetDirectionNumbers())[32]
+{
+	static const FSobolDirections Directions;
+	return Directions.V;
+}
+
+const uint64* FStevesRdRandomStream::GetAlphas(int32 NumDimensions)
+{
+	static const FRdAlphas Alphas;
+	return Alphas.A[NumDimensions - 1];
+}
+
+const uint64 (*FStevesScrambledHaltonRandomStream::GetDigitWeights())[MaxDigits]
+{
+	static const FHaltonDigitWeights Weights;
+	return Weights.W;
+}
+
+namespace
+{
+	/// Streams had no serialised state before CompactRandomState; returning false for older data makes the engine
+	/// fall back to tagged property serialisation, which just skips the (empty) struct
+	template <typename TStream>
+	bool SerializeStream(FArchive& Ar, TStream& Stream)
+	{
+		Ar.UsingCustomVersion(FStevesUEHelpersVersion::GUID);
+		if (Ar.IsLoading() && FStevesUEHelpersVersion::Get(Ar) < FStevesUEHelpersVersion::CompactRandomState)
+		{
+			return false;
+		}
+		Stream.SerializeState(Ar);
+		return true;
+	}
+
+	/// Whether the current value of an incrementally accumulated stream is in the archive. Replication always uses
+	/// the current format, and shuffle bags may be serialised without UsingCustomVersion, so declare it here too
+	bool HasCurrentValue(FArchive& Ar)
+	{
+		if (Ar.IsNetArchive())
+		{
+			return true;
+		}
+		Ar.UsingCustomVersion(FStevesUEHelpersVersion::GUID);
+		return FStevesUEHelpersVersion::Get(Ar) >= FStevesUEHelpersVersion::RandomStreamCurrentValue;
+	}
+
+	template <typename TStream>
+	bool NetSerializeStream(FArchive& Ar, TStream& Stream, bool& bOutSuccess)
+	{
+		Stream.SerializeState(Ar);
+		bOutSuccess = !Ar.IsError();
+		return true;
+	}
+}
+
+void FStevesBalancedRandomStream::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+	if (Ar.IsLoading())
+	{
+		Initialize(SavedSeed);
+		SeekTo(Position);
+	}
+}
+
+bool FStevesBalancedRandomStream::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesBalancedRandomStream::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesBalancedRandomStream1D::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+	if (Ar.IsLoading())
+	{
+		Initialize(SavedSeed);
+		SeekTo(Position);
+	}
+}
+
+bool FStevesBalancedRandomStream1D::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesBalancedRandomStream1D::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesBalancedRandomStream2D::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+
+	// Values now only depend on the position, but older versions accumulated them in floats, so keep the exact
+	// value in case the stream came from one of those
+	FVector2f SavedValue = CurrentValue;
+	const bool bHasValue = HasCurrentValue(Ar);
+	if (bHasValue)
+	{
+		Ar << SavedValue.X << SavedValue.Y;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Initialize(SavedSeed);
+		SeekTo(Position);
+		if (bHasValue)
+		{
+			CurrentValue = SavedValue;
+		}
+	}
+}
+
+bool FStevesBalancedRandomStream2D::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesBalancedRandomStream2D::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesBalancedRandomStream2D::Rand2DBatch(TArrayView<FVector2f> OutValues)
+{
+	FVector2f* Out = OutValues.GetData();
+	const int32 Num = OutValues.Num();
+	int32 i = 0;
+	while (i < Num)
+	{
+		// Wrap back to 0 at end of safe range, same as Rand2D, but only check once per run
+		if (Base2Seed >= StevesRandConstants::kSafeMaxSeed2D)
+		{
+			Initialize(0);
+		}
+		const int32 End = (int32)FMath::Min<int64>(Num, (int64)i + (StevesRandConstants::kSafeMaxSeed2D - Base2Seed));
+
+		// The first value always comes from CurrentValue, in case it was loaded from an older version
+		Out[i++] = CurrentValue;
+		AdvanceDigits();
+
+		// Digits still carry one seed at a time, in integers, but the radical inverses are done 4 seeds at once
+		for (; i + 4 <= End; i += 4)
+		{
+			alignas(16) uint32 Reversed3[4];
+			const uint32 FirstSeed = Base2Seed;
+			for (int32 j = 0; j < 4; ++j)
+			{
+				Reversed3[j] = Base3Reversed;
+				AdvanceDigits();
+			}
+
+			alignas(16) float X[4], Y[4];
+			VectorStoreAligned(RadicalInverseBase2x4(FirstSeed), X);
+			VectorStoreAligned(ReversedDigitsToUnitFloat4(Reversed3, StevesRandConstants::kInvPow3_16), Y);
+			for (int32 j = 0; j < 4; ++j)
+			{
+				Out[i + j] = FVector2f(X[j], Y[j]);
+			}
+		}
+
+		CurrentValue = GetValue(Base2Seed, Base3Reversed);
+		for (; i < End; ++i)
+		{
+			Out[i] = CurrentValue;
+			Advance();
+		}
+	}
+}
+
+void FStevesBalancedRandomStream3D::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+
+	// Values now only depend on the position, but older versions accumulated them in floats, so keep the exact
+	// value in case the stream came from one of those
+	FVector3f SavedValue = CurrentValue;
+	const bool bHasValue = HasCurrentValue(Ar);
+	if (bHasValue)
+	{
+		Ar << SavedValue.X << SavedValue.Y << SavedValue.Z;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Initialize(SavedSeed);
+		SeekTo(Position);
+		if (bHasValue)
+		{
+			CurrentValue = SavedValue;
+		}
+	}
+}
+
+bool FStevesBalancedRandomStream3D::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesBalancedRandomStream3D::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesBalancedRandomStream3D::Rand3DBatch(TArrayView<FVector3f> OutValues)
+{
+	FVector3f* Out = OutValues.GetData();
+	const int32 Num = OutValues.Num();
+	int32 i = 0;
+	while (i < Num)
+	{
+		// Wrap back to 0 at end of safe range, same as Rand3D, but only check once per run
+		if (Base2Seed >= StevesRandConstants::kSafeMaxSeed3D)
+		{
+			Initialize(0);
+		}
+		const int32 End = (int32)FMath::Min<int64>(Num, (int64)i + (StevesRandConstants::kSafeMaxSeed3D - Base2Seed));
+
+		// The first value always comes from CurrentValue, in case it was loaded from an older version
+		Out[i++] = CurrentValue;
+		AdvanceDigits();
+
+		// Digits still carry one seed at a time, in integers, but the radical inverses are done 4 seeds at once
+		for (; i + 4 <= End; i += 4)
+		{
+			alignas(16) uint32 Reversed3[4];
+			alignas(16) uint32 Reversed5[4];
+			const uint32 FirstSeed = Base2Seed;
+			for (int32 j = 0; j < 4; ++j)
+			{
+				Reversed3[j] = Base3Reversed;
+				Reversed5[j] = Base5Reversed;
+				AdvanceDigits();
+			}
+
+			alignas(16) float X[4], Y[4], Z[4];
+			VectorStoreAligned(RadicalInverseBase2x4(FirstSeed), X);
+			VectorStoreAligned(ReversedDigitsToUnitFloat4(Reversed3, StevesRandConstants::kInvPow3_15), Y);
+			VectorStoreAligned(ReversedDigitsToUnitFloat4(Reversed5, StevesRandConstants::kInvPow5_10), Z);
+			for (int32 j = 0; j < 4; ++j)
+			{
+				Out[i + j] = FVector3f(X[j], Y[j], Z[j]);
+			}
+		}
+
+		CurrentValue = GetValue(Base2Seed, Base3Reversed, Base5Reversed);
+		for (; i < End; ++i)
+		{
+			Out[i] = CurrentValue;
+			Advance();
+		}
+	}
+}
+
+void FStevesSobolRandomStream::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	uint32 Dimensions = NumDimensions;
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+	Ar.SerializeIntPacked(Dimensions);
+	if (Ar.IsLoading())
+	{
+		InitialSeed = SavedSeed;
+		SetNumDimensions(Dimensions);
+		SeekTo(Position);
+	}
+}
+
+bool FStevesSobolRandomStream::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesSobolRandomStream::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesRdRandomStream::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint64 Position = GetPosition();
+	uint32 Dimensions = NumDimensions;
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked64(Position);
+	Ar.SerializeIntPacked(Dimensions);
+	if (Ar.IsLoading())
+	{
+		InitialSeed = SavedSeed;
+		SetNumDimensions(Dimensions);
+		SeekTo(Position);
+	}
+}
+
+bool FStevesRdRandomStream::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesRdRandomStream::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
+
+void FStevesScrambledHaltonRandomStream::SerializeState(FArchive& Ar)
+{
+	uint32 SavedSeed = InitialSeed;
+	uint32 Position = GetPosition();
+	uint32 Dimensions = NumDimensions;
+	Ar.SerializeIntPacked(SavedSeed);
+	Ar.SerializeIntPacked(Position);
+	Ar.SerializeIntPacked(Dimensions);
+	if (Ar.IsLoading())
+	{
+		InitialSeed = SavedSeed;
+		SetNumDimensions(Dimensions);
+		SeekTo(Position);
+	}
+}
+
+bool FStevesScrambledHaltonRandomStream::Serialize(FArchive& Ar)
+{
+	return SerializeStream(Ar, *this);
+}
+
+bool FStevesScrambledHaltonRandomStream::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return NetSerializeStream(Ar, *this, bOutSuccess);
+}
@@ -0,0 +1,138 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesDebugMeshCache.h"
+#include "Engine/StaticMesh.h"
+#include "RenderingThread.h"
+
+FStevesDebugMeshGeometry::FStevesDebugMeshGeometry(const FKey& InKey)
+	: VertexFactory(GMaxRHIFeatureLevel, "FStevesDebugMeshGeometry")
+	, LocalBounds(ForceInit)
+	, Key(InKey)
+{
+}
+
+uint32 FStevesDebugMeshGeometry::AddRef() const
+{
+	FScopeLock ScopeLock(&FStevesDebugMeshCache::Get().Lock);
+	return ++RefCount;
+}
+
+uint32 FStevesDebugMeshGeometry::Release() const
+{
+	FStevesDebugMeshCache& Cache = FStevesDebugMeshCache::Get();
+	FScopeLock ScopeLock(&Cache.Lock);
+	check(RefCount > 0);
+	const uint32 Refs = --RefCount;
+	if (Refs == 0)
+	{
+		Cache.Entries.Remove(Key);
+
+		// Usually already on the render thread since that's where proxies are destroyed, in which case this runs now
+		FStevesDebugMeshGeometry* Geometry = const_cast<FStevesDebugMeshGeometry*>(this);
+		ENQUEUE_RENDER_COMMAND(ReleaseStevesDebugMeshGeometry)(
+			[Geometry](FRHICommandListImmediate& RHICmdList)
+			{
+				Geometry->VertexBuffers.PositionVertexBuffer.ReleaseResource();
+				Geometry->VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+				Geometry->VertexBuffers.ColorVertexBuffer.ReleaseResource();
+				Geometry->IndexBuffer.ReleaseResource();
+				Geometry->VertexFactory.ReleaseResource();
+				delete Geometry;
+			});
+	}
+	return Refs;
+}
+
+uint32 FStevesDebugMeshGeometry::GetRefCount() const
+{
+	FScopeLock ScopeLock(&FStevesDebugMeshCache::Get().Lock);
+	return RefCount;
+}
+
+FStevesDebugMeshCache& FStevesDebugMeshCache::Get()
+{
+	static FStevesDebugMeshCache Instance;
+	return Instance;
+}
+
+TRefCountPtr<FStevesDebugMeshGeometry> FStevesDebugMeshCache::FindOrAdd(const UStaticMesh* Mesh, int32 LODIndex)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(Mesh) || !Mesh->GetRenderData() || Mesh->GetNumLODs() == 0)
+	{
+		return nullptr;
+	}
+
+	LODIndex = FMath::Clamp(LODIndex, 0, Mesh->GetNumLODs() - 1);
+	const FStevesDebugMeshGeometry::FKey Key { Mesh, GetMeshGeneration(Mesh), LODIndex };
+
+	{
+		// Take the reference while still locked, so a release on the render thread can't delete it in between
+		FScopeLock ScopeLock(&Lock);
+		if (FStevesDebugMeshGeometry** Existing = Entries.Find(Key))
+		{
+			return TRefCountPtr<FStevesDebugMeshGeometry>(*Existing);
+		}
+	}
+
+	const FStaticMeshLODResources& Lod = Mesh->GetLODForExport(LODIndex);
+	auto& PosBuffer = Lod.VertexBuffers.PositionVertexBuffer;
+	const uint32 NumVerts = PosBuffer.GetNumVertices();
+	if (NumVerts == 0 || Lod.IndexBuffer.GetNumIndices() == 0)
+	{
+		return nullptr;
+	}
+
+	FStevesDebugMeshGeometry* Geometry = new FStevesDebugMeshGeometry(Key);
+	Lod.IndexBuffer.GetCopy(Geometry->IndexBuffer.Indices);
+
+	TArray<FDynamicMeshVertex> Vertices;
+	Vertices.Reserve(NumVerts);
+	for (uint32 i = 0; i < NumVerts; ++i)
+	{
+		const FVector3f& Pos = PosBuffer.VertexPosition(i);
+		Vertices.Add(FDynamicMeshVertex(Pos));
+		Geometry->LocalBounds += FVector(Pos);
+	}
+
+	Geometry->VertexBuffers.InitFromDynamicVertex(&Geometry->VertexFactory, Vertices);
+	BeginInitResource(&Geometry->VertexBuffers.PositionVertexBuffer);
+	BeginInitResource(&Geometry->VertexBuffers.StaticMeshVertexBuffer);
+	BeginInitResource(&Geometry->VertexBuffers.ColorVertexBuffer);
+	BeginInitResource(&Geometry->IndexBuffer);
+	BeginInitResource(&Geometry->VertexFactory);
+
+	FScopeLock ScopeLock(&Lock);
+	Entries.Add(Key, Geometry);
+	return TRefCountPtr<FStevesDebugMeshGeometry>(Geometry);
+}
+
+uint32 FStevesDebugMeshCache::GetMeshGeneration(const UStaticMesh* Mesh)
+{
+	if (const uint32* Generation = MeshGenerations.Find(Mesh))
+	{
+		return *Generation;
+	}
+
+#if WITH_EDITOR
+	// First time we've seen this mesh, so find out when it's rebuilt from now on
+	const_cast<UStaticMesh*>(Mesh)->OnPostMeshBuild().AddRaw(this, &FStevesDebugMeshCache::OnMeshBuilt);
+#endif
+	MeshGenerations.Add(Mesh, 0);
+	return 0;
+}
+
+#if WITH_EDITOR
+void FStevesDebugMeshCache::OnMeshBuilt(UStaticMesh* Mesh)
+{
+	// Existing entries stay alive for proxies still using them, but won't be found again
+	++MeshGenerations.FindOrAdd(Mesh);
+}
+#endif
+
+int32 FStevesDebugMeshCache::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
@@ -6,6 +6,9 @@
 #include "SceneManagement.h"
 #include "DynamicMeshBuilder.h"
 #include "Engine/Engine.h"
+#include "GlobalRenderResources.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderingThread.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialRenderProxy.h"
 
@@ -15,10 +18,246 @@
 #endif
 
 
+static TAutoConsoleVariable<bool> CVarStevesDebugLineGeometry(
+	TEXT("Steves.DebugRender.LineGeometry"),
+	true,
+	TEXT("Draw pre-tessellated debug shapes from line geometry on the GPU. If false, draw their lines through the PDI each frame instead, for comparison"),
+	ECVF_RenderThreadSafe);
+
+namespace
+{
+	using FTessellatedLines = TArray<FStevesDebugRenderSceneProxy::FTessellatedLine>;
+
+	// These produce the same lines as the engine's DrawCircle, DrawArc etc, but store them for re-use
+
+	void TessellateCircle(FTessellatedLines& Out, const FVector& Base, const FVector& X, const FVector& Y,
+	                      const FColor& Color, float Radius, int32 NumSides, float Thickness = 0, int32 SideCount = -1)
+	{
+		if (SideCount < 0)
+		{
+			SideCount = NumSides;
+		}
+		const float AngleDelta = 2.0f * UE_PI / NumSides;
+		FVector LastVertex = Base + X * Radius;
+		for (int32 SideIndex = 0; SideIndex < SideCount; SideIndex++)
+		{
+			const FVector Vertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
+			Out.Add({LastVertex, Vertex, Color, Thickness});
+			LastVertex = Vertex;
+		}
+	}
+
+	void TessellateArc(FTessellatedLines& Out, const FVector& Base, const FVector& X, const FVector& Y,
+	                   float MinAngle, float MaxAngle, float Radius, int32 Sections, const FColor& Color)
+	{
+		const float AngleStep = (MaxAngle - MinAngle) / ((float)(Sections));
+		float CurrentAngle = MinAngle;
+		FVector LastVertex = Base + Radius * (FMath::Cos(CurrentAngle * (UE_PI / 180.0f)) * X + FMath::Sin(CurrentAngle * (UE_PI / 180.0f)) * Y);
+		CurrentAngle += AngleStep;
+		for (int32 i = 0; i < Sections; i++)
+		{
+			const FVector ThisVertex = Base + Radius * (FMath::Cos(CurrentAngle * (UE_PI / 180.0f)) * X + FMath::Sin(CurrentAngle * (UE_PI / 180.0f)) * Y);
+			Out.Add({LastVertex, ThisVertex, Color, 0});
+			LastVertex = ThisVertex;
+			CurrentAngle += AngleStep;
+		}
+	}
+
+	void TessellateCylinder(FTessellatedLines& Out, const FVector& Base, const FVector& X, const FVector& Y,
+	                        const FVector& Z, const FColor& Color, float Radius, float HalfHeight, int32 NumSides)
+	{
+		const float AngleDelta = 2.0f * UE_PI / NumSides;
+		FVector LastVertex = Base + X * Radius;
+		for (int32 SideIndex = 0; SideIndex < NumSides; SideIndex++)
+		{
+			const FVector Vertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
+			Out.Add({LastVertex - Z * HalfHeight, Vertex - Z * HalfHeight, Color, 0});
+			Out.Add({LastVertex + Z * HalfHeight, Vertex + Z * HalfHeight, Color, 0});
+			Out.Add({LastVertex - Z * HalfHeight, LastVertex + Z * HalfHeight, Color, 0});
+			LastVertex = Vertex;
+		}
+	}
+
+	void TessellateCapsule(FTessellatedLines& Out, const FVector& Base, const FVector& X, const FVector& Y,
+	                       const FVector& Z, const FColor& Color, float Radius, float HalfHeight, int32 NumSides)
+	{
+		const float HalfAxis = FMath::Max<float>(HalfHeight - Radius, 1.f);
+		const FVector TopEnd = Base + HalfAxis * Z;
+		const FVector BottomEnd = Base - HalfAxis * Z;
+
+		TessellateCircle(Out, TopEnd, Y, Z, Color, Radius, NumSides, 0, NumSides / 2);
+		TessellateCircle(Out, TopEnd, X, Z, Color, Radius, NumSides, 0, NumSides / 2);
+		TessellateCircle(Out, BottomEnd, Y, -Z, Color, Radius, NumSides, 0, NumSides / 2);
+		TessellateCircle(Out, BottomEnd, X, -Z, Color, Radius, NumSides, 0, NumSides / 2);
+		TessellateCircle(Out, TopEnd, X, Y, Color, Radius, NumSides);
+		TessellateCircle(Out, BottomEnd, X, Y, Color, Radius, NumSides);
+
+		Out.Add({TopEnd + Radius * X, BottomEnd + Radius * X, Color, 0});
+		Out.Add({TopEnd - Radius * X, BottomEnd - Radius * X, Color, 0});
+		Out.Add({TopEnd + Radius * Y, BottomEnd + Radius * Y, Color, 0});
+		Out.Add({TopEnd - Radius * Y, BottomEnd - Radius * Y, Color, 0});
+	}
+
+	/// Tessellate one shape at every LOD; Tessellate is called with the lines to add to and the LOD
+	template <typename TessellateFunc>
+	void AddTessellatedShape(FStevesDebugRenderSceneProxy::FTessellatedShapes& Out, const FVector& Centre, float Radius,
+	                         TessellateFunc&& Tessellate)
+	{
+		FStevesDebugRenderSceneProxy::FTessellatedShape& Shape = Out.Shapes.AddDefaulted_GetRef();
+		Shape.Centre = Centre;
+		Shape.Radius = Radius;
+		for (int32 LOD = 0; LOD < FStevesDebugRenderSceneProxy::NumShapeLODs; ++LOD)
+		{
+			Shape.FirstLine[LOD] = Out.Lines.Num();
+			Tessellate(Out.Lines, LOD);
+			Shape.NumLines[LOD] = Out.Lines.Num() - Shape.FirstLine[LOD];
+		}
+	}
+
+	/// Capsule bounding sphere radius, allowing for the minimum axis length DrawWireCapsule uses
+	float GetCapsuleBoundsRadius(float Radius, float HalfHeight)
+	{
+		return FMath::Max<float>(HalfHeight - Radius, 1.f) + Radius;
+	}
+}
+
+FStevesDebugRenderSceneProxy::~FStevesDebugRenderSceneProxy()
+{
+	ReleaseLineGeometry(WorldLineGeometry);
+	ReleaseLineGeometry(ForegroundLineGeometry);
+}
+
 void FStevesDebugRenderSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>& Views,
                                                           const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const
 {
-	FDebugRenderSceneProxy::GetDynamicMeshElements(Views, ViewFamily, VisibilityMap, Collector);
+	if (!bShapesInLocalSpace)
+	{
+		FDebugRenderSceneProxy::GetDynamicMeshElements(Views, ViewFamily, VisibilityMap, Collector);
+	}
+
+	// Shapes are either already in world space, or need the component transform applying now
+	const FMatrix& XForm = bShapesInLocalSpace ? GetLocalToWorld() : FMatrix::Identity;
+	const FVector XFormScale = XForm.GetScaleVector();
+	const float MaxScale = XFormScale.GetMax();
+	// Tessellated shapes assume the same scale on all axes
+	const bool bDrawTessellated = bShapesTessellated && FMath::IsNearlyEqual(XFormScale.GetMin(), MaxScale, MaxScale * 1e-4f);
+
+	// Cull & choose LOD per shape, counting the lines we'll draw so they can be reserved up front
+	auto ChooseShapeLODs = [this, &XForm, MaxScale](const FSceneView* View, const FTessellatedShapes& Tessellated,
+	                                                TArray<int8>& OutLODs, int32& InOutNumLines, int32& InOutNumThickLines)
+	{
+		OutLODs.Reset(Tessellated.Shapes.Num());
+		for (const auto& Shape : Tessellated.Shapes)
+		{
+			const int32 LOD = GetShapeLOD(View, XForm.TransformPosition(Shape.Centre), Shape.Radius * MaxScale);
+			OutLODs.Add((int8)LOD);
+			if (LOD != INDEX_NONE && Shape.NumLines[LOD] > 0)
+			{
+				// Thickness is per shape, so the first line tells us which list they all go in
+				const bool bThick = Tessellated.Lines[Shape.FirstLine[LOD]].Thickness > 0;
+				(bThick ? InOutNumThickLines : InOutNumLines) += Shape.NumLines[LOD];
+			}
+		}
+	};
+	// Write the indices of the thin lines for the LODs chosen above; each line is 2 consecutive vertices, so each
+	// shape is one run of indices
+	auto WriteLineIndices = [](uint32*& Out, const FTessellatedShapes& Tessellated, const TArray<int8>& LODs)
+	{
+		for (int32 ShapeIndex = 0; ShapeIndex < Tessellated.Shapes.Num(); ++ShapeIndex)
+		{
+			const int32 LOD = LODs[ShapeIndex];
+			if (LOD == INDEX_NONE)
+			{
+				continue;
+			}
+			const FTessellatedShape& Shape = Tessellated.Shapes[ShapeIndex];
+			if (Shape.NumLines[LOD] == 0 || Tessellated.Lines[Shape.FirstLine[LOD]].Thickness > 0)
+			{
+				continue;
+			}
+			const uint32 FirstVertex = Tessellated.FirstVertex + Shape.FirstLine[LOD] * 2;
+			const uint32 EndVertex = FirstVertex + Shape.NumLines[LOD] * 2;
+			for (uint32 v = FirstVertex; v < EndVertex; ++v)
+			{
+				*Out++ = v;
+			}
+		}
+	};
+	// Draw thick or thin lines for the LODs chosen above through the PDI
+	auto DrawPDITessellatedShapes = [&XForm](FPrimitiveDrawInterface* PDI, const FTessellatedShapes& Tessellated,
+	                                         const TArray<int8>& LODs, ESceneDepthPriorityGroup DepthPriority, bool bThick)
+	{
+		for (int32 ShapeIndex = 0; ShapeIndex < Tessellated.Shapes.Num(); ++ShapeIndex)
+		{
+			const int32 LOD = LODs[ShapeIndex];
+			if (LOD == INDEX_NONE)
+			{
+				continue;
+			}
+			const FTessellatedShape& Shape = Tessellated.Shapes[ShapeIndex];
+			if (Shape.NumLines[LOD] == 0 || (Tessellated.Lines[Shape.FirstLine[LOD]].Thickness > 0) != bThick)
+			{
+				continue;
+			}
+			const int32 EndLine = Shape.FirstLine[LOD] + Shape.NumLines[LOD];
+			for (int32 i = Shape.FirstLine[LOD]; i < EndLine; ++i)
+			{
+				const FTessellatedLine& L = Tessellated.Lines[i];
+				PDI->DrawLine(XForm.TransformPosition(L.Start), XForm.TransformPosition(L.End), L.Color, DepthPriority, L.Thickness, 0, bThick);
+			}
+		}
+	};
+	// The line geometry is in the same space as the shapes, so is drawn with XForm; shared by every view
+	FDynamicPrimitiveUniformBuffer* LineUniformBuffer = nullptr;
+	auto GetLineUniformBuffer = [&]() -> FDynamicPrimitiveUniformBuffer&
+	{
+		if (!LineUniformBuffer)
+		{
+			LineUniformBuffer = &Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+			const FBoxSphereBounds LocalBounds = bShapesInLocalSpace ? GetLocalBounds() : GetBounds();
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+			LineUniformBuffer->Set(Collector.GetRHICommandList(), XForm, XForm, GetBounds(), LocalBounds, false, false, false);
+#else
+			LineUniformBuffer->Set(XForm, XForm, GetBounds(), LocalBounds, false, false, false);
+#endif
+		}
+		return *LineUniformBuffer;
+	};
+	// Draw NumLines thin lines from line geometry as one line list, with WriteIndices choosing which
+	auto DrawLineGeometry = [&](int32 ViewIndex, const FStevesDebugLineGeometry* Geometry, int32 NumLines,
+	                            ESceneDepthPriorityGroup DepthPriority, TFunctionRef<void(uint32*&)> WriteIndices)
+	{
+		if (!Geometry || NumLines == 0)
+		{
+			return;
+		}
+		const FGlobalDynamicIndexBuffer::FAllocationEx Indices = Collector.GetDynamicIndexBuffer().Allocate(NumLines * 2, sizeof(uint32));
+		if (!Indices.IsValid())
+		{
+			return;
+		}
+		uint32* Out = (uint32*)Indices.Buffer;
+		WriteIndices(Out);
+		check(Out == (uint32*)Indices.Buffer + NumLines * 2);
+
+		FMeshBatch& MeshBatch = Collector.AllocateMesh();
+		FMeshBatchElement& BatchElement = MeshBatch.Elements[0];
+		BatchElement.IndexBuffer = Indices.IndexBuffer;
+		BatchElement.PrimitiveUniformBufferResource = &GetLineUniformBuffer().UniformBuffer;
+		BatchElement.FirstIndex = Indices.FirstIndex;
+		BatchElement.NumPrimitives = NumLines;
+		BatchElement.MinVertexIndex = 0;
+		BatchElement.MaxVertexIndex = Geometry->GetNumVertices() - 1;
+		MeshBatch.VertexFactory = &Geometry->VertexFactory;
+		MeshBatch.MaterialRenderProxy = GEngine->VertexColorMaterial->GetRenderProxy();
+		MeshBatch.Type = PT_LineList;
+		MeshBatch.DepthPriorityGroup = DepthPriority;
+		MeshBatch.CastShadow = false;
+		MeshBatch.bCanApplyViewModeOverrides = false;
+		Collector.AddMesh(ViewIndex, MeshBatch);
+	};
+	// Re-used between views
+	TArray<int8> CircleLODs, ArcLODs, CylinderLODs, CapsuleLODs;
 
 	for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
 	{
@@ -27,55 +266,182 @@ void FStevesDebugRenderSceneProxy::GetDynamicMeshElements(const TArray<const FSc
 			const FSceneView* View = Views[ViewIndex];
 			FPrimitiveDrawInterface* PDI = Collector.GetPDI(ViewIndex);
 
-			// Draw Circles
-			for (const auto& C : Circles)
+			if (bShapesInLocalSpace)
 			{
-				DrawCircle(PDI, C.Centre, C.X, C.Y, C.Color, C.Radius, C.NumSegments, SDPG_World, C.Thickness, 0, C.Thickness > 0);
+				// Superclass shapes, which it would otherwise draw in world space
+				for (const auto& L : Lines)
+				{
+					const FVector Start = XForm.TransformPosition(L.Start);
+					const FVector End = XForm.TransformPosition(L.End);
+					if (GetShapeLOD(View, (Start + End) * 0.5f, FVector::Dist(Start, End) * 0.5f) != INDEX_NONE)
+					{
+						PDI->DrawLine(Start, End, L.Color, SDPG_World, L.Thickness, 0, L.Thickness > 0);
+					}
+				}
+				for (const auto& A : ArrowLines)
+				{
+					const FVector Start = XForm.TransformPosition(A.Start);
+					const FVector End = XForm.TransformPosition(A.End);
+					// Allow for the arrow head
+					if (GetShapeLOD(View, (Start + End) * 0.5f, FVector::Dist(Start, End) * 0.5f + 8.0f) != INDEX_NONE)
+					{
+						DrawLineArrow(PDI, Start, End, A.Color, 8.0f);
+					}
+				}
+				for (const auto& S : Spheres)
+				{
+					const FVector Centre = XForm.TransformPosition(S.Location);
+					const float Radius = S.Radius * MaxScale;
+					const int32 LOD = GetShapeLOD(View, Centre, Radius);
+					if (LOD != INDEX_NONE)
+					{
+						::DrawWireSphere(PDI, Centre, S.Color, Radius, GetLODSegments(20, LOD), SDPG_World);
+					}
+				}
+				for (const auto& B : Boxes)
+				{
+					const FMatrix BoxXForm = B.Transform.ToMatrixWithScale() * XForm;
+					const FBoxSphereBounds Bounds = FBoxSphereBounds(B.Box).TransformBy(BoxXForm);
+					if (GetShapeLOD(View, Bounds.Origin, Bounds.SphereRadius) != INDEX_NONE)
+					{
+						::DrawWireBox(PDI, BoxXForm, B.Box, B.Color, SDPG_World);
+					}
+				}
 			}
 
-			// Draw Arcs
-			for (const auto& C : Arcs)
+			if (bDrawTessellated)
 			{
-				::DrawArc(PDI, 
-					C.Centre, 
-					C.X, C.Y, 
-					C.MinAngle, C.MaxAngle,
-					C.Radius, C.NumSegments,
-					C.Color, SDPG_Foreground);	
-			}
-			// Draw Cylinders (properly! superclass ignores transforms)
-			for (const auto& C : CylindersImproved)
-			{
-				::DrawWireCylinder(PDI,
-				                   C.Centre,
-				                   C.X,
-				                   C.Y,
-				                   C.Z,
-				                   C.Color,
-				                   C.Radius,
-				                   C.HalfHeight,
-				                   C.NumSegments,
-				                   SDPG_Foreground);
+				int32 NumWorldLines = 0, NumWorldThickLines = 0;
+				int32 NumForegroundLines = 0, NumForegroundThickLines = 0;
+				ChooseShapeLODs(View, TessellatedCircles, CircleLODs, NumWorldLines, NumWorldThickLines);
+				ChooseShapeLODs(View, TessellatedArcs, ArcLODs, NumForegroundLines, NumForegroundThickLines);
+				ChooseShapeLODs(View, TessellatedCylinders, CylinderLODs, NumForegroundLines, NumForegroundThickLines);
+				ChooseShapeLODs(View, TessellatedCapsules, CapsuleLODs, NumForegroundLines, NumForegroundThickLines);
+
+				// Thin lines are already on the GPU, so each depth priority group is one line list of the chosen LODs
+				const bool bUseLineGeometry = CVarStevesDebugLineGeometry.GetValueOnRenderThread();
+				if (bUseLineGeometry)
+				{
+					DrawLineGeometry(ViewIndex, WorldLineGeometry, NumWorldLines, SDPG_World, [&](uint32*& Out)
+					{
+						WriteLineIndices(Out, TessellatedCircles, CircleLODs);
+					});
+				}
+				else if (NumWorldLines > 0)
+				{
+					PDI->AddReserveLines(SDPG_World, NumWorldLines);
+					DrawPDITessellatedShapes(PDI, TessellatedCircles, CircleLODs, SDPG_World, false);
+				}
+				// Meshes only get a foreground pass with editor compositing, otherwise they'd be depth tested against
+				// the world, so foreground lines go through the PDI instead
+				if (bUseLineGeometry && UseEditorCompositing(View))
+				{
+					DrawLineGeometry(ViewIndex, ForegroundLineGeometry, NumForegroundLines, SDPG_Foreground, [&](uint32*& Out)
+					{
+						WriteLineIndices(Out, TessellatedArcs, ArcLODs);
+						WriteLineIndices(Out, TessellatedCylinders, CylinderLODs);
+						WriteLineIndices(Out, TessellatedCapsules, CapsuleLODs);
+					});
+				}
+				else if (NumForegroundLines > 0)
+				{
+					PDI->AddReserveLines(SDPG_Foreground, NumForegroundLines);
+					DrawPDITessellatedShapes(PDI, TessellatedArcs, ArcLODs, SDPG_Foreground, false);
+					DrawPDITessellatedShapes(PDI, TessellatedCylinders, CylinderLODs, SDPG_Foreground, false);
+					DrawPDITessellatedShapes(PDI, TessellatedCapsules, CapsuleLODs, SDPG_Foreground, false);
+				}
+
+				// Thick lines have to be expanded to quads, which the PDI does, with one reserve per depth priority group
+				if (NumWorldThickLines > 0)
+				{
+					PDI->AddReserveLines(SDPG_World, NumWorldThickLines, false, true);
+					DrawPDITessellatedShapes(PDI, TessellatedCircles, CircleLODs, SDPG_World, true);
+				}
+				if (NumForegroundThickLines > 0)
+				{
+					PDI->AddReserveLines(SDPG_Foreground, NumForegroundThickLines, false, true);
+					DrawPDITessellatedShapes(PDI, TessellatedArcs, ArcLODs, SDPG_Foreground, true);
+					DrawPDITessellatedShapes(PDI, TessellatedCylinders, CylinderLODs, SDPG_Foreground, true);
+					DrawPDITessellatedShapes(PDI, TessellatedCapsules, CapsuleLODs, SDPG_Foreground, true);
+				}
 			}
-			for (const auto& C : CapsulesImproved)
+			else
 			{
-				::DrawWireCapsule(PDI,
-#if ENGINE_MAJOR_VERSION >= 5					
-								   C.Base,
+				// Draw Circles
+				for (const auto& C : Circles)
+				{
+					const FVector Centre = XForm.TransformPosition(C.Centre);
+					const int32 LOD = GetShapeLOD(View, Centre, C.Radius * MaxScale);
+					if (LOD == INDEX_NONE)
+					{
+						continue;
+					}
+					DrawCircle(PDI, Centre,
+					           XForm.TransformVector(C.X).GetSafeNormal(), XForm.TransformVector(C.Y).GetSafeNormal(),
+					           C.Color, C.Radius * MaxScale, GetLODSegments(C.NumSegments, LOD), SDPG_World, C.Thickness, 0, C.Thickness > 0);
+				}
+
+				// Draw Arcs
+				for (const auto& C : Arcs)
+				{
+					const FVector Centre = XForm.TransformPosition(C.Centre);
+					const int32 LOD = GetShapeLOD(View, Centre, C.Radius * MaxScale);
+					if (LOD == INDEX_NONE)
+					{
+						continue;
+					}
+					::DrawArc(PDI, 
+						Centre, 
+						XForm.TransformVector(C.X).GetSafeNormal(), XForm.TransformVector(C.Y).GetSafeNormal(), 
+						C.MinAngle, C.MaxAngle,
+						C.Radius * MaxScale, GetLODSegments(C.NumSegments, LOD),
+						C.Color, SDPG_Foreground);	
+				}
+				// Draw Cylinders (properly! superclass ignores transforms)
+				for (const auto& C : CylindersImproved)
+				{
+					const FVector Centre = XForm.TransformPosition(C.Centre);
+					const int32 LOD = GetShapeLOD(View, Centre, FVector2D(C.Radius, C.HalfHeight).Size() * XFormScale.Z);
+					if (LOD == INDEX_NONE)
+					{
+						continue;
+					}
+					::DrawWireCylinder(PDI,
+					                   Centre,
+					                   XForm.TransformVector(C.X).GetSafeNormal(),
+					                   XForm.TransformVector(C.Y).GetSafeNormal(),
+					                   XForm.TransformVector(C.Z).GetSafeNormal(),
+					                   C.Color,
+					                   C.Radius * XFormScale.Z,
+					                   C.HalfHeight * XFormScale.Z,
+					                   GetLODSegments(C.NumSegments, LOD),
+					                   SDPG_Foreground);
+				}
+				for (const auto& C : CapsulesImproved)
+				{
+#if ENGINE_MAJOR_VERSION >= 5
+					const FVector Centre = XForm.TransformPosition(C.Base);
 #else
-								   C.Location,
+					const FVector Centre = XForm.TransformPosition(C.Location);
 #endif
-								   C.X,
-								   C.Y,
-								   C.Z,
-								   C.Color,
-								   C.Radius,
-								   C.HalfHeight,
-								   16,
-								   SDPG_Foreground);
+					const int32 LOD = GetShapeLOD(View, Centre, GetCapsuleBoundsRadius(C.Radius * XFormScale.Z, C.HalfHeight * XFormScale.Z));
+					if (LOD == INDEX_NONE)
+					{
+						continue;
+					}
+					::DrawWireCapsule(PDI,
+									   Centre,
+									   XForm.TransformVector(C.X).GetSafeNormal(),
+									   XForm.TransformVector(C.Y).GetSafeNormal(),
+									   XForm.TransformVector(C.Z).GetSafeNormal(),
+									   C.Color,
+									   C.Radius * XFormScale.Z,
+									   C.HalfHeight * XFormScale.Z,
+									   GetLODSegments(16, LOD),
+									   SDPG_Foreground);
+				}
 			}
 
-			
 			for (const auto& Mesh : MeshesImproved)
 			{
 				FDynamicMeshBuilder MeshBuilder(View->GetFeatureLevel());
@@ -89,13 +455,296 @@ void FStevesDebugRenderSceneProxy::GetDynamicMeshElements(const TArray<const FSc
 				Settings.bWireframe = true;
 				Settings.bUseSelectionOutline = false;
 				Settings.bUseWireframeSelectionColoring = true;
-				MeshBuilder.GetMesh(Mesh.LocalToWorld, MatRenderProxy, SDPG_World, Settings, nullptr, ViewIndex, Collector);
+				MeshBuilder.GetMesh(Mesh.LocalToWorld * XForm, MatRenderProxy, SDPG_World, Settings, nullptr, ViewIndex, Collector);
+			}
+
+			// Shared meshes: GPU buffers already exist, we just need a uniform buffer for our transform
+			for (const auto& Inst : MeshInstances)
+			{
+				const FStevesDebugMeshGeometry* Geometry = Inst.Geometry.GetReference();
+				if (!Geometry)
+				{
+					continue;
+				}
+
+				const FMatrix InstXForm = Inst.LocalToWorld * XForm;
+				const FBoxSphereBounds LocalBounds(Geometry->LocalBounds);
+				const FBoxSphereBounds WorldBounds = LocalBounds.TransformBy(InstXForm);
+				if (GetShapeLOD(View, WorldBounds.Origin, WorldBounds.SphereRadius) == INDEX_NONE)
+				{
+					continue;
+				}
+
+				const auto MatRenderProxy = new FColoredMaterialRenderProxy(GEngine->WireframeMaterial->GetRenderProxy(), Inst.Color);
+				Collector.RegisterOneFrameMaterialProxy(MatRenderProxy);
+
+				FDynamicPrimitiveUniformBuffer& PrimitiveUniformBuffer = Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+				PrimitiveUniformBuffer.Set(Collector.GetRHICommandList(), InstXForm, InstXForm,
+				                           WorldBounds, LocalBounds, false, false, false);
+#else
+				PrimitiveUniformBuffer.Set(InstXForm, InstXForm, WorldBounds, LocalBounds, false, false, false);
+#endif
+
+				FMeshBatch& MeshBatch = Collector.AllocateMesh();
+				FMeshBatchElement& BatchElement = MeshBatch.Elements[0];
+				BatchElement.IndexBuffer = &Geometry->IndexBuffer;
+				BatchElement.PrimitiveUniformBufferResource = &PrimitiveUniformBuffer.UniformBuffer;
+				BatchElement.FirstIndex = 0;
+				BatchElement.NumPrimitives = Geometry->GetNumTriangles();
+				BatchElement.MinVertexIndex = 0;
+				BatchElement.MaxVertexIndex = Geometry->GetNumVertices() - 1;
+				MeshBatch.VertexFactory = &Geometry->VertexFactory;
+				MeshBatch.MaterialRenderProxy = MatRenderProxy;
+				MeshBatch.bWireframe = true;
+				MeshBatch.ReverseCulling = InstXForm.Determinant() < 0.0f;
+				MeshBatch.Type = PT_TriangleList;
+				MeshBatch.DepthPriorityGroup = SDPG_World;
+				MeshBatch.bCanApplyViewModeOverrides = false;
+				Collector.AddMesh(ViewIndex, MeshBatch);
 			}
 			
 		}
 	}
 }
 
+void FStevesDebugRenderSceneProxy::ApplyShapeUpdate(FShapeUpdate&& Update)
+{
+	const EStevesDebugShapes Shapes = Update.Shapes;
+	const bool bAppend = Update.bAppend;
+	auto Apply = [bAppend](auto& Dest, auto& Source)
+	{
+		if (bAppend)
+		{
+			Dest.Append(MoveTemp(Source));
+		}
+		else
+		{
+			Dest = MoveTemp(Source);
+		}
+	};
+
+	// When appending, existing shapes are already tessellated
+	const bool bTessellateNewOnly = bAppend && bShapesTessellated;
+	const int32 FirstCircle = bTessellateNewOnly ? Circles.Num() : 0;
+	const int32 FirstArc = bTessellateNewOnly ? Arcs.Num() : 0;
+	const int32 FirstCylinder = bTessellateNewOnly ? CylindersImproved.Num() : 0;
+	const int32 FirstCapsule = bTessellateNewOnly ? CapsulesImproved.Num() : 0;
+
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Lines))
+	{
+		Apply(Lines, Update.Lines);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arrows))
+	{
+		Apply(ArrowLines, Update.ArrowLines);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Circles))
+	{
+		Apply(Circles, Update.Circles);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arcs))
+	{
+		Apply(Arcs, Update.Arcs);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Spheres))
+	{
+		Apply(Spheres, Update.Spheres);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Boxes))
+	{
+		Apply(Boxes, Update.Boxes);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Cylinders))
+	{
+		Apply(CylindersImproved, Update.Cylinders);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Capsules))
+	{
+		Apply(CapsulesImproved, Update.Capsules);
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Meshes))
+	{
+		Apply(MeshesImproved, Update.Meshes);
+		Apply(MeshInstances, Update.MeshInstances);
+	}
+
+	if (bShapesTessellated)
+	{
+		TessellateShapes(Shapes, FirstCircle, FirstArc, FirstCylinder, FirstCapsule);
+	}
+	else
+	{
+		TessellateShapes(EStevesDebugShapes::All);
+	}
+}
+
+void FStevesDebugRenderSceneProxy::TessellateShapes(EStevesDebugShapes Shapes)
+{
+	TessellateShapes(Shapes, 0, 0, 0, 0);
+}
+
+void FStevesDebugRenderSceneProxy::TessellateShapes(EStevesDebugShapes Shapes, int32 FirstCircle, int32 FirstArc,
+                                                    int32 FirstCylinder, int32 FirstCapsule)
+{
+	// Axes are normalised, and radii unscaled, to match drawing each shape with a uniform scale
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Circles))
+	{
+		if (FirstCircle == 0)
+		{
+			TessellatedCircles.Reset();
+		}
+		for (const auto& C : MakeArrayView(Circles).RightChop(FirstCircle))
+		{
+			AddTessellatedShape(TessellatedCircles, C.Centre, C.Radius, [&C](FTessellatedLines& Out, int32 LOD)
+			{
+				TessellateCircle(Out, C.Centre, C.X.GetSafeNormal(), C.Y.GetSafeNormal(), C.Color, C.Radius,
+				                 GetLODSegments(C.NumSegments, LOD), C.Thickness);
+			});
+		}
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arcs))
+	{
+		if (FirstArc == 0)
+		{
+			TessellatedArcs.Reset();
+		}
+		for (const auto& C : MakeArrayView(Arcs).RightChop(FirstArc))
+		{
+			AddTessellatedShape(TessellatedArcs, C.Centre, C.Radius, [&C](FTessellatedLines& Out, int32 LOD)
+			{
+				TessellateArc(Out, C.Centre, C.X.GetSafeNormal(), C.Y.GetSafeNormal(), C.MinAngle, C.MaxAngle, C.Radius,
+				              GetLODSegments(C.NumSegments, LOD), C.Color);
+			});
+		}
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Cylinders))
+	{
+		if (FirstCylinder == 0)
+		{
+			TessellatedCylinders.Reset();
+		}
+		for (const auto& C : MakeArrayView(CylindersImproved).RightChop(FirstCylinder))
+		{
+			const float BoundsRadius = FVector2D(C.Radius, C.HalfHeight).Size();
+			AddTessellatedShape(TessellatedCylinders, C.Centre, BoundsRadius, [&C](FTessellatedLines& Out, int32 LOD)
+			{
+				TessellateCylinder(Out, C.Centre, C.X.GetSafeNormal(), C.Y.GetSafeNormal(), C.Z.GetSafeNormal(),
+				                   C.Color, C.Radius, C.HalfHeight, GetLODSegments(C.NumSegments, LOD));
+			});
+		}
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Capsules))
+	{
+		if (FirstCapsule == 0)
+		{
+			TessellatedCapsules.Reset();
+		}
+		for (const auto& C : MakeArrayView(CapsulesImproved).RightChop(FirstCapsule))
+		{
+#if ENGINE_MAJOR_VERSION >= 5
+			const FVector& Centre = C.Base;
+#else
+			const FVector& Centre = C.Location;
+#endif
+			AddTessellatedShape(TessellatedCapsules, Centre, GetCapsuleBoundsRadius(C.Radius, C.HalfHeight),
+			                    [&C, &Centre](FTessellatedLines& Out, int32 LOD)
+			{
+				TessellateCapsule(Out, Centre, C.X.GetSafeNormal(), C.Y.GetSafeNormal(), C.Z.GetSafeNormal(),
+				                  C.Color, C.Radius, C.HalfHeight, GetLODSegments(16, LOD));
+			});
+		}
+	}
+	bShapesTessellated = true;
+
+	// Upload the lines of each depth priority group which changed
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Circles))
+	{
+		BuildLineGeometry(WorldLineGeometry, {&TessellatedCircles});
+	}
+	if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arcs | EStevesDebugShapes::Cylinders | EStevesDebugShapes::Capsules))
+	{
+		BuildLineGeometry(ForegroundLineGeometry, {&TessellatedArcs, &TessellatedCylinders, &TessellatedCapsules});
+	}
+}
+
+void FStevesDebugRenderSceneProxy::BuildLineGeometry(FStevesDebugLineGeometry*& Geometry,
+                                                     std::initializer_list<FTessellatedShapes*> Categories)
+{
+	ReleaseLineGeometry(Geometry);
+
+	// Thick lines are included too, so every line's vertices are at 2 * its index (plus FirstVertex)
+	TArray<FDynamicMeshVertex> Vertices;
+	for (FTessellatedShapes* Tessellated : Categories)
+	{
+		Tessellated->FirstVertex = Vertices.Num();
+		for (const FTessellatedLine& L : Tessellated->Lines)
+		{
+			Vertices.Add(FDynamicMeshVertex(FVector3f(L.Start), FVector2f::ZeroVector, L.Color));
+			Vertices.Add(FDynamicMeshVertex(FVector3f(L.End), FVector2f::ZeroVector, L.Color));
+		}
+	}
+	if (Vertices.Num() == 0)
+	{
+		return;
+	}
+
+	Geometry = new FStevesDebugLineGeometry();
+	Geometry->VertexBuffers.InitFromDynamicVertex(&Geometry->VertexFactory, Vertices);
+	BeginInitResource(&Geometry->VertexBuffers.PositionVertexBuffer);
+	BeginInitResource(&Geometry->VertexBuffers.StaticMeshVertexBuffer);
+	BeginInitResource(&Geometry->VertexBuffers.ColorVertexBuffer);
+	BeginInitResource(&Geometry->VertexFactory);
+}
+
+void FStevesDebugRenderSceneProxy::ReleaseLineGeometry(FStevesDebugLineGeometry*& Geometry)
+{
+	if (!Geometry)
+	{
+		return;
+	}
+
+	// Usually already on the render thread, in which case this runs now
+	FStevesDebugLineGeometry* ToRelease = Geometry;
+	Geometry = nullptr;
+	ENQUEUE_RENDER_COMMAND(ReleaseStevesDebugLineGeometry)(
+		[ToRelease](FRHICommandListImmediate& RHICmdList)
+		{
+			ToRelease->VertexBuffers.PositionVertexBuffer.ReleaseResource();
+			ToRelease->VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+			ToRelease->VertexBuffers.ColorVertexBuffer.ReleaseResource();
+			ToRelease->VertexFactory.ReleaseResource();
+			delete ToRelease;
+		});
+}
+
+int32 FStevesDebugRenderSceneProxy::GetShapeLOD(const FSceneView* View, const FVector& Centre, float Radius) const
+{
+	if (MaxShapeDrawDistance > 0 &&
+		FVector::DistSquared(View->ViewMatrices.GetViewOrigin(), Centre) > FMath::Square(MaxShapeDrawDistance + Radius))
+	{
+		return INDEX_NONE;
+	}
+	if (!View->ViewFrustum.IntersectSphere(Centre, Radius))
+	{
+		return INDEX_NONE;
+	}
+	if (!bReduceShapeDetail)
+	{
+		return 0;
+	}
+
+	const float ScreenSize = ComputeBoundsScreenSize(Centre, Radius, *View);
+	for (int32 LOD = 0; LOD < NumShapeLODs - 1; ++LOD)
+	{
+		if (ScreenSize >= ShapeLODScreenSizes[LOD])
+		{
+			return LOD;
+		}
+	}
+	return NumShapeLODs - 1;
+}
+
 FPrimitiveViewRelevance FStevesDebugRenderSceneProxy::GetViewRelevance(const FSceneView* View) const
 {
 	// More useful defaults than FDebugRenderSceneProxy
@@ -6,7 +6,9 @@
 #include "StaticMeshResources.h"
 #include "Engine/StaticMesh.h"
 #include "StevesDebugRenderSceneProxy.h"
+#include "StevesDebugMeshCache.h"
 #include "DynamicMeshBuilder.h"
+#include "RenderingThread.h"
 
 UStevesEditorVisComponent::UStevesEditorVisComponent(const FObjectInitializer& ObjectInitializer)
 	: UPrimitiveComponent(ObjectInitializer)
@@ -27,118 +29,319 @@ UStevesEditorVisComponent::UStevesEditorVisComponent(const FObjectInitializer& O
 	
 }
 
-FPrimitiveSceneProxy* UStevesEditorVisComponent::CreateSceneProxy()
+namespace
 {
-	auto Ret = new FStevesDebugRenderSceneProxy(this);
-
-	const FTransform& XForm = GetComponentTransform();
-	for (auto& L : Lines)
+	/// Build proxy shapes for the chosen categories, in component local space. If FirstIndex > 0, only the shapes from
+	/// that index on are included, to be appended to the proxy's existing shapes
+	void BuildShapes(const UStevesEditorVisComponent& Comp, EStevesDebugShapes Shapes, FStevesDebugRenderSceneProxy::FShapeUpdate& Out,
+	                 int32 FirstIndex = 0)
 	{
-		Ret->Lines.Add(FDebugRenderSceneProxy::FDebugLine(XForm.TransformPosition(L.Start),
-		                                                  XForm.TransformPosition(L.End), L.Colour));
+		Out.Shapes = Shapes;
+		Out.bAppend = FirstIndex > 0;
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Lines))
+		{
+			for (auto& L : MakeArrayView(Comp.Lines).RightChop(FirstIndex))
+			{
+				Out.Lines.Add(FDebugRenderSceneProxy::FDebugLine(L.Start, L.End, L.Colour));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arrows))
+		{
+			for (auto& A : MakeArrayView(Comp.Arrows).RightChop(FirstIndex))
+			{
+				Out.ArrowLines.Add(FDebugRenderSceneProxy::FArrowLine(A.Start, A.End, A.Colour));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Circles))
+		{
+			for (auto& C : MakeArrayView(Comp.Circles).RightChop(FirstIndex))
+			{
+				const FQuat Rot = C.Rotation.Quaternion();
+				Out.Circles.Add(FStevesDebugRenderSceneProxy::FDebugCircle(
+					C.Location,
+					Rot.GetForwardVector(), Rot.GetRightVector(),
+					C.Radius,
+					C.NumSegments, C.Colour
+					));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Arcs))
+		{
+			for (auto& Arc : MakeArrayView(Comp.Arcs).RightChop(FirstIndex))
+			{
+				const FQuat Rot = Arc.Rotation.Quaternion();
+				Out.Arcs.Add(FStevesDebugRenderSceneProxy::FDebugArc(
+					Arc.Location,
+					Rot.GetForwardVector(), Rot.GetRightVector(),
+					Arc.MinAngle, Arc.MaxAngle,
+					Arc.Radius,
+					Arc.NumSegments, Arc.Colour
+					));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Spheres))
+		{
+			for (auto& S : MakeArrayView(Comp.Spheres).RightChop(FirstIndex))
+			{
+				Out.Spheres.Add(FStevesDebugRenderSceneProxy::FSphere(S.Radius, S.Location, S.Colour));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Boxes))
+		{
+			for (auto& Box : MakeArrayView(Comp.Boxes).RightChop(FirstIndex))
+			{
+				FVector HalfSize = Box.Size * 0.5f;
+				FBox DBox(-HalfSize, HalfSize);
+				Out.Boxes.Add(FStevesDebugRenderSceneProxy::FDebugBox(
+					DBox, Box.Colour, FTransform(Box.Rotation, Box.Location)));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Cylinders))
+		{
+			for (auto& Cylinder : MakeArrayView(Comp.Cylinders).RightChop(FirstIndex))
+			{
+				const FQuat Rot = Cylinder.Rotation.Quaternion();
+				Out.Cylinders.Add(FStevesDebugRenderSceneProxy::FDebugCylinder(
+					Cylinder.Location, Rot.GetForwardVector(), Rot.GetRightVector(), Rot.GetUpVector(),
+					Cylinder.Radius, Cylinder.Height * 0.5f, 16, Cylinder.Colour));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Capsules))
+		{
+			for (auto& Capsule : MakeArrayView(Comp.Capsules).RightChop(FirstIndex))
+			{
+				const FQuat Rot = Capsule.Rotation.Quaternion();
+				Out.Capsules.Add(FStevesDebugRenderSceneProxy::FCapsule(
+					Capsule.Location, Capsule.Radius,
+					Rot.GetForwardVector(), Rot.GetRightVector(), Rot.GetUpVector(),
+					Capsule.Height * 0.5f, Capsule.Colour));
+			}
+		}
+		if (EnumHasAnyFlags(Shapes, EStevesDebugShapes::Meshes))
+		{
+			for (auto& Mesh : MakeArrayView(Comp.Meshes).RightChop(FirstIndex))
+			{
+				if (IsValid(Mesh.Mesh))
+				{
+					// Geometry is shared with every other vis component using the same mesh & LOD
+					const int32 LODIndex = Mesh.bUseLowestLOD ? Mesh.Mesh->GetNumLODs() - 1 : 0;
+					if (auto Geometry = FStevesDebugMeshCache::Get().FindOrAdd(Mesh.Mesh, LODIndex))
+					{
+						const FTransform MeshXForm = FTransform(Mesh.Rotation, Mesh.Location, Mesh.Scale);
+						Out.MeshInstances.Add(FStevesDebugRenderSceneProxy::FDebugMeshInstance(MeshXForm.ToMatrixWithScale(), Geometry, Mesh.Colour));
+					}
+				}
+			}
+		}
 	}
-	for (auto& A : Arrows)
+
+	// Bounds of each shape in component local space
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisLine& L)
 	{
-		Ret->ArrowLines.Add(FDebugRenderSceneProxy::FArrowLine(XForm.TransformPosition(A.Start),
-														XForm.TransformPosition(A.End), A.Colour));
+		// Re-centre the origin of the line to make box extents 
+		FVector Extents = L.Start.GetAbs().ComponentMax(L.End.GetAbs());
+		return FBoxSphereBounds(FVector::ZeroVector, Extents, Extents.GetMax());
 	}
-	for (auto& C : Circles)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisCircle& C)
 	{
-		FQuat WorldRot = XForm.TransformRotation(C.Rotation.Quaternion());
-		Ret->Circles.Add(FStevesDebugRenderSceneProxy::FDebugCircle(
-			XForm.TransformPosition(C.Location),
-			WorldRot.GetForwardVector(), WorldRot.GetRightVector(),
-			XForm.GetMaximumAxisScale() * C.Radius,
-			C.NumSegments, C.Colour
-			));
+		return FBoxSphereBounds(C.Location, FVector(C.Radius), C.Radius);
 	}
-	for (auto& Arc : Arcs)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisArc& Arc)
 	{
-		FQuat WorldRot = XForm.TransformRotation(Arc.Rotation.Quaternion());
-		Ret->Arcs.Add(FStevesDebugRenderSceneProxy::FDebugArc(
-			XForm.TransformPosition(Arc.Location),
-			WorldRot.GetForwardVector(), WorldRot.GetRightVector(),
-			Arc.MinAngle, Arc.MaxAngle,
-			XForm.GetMaximumAxisScale() * Arc.Radius,
-			Arc.NumSegments, Arc.Colour
-			));
+		// Just use the entire circle for simplicity
+		return FBoxSphereBounds(Arc.Location, FVector(Arc.Radius), Arc.Radius);
 	}
-	for (auto& S : Spheres)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisSphere& S)
 	{
-		Ret->Spheres.Add(FStevesDebugRenderSceneProxy::FSphere(
-			XForm.GetMaximumAxisScale() * S.Radius,
-			XForm.TransformPosition(S.Location),
-			S.Colour
-			));
+		return FBoxSphereBounds(S.Location, FVector(S.Radius), S.Radius);
 	}
-	for (auto& Box : Boxes)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisBox& Box)
 	{
 		FVector HalfSize = Box.Size * 0.5f;
 		FBox DBox(-HalfSize, HalfSize);
-		// Apply local rotation first then parent transform
-		FTransform CombinedXForm = FTransform(Box.Rotation, Box.Location) * XForm;
-		Ret->Boxes.Add(FStevesDebugRenderSceneProxy::FDebugBox(
-			DBox, Box.Colour, CombinedXForm));
+		// Apply local rotation only, world is done later
+		FTransform BoxXForm = FTransform(Box.Rotation, Box.Location);
+		DBox = DBox.TransformBy(BoxXForm);
+		return FBoxSphereBounds(DBox);
 	}
-	for (auto& Cylinder : Cylinders)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisCylinder& Cylinder)
 	{
-		// Apply local rotation first then parent transform
-		const FTransform CombinedXForm = FTransform(Cylinder.Rotation, Cylinder.Location) * XForm;
-		const float HalfH = Cylinder.Height * 0.5f * CombinedXForm.GetScale3D().Z;
-		const float R = Cylinder.Radius * CombinedXForm.GetScale3D().Z;
-		const FVector Centre = CombinedXForm.TransformPosition(FVector::ZeroVector);
-		const FVector LocalX = CombinedXForm.TransformVectorNoScale(FVector::ForwardVector);
-		const FVector LocalY = CombinedXForm.TransformVectorNoScale(FVector::RightVector);
-		const FVector LocalZ = CombinedXForm.TransformVectorNoScale(FVector::UpVector);
-		Ret->CylindersImproved.Add(FStevesDebugRenderSceneProxy::FDebugCylinder(
-			Centre, LocalX, LocalY, LocalZ, R, HalfH, 16, Cylinder.Colour));
+		FVector HalfSize = FVector(Cylinder.Radius, Cylinder.Radius, Cylinder.Height * 0.5f);
+		FBox DBox(-HalfSize, HalfSize);
+		// Apply local rotation only, world is done later
+		FTransform XForm = FTransform(Cylinder.Rotation, Cylinder.Location);
+		DBox = DBox.TransformBy(XForm);
+		return FBoxSphereBounds(DBox);
 	}
-	for (auto& Capsule : Capsules)
+
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisCapsule& Capsule)
 	{
-		// Apply local rotation first then parent transform
-		const FTransform CombinedXForm = FTransform(Capsule.Rotation, Capsule.Location) * XForm;
-		const float HalfH = Capsule.Height * 0.5f * CombinedXForm.GetScale3D().Z;
-		const float R = Capsule.Radius * CombinedXForm.GetScale3D().Z;
-		const FVector Position = CombinedXForm.TransformPosition(FVector::ZeroVector);
-		const FVector LocalX = CombinedXForm.TransformVectorNoScale(FVector::ForwardVector);
-		const FVector LocalY = CombinedXForm.TransformVectorNoScale(FVector::RightVector);
-		const FVector LocalZ = CombinedXForm.TransformVectorNoScale(FVector::UpVector);
-		Ret->CapsulesImproved.Add(FStevesDebugRenderSceneProxy::FCapsule(
-			Position, R,
-			LocalX, LocalY, LocalZ,
-			HalfH, Capsule.Colour));
+		FVector HalfSize = FVector(Capsule.Radius, Capsule.Radius, Capsule.Height * 0.5f + Capsule.Radius * 2.f);
+		FBox DBox(-HalfSize, HalfSize);
+		// Apply local rotation only, world is done later
+		FTransform XForm = FTransform(Capsule.Rotation, Capsule.Location);
+		DBox = DBox.TransformBy(XForm);
+		return FBoxSphereBounds(DBox);
 	}
-	for (auto& Mesh : Meshes)
+
+	/// Mesh must be valid
+	FBoxSphereBounds GetShapeLocalBounds(const FStevesEditorVisMesh& Mesh)
 	{
-		// Apply local rotation first then parent transform
-		if (IsValid(Mesh.Mesh))
-		{
-			const FTransform CombinedXForm = FTransform(Mesh.Rotation, Mesh.Location, Mesh.Scale) * XForm;
-			const FStaticMeshLODResources& Lod = Mesh.Mesh->GetLODForExport(Mesh.bUseLowestLOD ? Mesh.Mesh->GetNumLODs() - 1 : 0);
-			TArray<FDynamicMeshVertex> Vertices;
-			TArray<uint32> Indices;
-
-			Lod.IndexBuffer.GetCopy(Indices);
-			auto& PosBuffer = Lod.VertexBuffers.PositionVertexBuffer;
-			uint32 NumVerts = PosBuffer.GetNumVertices();
-			Vertices.Reserve(NumVerts);
-			for (uint32 i = 0; i < NumVerts; ++i)
-			{
-				Vertices.Add(FDynamicMeshVertex(PosBuffer.VertexPosition(i)));
-			}
-			
-			Ret->MeshesImproved.Add(FStevesDebugRenderSceneProxy::FDebugMesh(CombinedXForm.ToMatrixWithScale(), Vertices, Indices, Mesh.Colour));
-			
-		}
-		
-		
+		const FTransform XForm = FTransform(Mesh.Rotation, Mesh.Location, Mesh.Scale);
+		return Mesh.Mesh->GetBounds().TransformBy(XForm);
 	}
+}
+
+FPrimitiveSceneProxy* UStevesEditorVisComponent::CreateSceneProxy()
+{
+	auto Ret = new FStevesDebugRenderSceneProxy(this);
+	// Shapes stay in local space, so moving the component doesn't need a new proxy
+	Ret->bShapesInLocalSpace = true;
+	Ret->MaxShapeDrawDistance = MaxShapeDrawDistance;
+	Ret->bReduceShapeDetail = bReduceShapeDetail;
+
+	FStevesDebugRenderSceneProxy::FShapeUpdate Shapes;
+	BuildShapes(*this, EStevesDebugShapes::All, Shapes);
+	Ret->ApplyShapeUpdate(MoveTemp(Shapes));
 
 	return Ret;
 	
 }
 
+void UStevesEditorVisComponent::UpdateShapes(EStevesDebugShapes Shapes)
+{
+	// We don't know what changed, so bounds need recalculating
+	bLocalBoundsValid = false;
+	SendShapes(Shapes);
+}
+
+void UStevesEditorVisComponent::SendShapes(EStevesDebugShapes Shapes, int32 FirstNewIndex)
+{
+	// Bounds may have changed; this sends them to the existing proxy without re-creating it
+	UpdateBounds();
+	MarkRenderTransformDirty();
+
+	if (SceneProxy && Shapes != EStevesDebugShapes::None)
+	{
+		FStevesDebugRenderSceneProxy::FShapeUpdate Update;
+		BuildShapes(*this, Shapes, Update, FirstNewIndex);
+		FStevesDebugRenderSceneProxy* Proxy = static_cast<FStevesDebugRenderSceneProxy*>(SceneProxy);
+		ENQUEUE_RENDER_COMMAND(UpdateStevesEditorVisShapes)(
+			[Proxy, Update = MoveTemp(Update)](FRHICommandListImmediate& RHICmdList) mutable
+			{
+				Proxy->ApplyShapeUpdate(MoveTemp(Update));
+			});
+	}
+}
+
+void UStevesEditorVisComponent::MarkShapesChanged()
+{
+	UpdateShapes(EStevesDebugShapes::All);
+}
+
+void UStevesEditorVisComponent::ShapeAdded(const FBoxSphereBounds& ShapeBounds, EStevesDebugShapes Shapes, int32 Index)
+{
+	// Sphere radius of a union depends on the order shapes are added, so this can differ from recalculating all
+	// shapes category by category. It's still conservative, i.e. contains every shape
+	if (bLocalBoundsValid)
+	{
+		CachedLocalBounds = CachedLocalBounds + ShapeBounds;
+	}
+	// Only send the new shape to the proxy, so adding lots of shapes one by one doesn't re-send everything each time
+	SendShapes(Shapes, Index);
+}
+
+void UStevesEditorVisComponent::AddLine(const FStevesEditorVisLine& Line)
+{
+	Lines.Add(Line);
+	ShapeAdded(GetShapeLocalBounds(Line), EStevesDebugShapes::Lines, Lines.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddArrow(const FStevesEditorVisLine& Arrow)
+{
+	Arrows.Add(Arrow);
+	ShapeAdded(GetShapeLocalBounds(Arrow), EStevesDebugShapes::Arrows, Arrows.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddCircle(const FStevesEditorVisCircle& Circle)
+{
+	Circles.Add(Circle);
+	ShapeAdded(GetShapeLocalBounds(Circle), EStevesDebugShapes::Circles, Circles.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddArc(const FStevesEditorVisArc& Arc)
+{
+	Arcs.Add(Arc);
+	ShapeAdded(GetShapeLocalBounds(Arc), EStevesDebugShapes::Arcs, Arcs.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddSphere(const FStevesEditorVisSphere& Sphere)
+{
+	Spheres.Add(Sphere);
+	ShapeAdded(GetShapeLocalBounds(Sphere), EStevesDebugShapes::Spheres, Spheres.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddBox(const FStevesEditorVisBox& Box)
+{
+	Boxes.Add(Box);
+	ShapeAdded(GetShapeLocalBounds(Box), EStevesDebugShapes::Boxes, Boxes.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddCylinder(const FStevesEditorVisCylinder& Cylinder)
+{
+	Cylinders.Add(Cylinder);
+	ShapeAdded(GetShapeLocalBounds(Cylinder), EStevesDebugShapes::Cylinders, Cylinders.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddCapsule(const FStevesEditorVisCapsule& Capsule)
+{
+	Capsules.Add(Capsule);
+	ShapeAdded(GetShapeLocalBounds(Capsule), EStevesDebugShapes::Capsules, Capsules.Num() - 1);
+}
+
+void UStevesEditorVisComponent::AddMesh(const FStevesEditorVisMesh& Mesh)
+{
+	Meshes.Add(Mesh);
+	if (IsValid(Mesh.Mesh))
+	{
+		ShapeAdded(GetShapeLocalBounds(Mesh), EStevesDebugShapes::Meshes, Meshes.Num() - 1);
+	}
+}
+
+#if WITH_EDITOR
+void UStevesEditorVisComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	bLocalBoundsValid = false;
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+}
+#endif
+
+void UStevesEditorVisComponent::CreateRenderState_Concurrent(FRegisterComponentContext* Context)
+{
+	// Registration (including re-registration after Blueprint / editor changes) is when arrays may have been changed
+	// without telling us, so recalculate bounds then; the superclass updates bounds before creating the proxy
+	bLocalBoundsValid = false;
+	Super::CreateRenderState_Concurrent(Context);
+}
+
 FBoxSphereBounds UStevesEditorVisComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	// Called on every move, so only walk the shapes when they've changed
+	if (!bLocalBoundsValid)
+	{
+		CachedLocalBounds = CalcLocalBounds();
+		bLocalBoundsValid = true;
+	}
+	return CachedLocalBounds.TransformBy(LocalToWorld);
+}
+
+FBoxSphereBounds UStevesEditorVisComponent::CalcLocalBounds() const
 {
 	// Get superclass bounds in LOCAL space (don't pass LocalToWorld)
 	FBoxSphereBounds B = Super::CalcBounds(FTransform::Identity);
@@ -146,65 +349,44 @@ FBoxSphereBounds UStevesEditorVisComponent::CalcBounds(const FTransform& LocalTo
 	// Now we need to merge in all components
 	for (auto& L : Lines)
 	{
-		// Re-centre the origin of the line to make box extents 
-		FVector Extents = L.Start.GetAbs().ComponentMax(L.End.GetAbs());
-		B = B + FBoxSphereBounds(FVector::ZeroVector, Extents, Extents.GetMax());
+		B = B + GetShapeLocalBounds(L);
 	}
 	for (auto& A : Arrows)
 	{
-		// Re-centre the origin of the line to make box extents 
-		FVector Extents = A.Start.GetAbs().ComponentMax(A.End.GetAbs());
-		B = B + FBoxSphereBounds(FVector::ZeroVector, Extents, Extents.GetMax());
+		B = B + GetShapeLocalBounds(A);
 	}
 	for (auto& C : Circles)
 	{
-		B = B + FBoxSphereBounds(C.Location, FVector(C.Radius), C.Radius);
+		B = B + GetShapeLocalBounds(C);
 	}
 	for (auto& Arc : Arcs)
 	{
-		// Just use the entire circle for simplicity
-		B = B + FBoxSphereBounds(Arc.Location, FVector(Arc.Radius), Arc.Radius);
+		B = B + GetShapeLocalBounds(Arc);
 	}
 	for (auto& S : Spheres)
 	{
-		B = B + FBoxSphereBounds(S.Location, FVector(S.Radius), S.Radius);
+		B = B + GetShapeLocalBounds(S);
 	}
 	for (auto& Box : Boxes)
 	{
-		FVector HalfSize = Box.Size * 0.5f;
-		FBox DBox(-HalfSize, HalfSize);
-		// Apply local rotation only, world is done later
-		FTransform BoxXForm = FTransform(Box.Rotation, Box.Location);
-		DBox = DBox.TransformBy(BoxXForm);
-		B = B + FBoxSphereBounds(DBox);
+		B = B + GetShapeLocalBounds(Box);
 	}
 	for (auto& Cylinder : Cylinders)
 	{
-		FVector HalfSize = FVector(Cylinder.Radius, Cylinder.Radius, Cylinder.Height * 0.5f);
-		FBox DBox(-HalfSize, HalfSize);
-		// Apply local rotation only, world is done later
-		FTransform XForm = FTransform(Cylinder.Rotation, Cylinder.Location);
-		DBox = DBox.TransformBy(XForm);
-		B = B + FBoxSphereBounds(DBox);
+		B = B + GetShapeLocalBounds(Cylinder);
 	}
 	for (auto& Capsule : Capsules)
 	{
-		FVector HalfSize = FVector(Capsule.Radius, Capsule.Radius, Capsule.Height * 0.5f + Capsule.Radius * 2.f);
-		FBox DBox(-HalfSize, HalfSize);
-		// Apply local rotation only, world is done later
-		FTransform XForm = FTransform(Capsule.Rotation, Capsule.Location);
-		DBox = DBox.TransformBy(XForm);
-		B = B + FBoxSphereBounds(DBox);
+		B = B + GetShapeLocalBounds(Capsule);
 	}
 	for (auto& Mesh : Meshes)
 	{
 		if (IsValid(Mesh.Mesh))
 		{
-			const FTransform XForm = FTransform(Mesh.Rotation, Mesh.Location, Mesh.Scale);
-			B = B + Mesh.Mesh->GetBounds().TransformBy(XForm);
+			B = B + GetShapeLocalBounds(Mesh);
 		}
 		
 	}
-	return B.TransformBy(LocalToWorld);
+	return B;
 }
 
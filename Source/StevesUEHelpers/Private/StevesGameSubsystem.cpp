@@ -492,6 +492,12 @@ FStevesTextureRenderTargetPoolPtr UStevesGameSubsystem::GetTextureRenderTargetPo
     {
         FStevesTextureRenderTargetPoolPtr Pool = MakeShared<FStevesTextureRenderTargetPool>(Name, this);
         TextureRenderTargetPools.Add(Pool);
+
+        // Check pools for idle unreserved textures every second
+        if (!RenderTargetPoolEvictHandle.IsValid())
+        {
+            GetWorld()->GetTimerManager().SetTimer(RenderTargetPoolEvictHandle, this, &UStevesGameSubsystem::EvictIdleRenderTargets, 1.0f, true);
+        }
         return Pool;
     }
 
@@ -499,6 +505,14 @@ FStevesTextureRenderTargetPoolPtr UStevesGameSubsystem::GetTextureRenderTargetPo
     
 }
 
+void UStevesGameSubsystem::EvictIdleRenderTargets()
+{
+    for (auto Pool : TextureRenderTargetPools)
+    {
+        Pool->EvictIdleTextures();
+    }
+}
+
 
 bool UStevesGameSubsystem::FInputModeDetector::ShouldProcessInputEvents() const
 {
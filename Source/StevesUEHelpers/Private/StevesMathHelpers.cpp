@@ -7,6 +7,186 @@
 #include "PhysicsEngine/ConvexElem.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "Chaos/ChaosEngineInterface.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/// Spheres per ParallelFor chunk in SphereOverlapConeBatch, a multiple of 32 so chunks own whole mask words
+	constexpr int32 SphereConeChunkSize = 4096;
+
+	/// Cone values splatted into vector registers, relative to the cone origin
+	struct FSphereConeConstants
+	{
+		VectorRegister4Float OriginX, OriginY, OriginZ;
+		VectorRegister4Float DirX, DirY, DirZ;
+		VectorRegister4Float Distance, Sin, InvSin, CosSq, HeightTan;
+		VectorRegister4Float Zero, Two;
+
+		explicit FSphereConeConstants(const FStevesPreparedCone& Cone)
+		{
+			OriginX = VectorSetFloat1(Cone.Origin.X);
+			OriginY = VectorSetFloat1(Cone.Origin.Y);
+			OriginZ = VectorSetFloat1(Cone.Origin.Z);
+			DirX = VectorSetFloat1(Cone.Dir.X);
+			DirY = VectorSetFloat1(Cone.Dir.Y);
+			DirZ = VectorSetFloat1(Cone.Dir.Z);
+			Distance = VectorSetFloat1(Cone.Distance);
+			Sin = VectorSetFloat1(Cone.SinHalfAngle);
+			InvSin = VectorSetFloat1(Cone.InvSinHalfAngle);
+			CosSq = VectorSetFloat1(Cone.CosHalfAngleSq);
+			HeightTan = VectorSetFloat1(Cone.Distance * Cone.TanHalfAngle);
+			Zero = VectorZeroFloat();
+			Two = VectorSetFloat1(2.f);
+		}
+	};
+
+	/**
+	 * Branchless version of StevesMathHelpers::SphereOverlapCone for 4 spheres. Everything is expressed relative to
+	 * the cone origin (V), using |CmU|^2 = |CmV|^2 + 2k(A.CmV) + k^2 where k = r / sin, and |A x barD| as the
+	 * perpendicular distance from the axis.
+	 * @return Mask of which spheres overlap, in the low 4 bits
+	 */
+	FORCEINLINE int32 SphereOverlapCone4(const FSphereConeConstants& C, const float* X, const float* Y, const float* Z, const float* R)
+	{
+		const VectorRegister4Float CmVX = VectorSubtract(VectorLoad(X), C.OriginX);
+		const VectorRegister4Float CmVY = VectorSubtract(VectorLoad(Y), C.OriginY);
+		const VectorRegister4Float CmVZ = VectorSubtract(VectorLoad(Z), C.OriginZ);
+		const VectorRegister4Float Radius = VectorLoad(R);
+
+		const VectorRegister4Float AdCmV = VectorMultiplyAdd(C.DirZ, CmVZ, VectorMultiplyAdd(C.DirY, CmVY, VectorMultiply(C.DirX, CmVX)));
+		const VectorRegister4Float SqrLengthCmV = VectorMultiplyAdd(CmVZ, CmVZ, VectorMultiplyAdd(CmVY, CmVY, VectorMultiply(CmVX, CmVX)));
+		const VectorRegister4Float RadiusSq = VectorMultiply(Radius, Radius);
+
+		// Inside the infinite cone expanded by the radius, with the apex moved back
+		const VectorRegister4Float K = VectorMultiply(Radius, C.InvSin);
+		const VectorRegister4Float AdCmU = VectorAdd(AdCmV, K);
+		const VectorRegister4Float SqrLengthCmU = VectorMultiplyAdd(K, K, VectorMultiplyAdd(VectorMultiply(C.Two, K), AdCmV, SqrLengthCmV));
+		VectorRegister4Float Result = VectorBitwiseAnd(
+			VectorCompareGT(AdCmU, C.Zero),
+			VectorCompareGE(VectorMultiply(AdCmU, AdCmU), VectorMultiply(SqrLengthCmU, C.CosSq)));
+
+		// Within the slab between the apex and the end cap, expanded by the radius
+		Result = VectorBitwiseAnd(Result, VectorCompareGE(AdCmV, VectorNegate(Radius)));
+		Result = VectorBitwiseAnd(Result, VectorCompareLE(AdCmV, VectorAdd(C.Distance, Radius)));
+
+		const VectorRegister4Float RSin = VectorMultiply(Radius, C.Sin);
+		// Behind the apex, nearest feature is the apex itself
+		const VectorRegister4Float BehindApex = VectorCompareLT(AdCmV, VectorNegate(RSin));
+		const VectorRegister4Float ApexResult = VectorCompareLE(SqrLengthCmV, RadiusSq);
+		// Beyond the end cap, test against the cap disc rim
+		const VectorRegister4Float BeyondCap = VectorCompareGT(AdCmV, VectorSubtract(C.Distance, RSin));
+		const VectorRegister4Float Perp = VectorSqrt(VectorMax(C.Zero, VectorSubtract(SqrLengthCmV, VectorMultiply(AdCmV, AdCmV))));
+		const VectorRegister4Float AdBarD = VectorSubtract(AdCmV, C.Distance);
+		const VectorRegister4Float Diff = VectorSubtract(Perp, C.HeightTan);
+		const VectorRegister4Float CapResult = VectorBitwiseOr(
+			VectorCompareLE(Perp, C.HeightTan),
+			VectorCompareLE(VectorMultiplyAdd(AdBarD, AdBarD, VectorMultiply(Diff, Diff)), RadiusSq));
+
+		// In between the two, it's a hit
+		const VectorRegister4Float AllBits = VectorCompareEQ(C.Zero, C.Zero);
+		const VectorRegister4Float Feature = VectorSelect(BehindApex, ApexResult, VectorSelect(BeyondCap, CapResult, AllBits));
+		Result = VectorBitwiseAnd(Result, Feature);
+
+		return VectorMaskBits(Result);
+	}
+
+	/// Test spheres [Start, End) and write their mask bits, Start must be a multiple of 32
+	int32 SphereOverlapConeRange(const FSphereConeConstants& Constants,
+	                             const float* X,
+	                             const float* Y,
+	                             const float* Z,
+	                             const float* R,
+	                             int32 Start,
+	                             int32 End,
+	                             uint32* OutMask)
+	{
+		int32 Count = 0;
+		for (int32 WordStart = Start; WordStart < End; WordStart += 32)
+		{
+			const int32 WordEnd = FMath::Min(WordStart + 32, End);
+			uint32 Word = 0;
+			int32 i = WordStart;
+			for (; i + 4 <= WordEnd; i += 4)
+			{
+				Word |= (uint32)SphereOverlapCone4(Constants, X + i, Y + i, Z + i, R + i) << (i - WordStart);
+			}
+			if (i < WordEnd)
+			{
+				// Pad the tail out to a full vector
+				float TX[4] = {}, TY[4] = {}, TZ[4] = {}, TR[4] = {};
+				const int32 Remaining = WordEnd - i;
+				for (int32 j = 0; j < Remaining; ++j)
+				{
+					TX[j] = X[i + j];
+					TY[j] = Y[i + j];
+					TZ[j] = Z[i + j];
+					TR[j] = R[i + j];
+				}
+				const uint32 TailBits = SphereOverlapCone4(Constants, TX, TY, TZ, TR) & ((1u << Remaining) - 1);
+				Word |= TailBits << (i - WordStart);
+			}
+			OutMask[WordStart / 32] = Word;
+			Count += FMath::CountBits(Word);
+		}
+		return Count;
+	}
+}
+
+int32 StevesMathHelpers::SphereOverlapConeBatch(const FStevesPreparedCone& Cone,
+                                                TConstArrayView<float> CentresX,
+                                                TConstArrayView<float> CentresY,
+                                                TConstArrayView<float> CentresZ,
+                                                TConstArrayView<float> Radii,
+                                                TArray<uint32>& OutMask)
+{
+	const int32 Num = CentresX.Num();
+	check(CentresY.Num() == Num && CentresZ.Num() == Num && Radii.Num() == Num);
+
+	OutMask.SetNumUninitialized(FMath::DivideAndRoundUp(Num, 32));
+	const FSphereConeConstants Constants(Cone);
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(Num, SphereConeChunkSize);
+	if (NumChunks <= 1)
+	{
+		return SphereOverlapConeRange(Constants, CentresX.GetData(), CentresY.GetData(), CentresZ.GetData(), Radii.GetData(), 0, Num, OutMask.GetData());
+	}
+
+	TArray<int32> ChunkCounts;
+	ChunkCounts.SetNumZeroed(NumChunks);
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		const int32 Start = Chunk * SphereConeChunkSize;
+		const int32 End = FMath::Min(Start + SphereConeChunkSize, Num);
+		ChunkCounts[Chunk] = SphereOverlapConeRange(Constants, CentresX.GetData(), CentresY.GetData(), CentresZ.GetData(), Radii.GetData(), Start, End, OutMask.GetData());
+	});
+
+	int32 Count = 0;
+	for (const int32 ChunkCount : ChunkCounts)
+	{
+		Count += ChunkCount;
+	}
+	return Count;
+}
+
+int32 StevesMathHelpers::SphereOverlapConeBatch(const FStevesPreparedCone& Cone,
+                                                TConstArrayView<float> CentresX,
+                                                TConstArrayView<float> CentresY,
+                                                TConstArrayView<float> CentresZ,
+                                                TConstArrayView<float> Radii,
+                                                TArray<int32>& OutIndices)
+{
+	TArray<uint32> Mask;
+	const int32 Count = SphereOverlapConeBatch(Cone, CentresX, CentresY, CentresZ, Radii, Mask);
+	OutIndices.Reserve(OutIndices.Num() + Count);
+	for (int32 WordIndex = 0; WordIndex < Mask.Num(); ++WordIndex)
+	{
+		for (uint32 Word = Mask[WordIndex]; Word; Word &= Word - 1)
+		{
+			OutIndices.Add(WordIndex * 32 + FMath::CountTrailingZeros(Word));
+		}
+	}
+	return Count;
+}
 
 
 bool StevesMathHelpers::OverlapConvex(const FKConvexElem& Convex,
@@ -126,127 +306,496 @@ float StevesMathHelpers::GetDistanceToConvex2D(const TArray<FVector2f>& ConvexPo
 	return bInside ? -ClosestInside : ClosestOutside;		
 }
 
-int StevesMathHelpers::Fill2DRegionWithRectangles(int StartX,
-	int StartY,
-	int Width,
-	int Height,
-	std::function<bool(int, int)> CellIncludeFunc,
-	TArray<FIntRect>& OutRects)
+FStevesPreparedConvex2D::FStevesPreparedConvex2D(TConstArrayView<FVector2f> ConvexPoints)
+{
+	Initialize(ConvexPoints);
+}
+
+void FStevesPreparedConvex2D::Initialize(TConstArrayView<FVector2f> ConvexPoints)
+{
+	const int N = ConvexPoints.Num();
+	StartX.SetNumUninitialized(N);
+	StartY.SetNumUninitialized(N);
+	LineX.SetNumUninitialized(N);
+	LineY.SetNumUninitialized(N);
+	InvLengthSq.SetNumUninitialized(N);
+	Bounds = FBox2f(ForceInit);
+	for (int i = 0; i < N; ++i)
+	{
+		const FVector2f& Start = ConvexPoints[i];
+		const FVector2f& End = ConvexPoints[i + 1 < N ? i + 1 : 0];
+		const FVector2f Line = End - Start;
+		const float LengthSq = Line.SquaredLength();
+		StartX[i] = Start.X;
+		StartY[i] = Start.Y;
+		LineX[i] = Line.X;
+		LineY[i] = Line.Y;
+		// Degenerate edges become a point at the start
+		InvLengthSq[i] = LengthSq > 0 ? 1.f / LengthSq : 0.f;
+		Bounds += Start;
+	}
+}
+
+float FStevesPreparedConvex2D::GetDistance(const FVector2f& LocalPoint) const
 {
-	int RectCount = 0;
+	// Assume inside until 1 or more tests show it's outside
+	bool bInside = true;
+	float ClosestOutside = 1e30f;
+	float ClosestInside = 1e30f;
+	const int N = StartX.Num();
+	for (int i = 0; i < N; ++i)
+	{
+		const float ToX = LocalPoint.X - StartX[i];
+		const float ToY = LocalPoint.Y - StartY[i];
+		// Dot with the non unit length normal (-Line.Y, Line.X), >0 is outside
+		const float DotNormal = LineX[i] * ToY - LineY[i] * ToX;
+		// Closest point on the segment
+		const float T = FMath::Clamp((LineX[i] * ToX + LineY[i] * ToY) * InvLengthSq[i], 0.f, 1.f);
+		const float DX = ToX - T * LineX[i];
+		const float DY = ToY - T * LineY[i];
+		const float Dist = FMath::Sqrt(DX * DX + DY * DY);
+		if (DotNormal > 0)
+		{
+			bInside = false;
+			ClosestOutside = FMath::Min(ClosestOutside, Dist);
+		}
+		else
+		{
+			ClosestInside = FMath::Min(ClosestInside, Dist);
+		}
+	}
 
-	const int Len = Width*Height;
-	TArray<bool> bDoneMarkers;
-	bDoneMarkers.SetNumUninitialized(Len);
-	int CellsTodo = 0;
+	return bInside ? -ClosestInside : ClosestOutside;
+}
 
-	int StartN = 0;
-	const int EndX = StartX + Width - 1;
-	const int EndY = StartY + Height - 1;
-	// Initialise done markers based on func
-	for (int y = 0; y < Height; ++y)
+void FStevesPreparedConvex2D::GetDistances(TConstArrayView<FVector2f> LocalPoints,
+	TArrayView<float> OutDistances,
+	float MaxDistance) const
+{
+	const int32 Num = LocalPoints.Num();
+	check(OutDistances.Num() == Num);
+
+	const int32 NumEdges = StartX.Num();
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float One = VectorOneFloat();
+	const VectorRegister4Float Big = VectorSetFloat1(1e30f);
+	const VectorRegister4Float MaxDist = VectorSetFloat1(MaxDistance);
+	const VectorRegister4Float MinX = VectorSetFloat1(Bounds.Min.X);
+	const VectorRegister4Float MinY = VectorSetFloat1(Bounds.Min.Y);
+	const VectorRegister4Float MaxX = VectorSetFloat1(Bounds.Max.X);
+	const VectorRegister4Float MaxY = VectorSetFloat1(Bounds.Max.Y);
+
+	int32 i = 0;
+	for (; i + 4 <= Num; i += 4)
 	{
-		for (int x = 0; x < Width; ++x)
+		// De-interleave 4 points into X and Y registers
+		const float* P = reinterpret_cast<const float*>(LocalPoints.GetData() + i);
+		const VectorRegister4Float A = VectorLoad(P);
+		const VectorRegister4Float B = VectorLoad(P + 4);
+		const VectorRegister4Float X = VectorShuffle(A, B, 0, 2, 0, 2);
+		const VectorRegister4Float Y = VectorShuffle(A, B, 1, 3, 1, 3);
+
+		// Early out if all 4 are too far from the bounds
+		const VectorRegister4Float BoxDX = VectorMax(VectorMax(VectorSubtract(MinX, X), VectorSubtract(X, MaxX)), Zero);
+		const VectorRegister4Float BoxDY = VectorMax(VectorMax(VectorSubtract(MinY, Y), VectorSubtract(Y, MaxY)), Zero);
+		const VectorRegister4Float BoxDist = VectorSqrt(VectorMultiplyAdd(BoxDX, BoxDX, VectorMultiply(BoxDY, BoxDY)));
+		if (VectorMaskBits(VectorCompareGT(BoxDist, MaxDist)) == 0xF)
 		{
-			const bool Include = CellIncludeFunc(x+StartX, y+StartY);
-			bDoneMarkers[y*Width + x] = !Include;
-			if (Include)
-			{
-				if (++CellsTodo == 1)
-				{
-					// This is the one we'll start with, might as well calculate it while we're here
-					StartN = y*Width + x;
-				}
-			}
-		}		
+			VectorStore(BoxDist, OutDistances.GetData() + i);
+			continue;
+		}
+
+		VectorRegister4Float Outside = Zero;
+		VectorRegister4Float ClosestOutside = Big;
+		VectorRegister4Float ClosestInside = Big;
+		for (int32 e = 0; e < NumEdges; ++e)
+		{
+			const VectorRegister4Float LX = VectorLoadFloat1(&LineX[e]);
+			const VectorRegister4Float LY = VectorLoadFloat1(&LineY[e]);
+			const VectorRegister4Float ToX = VectorSubtract(X, VectorLoadFloat1(&StartX[e]));
+			const VectorRegister4Float ToY = VectorSubtract(Y, VectorLoadFloat1(&StartY[e]));
+
+			const VectorRegister4Float DotNormal = VectorSubtract(VectorMultiply(LX, ToY), VectorMultiply(LY, ToX));
+			const VectorRegister4Float DotLine = VectorMultiplyAdd(LX, ToX, VectorMultiply(LY, ToY));
+			const VectorRegister4Float T = VectorMin(VectorMax(VectorMultiply(DotLine, VectorLoadFloat1(&InvLengthSq[e])), Zero), One);
+			const VectorRegister4Float DX = VectorSubtract(ToX, VectorMultiply(T, LX));
+			const VectorRegister4Float DY = VectorSubtract(ToY, VectorMultiply(T, LY));
+			const VectorRegister4Float Dist = VectorSqrt(VectorMultiplyAdd(DX, DX, VectorMultiply(DY, DY)));
+
+			const VectorRegister4Float IsOutside = VectorCompareGT(DotNormal, Zero);
+			Outside = VectorBitwiseOr(Outside, IsOutside);
+			ClosestOutside = VectorSelect(IsOutside, VectorMin(ClosestOutside, Dist), ClosestOutside);
+			ClosestInside = VectorSelect(IsOutside, ClosestInside, VectorMin(ClosestInside, Dist));
+		}
+		VectorStore(VectorSelect(Outside, ClosestOutside, VectorNegate(ClosestInside)), OutDistances.GetData() + i);
+	}
+
+	for (; i < Num; ++i)
+	{
+		OutDistances[i] = GetDistance(LocalPoints[i]);
+	}
+}
+
+void FStevesPreparedConvex2D::BakeDistanceField(float CellSize, float Padding, FStevesDistanceField2D& OutField) const
+{
+	OutField.Values.Reset();
+	OutField.SizeX = OutField.SizeY = 0;
+	if (!Bounds.bIsValid || CellSize <= 0)
+	{
+		return;
+	}
+
+	const FVector2f Size = Bounds.GetSize() + FVector2f(Padding * 2);
+	OutField.Origin = Bounds.Min - FVector2f(Padding);
+	OutField.CellSize = CellSize;
+	OutField.SizeX = FMath::CeilToInt32(Size.X / CellSize) + 1;
+	OutField.SizeY = FMath::CeilToInt32(Size.Y / CellSize) + 1;
+	OutField.Values.SetNumUninitialized(OutField.SizeX * OutField.SizeY);
+
+	ParallelFor(OutField.SizeY, [&](int32 Row)
+	{
+		TArray<FVector2f, TInlineAllocator<256>> Points;
+		Points.SetNumUninitialized(OutField.SizeX);
+		const float Y = OutField.Origin.Y + Row * CellSize;
+		for (int32 Col = 0; Col < OutField.SizeX; ++Col)
+		{
+			Points[Col] = FVector2f(OutField.Origin.X + Col * CellSize, Y);
+		}
+		GetDistances(Points, TArrayView<float>(OutField.Values.GetData() + Row * OutField.SizeX, OutField.SizeX));
+	});
+}
+
+float FStevesDistanceField2D::Sample(const FVector2f& Point) const
+{
+	if (Values.Num() == 0)
+	{
+		return UE_BIG_NUMBER;
 	}
 
-	while (CellsTodo > 0)
+	const float FX = (Point.X - Origin.X) / CellSize;
+	const float FY = (Point.Y - Origin.Y) / CellSize;
+	const float CX = FMath::Clamp(FX, 0.f, (float)(SizeX - 1));
+	const float CY = FMath::Clamp(FY, 0.f, (float)(SizeY - 1));
+
+	const int32 X0 = FMath::Min(FMath::FloorToInt32(CX), SizeX - 1);
+	const int32 Y0 = FMath::Min(FMath::FloorToInt32(CY), SizeY - 1);
+	const int32 X1 = FMath::Min(X0 + 1, SizeX - 1);
+	const int32 Y1 = FMath::Min(Y0 + 1, SizeY - 1);
+	const float TX = CX - X0;
+	const float TY = CY - Y0;
+
+	const float Top = FMath::Lerp(Values[Y0 * SizeX + X0], Values[Y0 * SizeX + X1], TX);
+	const float Bottom = FMath::Lerp(Values[Y1 * SizeX + X0], Values[Y1 * SizeX + X1], TX);
+	const float Inside = FMath::Lerp(Top, Bottom, TY);
+
+	// Outside the grid, add the distance to its edge
+	const float OutX = (FX - CX) * CellSize;
+	const float OutY = (FY - CY) * CellSize;
+	return Inside + FMath::Sqrt(OutX * OutX + OutY * OutY);
+}
+
+namespace
+{
+	/// Packed row-major bitmap of cells still to be filled by Fill2DRegionWithRectangles
+	struct FRectFillGrid
 	{
-		// Find next starting point, from last one, until not done
-		for (; StartN < Len && bDoneMarkers[StartN]; ++StartN) {}
+		TArray<uint64> Bits;
+		int32 Width;
+		int32 Height;
+		int32 WordsPerRow;
 
-		// Shouldn't happen, but just in case
-		if (StartN >= Len)
-			break;
+		FRectFillGrid(int32 InWidth, int32 InHeight)
+			: Width(InWidth),
+			  Height(InHeight),
+			  WordsPerRow(FMath::DivideAndRoundUp(InWidth, 64))
+		{
+			Bits.SetNumZeroed(WordsPerRow * Height);
+		}
 
-		// NOTE: this X/Y is local (based at 0,0 not StartX/StartY, for use with DoneMarkers)
-		const int LocalStartX = StartN % Width;
-		const int LocalStartY = StartN / Width;
+		static FORCEINLINE uint64 RangeMask(int32 Bit, int32 Count)
+		{
+			return (Count == 64 ? ~0ull : ((1ull << Count) - 1)) << Bit;
+		}
 
-		// We try not to create long & thin rects if we can help it, unlike greedy meshing
-		// We're greedy in alternate dims to try to make fatter quads
-		bool bCanExtendX = true, bCanExtendY = true;
-		bool bExtendingX = true;
-		int W = 1;
-		int H = 1;
+		/// Read up to 64 bits starting at bit Start of a row
+		static FORCEINLINE uint64 ExtractBits(const uint64* Row, int32 Start, int32 Count)
+		{
+			const int32 Word = Start >> 6;
+			const int32 Bit = Start & 63;
+			uint64 Value = Row[Word] >> Bit;
+			if (Bit != 0 && Bit + Count > 64)
+			{
+				Value |= Row[Word + 1] << (64 - Bit);
+			}
+			return Value & RangeMask(0, Count);
+		}
 
-		while (bCanExtendX || bCanExtendY)
+		/// Copy this grid's area from a larger bitmap, starting at cell SrcX, SrcY
+		void CopyFrom(const uint64* Src, int32 SrcWordsPerRow, int32 SrcX, int32 SrcY)
 		{
-			// Try extending right
-			if (bExtendingX)
+			for (int32 Y = 0; Y < Height; ++Y)
 			{
-				bool ExtendOK = LocalStartX+W < Width;
-				for (int TestY = LocalStartY; ExtendOK && TestY < LocalStartY+H; ++TestY)
+				const uint64* SrcRow = Src + (int64)(SrcY + Y) * SrcWordsPerRow;
+				uint64* DstRow = Bits.GetData() + Y * WordsPerRow;
+				for (int32 W = 0; W < WordsPerRow; ++W)
 				{
-					if (bDoneMarkers[TestY*Width + LocalStartX+W])
-					{
-						// No good
-						ExtendOK = false;
-					}
+					DstRow[W] = ExtractBits(SrcRow, SrcX + W * 64, FMath::Min(64, Width - W * 64));
 				}
-				if (ExtendOK)
+			}
+		}
+
+		FORCEINLINE void Set(int32 X, int32 Y)
+		{
+			Bits[Y * WordsPerRow + (X >> 6)] |= 1ull << (X & 63);
+		}
+
+		FORCEINLINE bool IsSet(int32 X, int32 Y) const
+		{
+			return (Bits[Y * WordsPerRow + (X >> 6)] >> (X & 63)) & 1;
+		}
+
+		/// Whether all cells [X0, X1) on row Y are set, tested a word at a time
+		bool IsRangeSet(int32 Y, int32 X0, int32 X1) const
+		{
+			const uint64* Row = Bits.GetData() + Y * WordsPerRow;
+			for (int32 X = X0; X < X1;)
+			{
+				const int32 Bit = X & 63;
+				const int32 Count = FMath::Min(64 - Bit, X1 - X);
+				const uint64 Mask = RangeMask(Bit, Count);
+				if ((Row[X >> 6] & Mask) != Mask)
 				{
-					++W;
+					return false;
 				}
-				else
+				X += Count;
+			}
+			return true;
+		}
+
+		void ClearRange(int32 Y, int32 X0, int32 X1)
+		{
+			uint64* Row = Bits.GetData() + Y * WordsPerRow;
+			for (int32 X = X0; X < X1;)
+			{
+				const int32 Bit = X & 63;
+				const int32 Count = FMath::Min(64 - Bit, X1 - X);
+				Row[X >> 6] &= ~RangeMask(Bit, Count);
+				X += Count;
+			}
+		}
+
+		/// Find the first set cell in row-major order, starting from word InOutWord
+		bool FindNext(int32& InOutWord, int32& OutX, int32& OutY) const
+		{
+			for (; InOutWord < Bits.Num(); ++InOutWord)
+			{
+				if (const uint64 Word = Bits[InOutWord])
 				{
-					bCanExtendX = false;
+					OutY = InOutWord / WordsPerRow;
+					OutX = (InOutWord % WordsPerRow) * 64 + FMath::CountTrailingZeros64(Word);
+					return true;
 				}
-				// Flip extending axis if possible
-				if (bCanExtendY)
-					bExtendingX = false;
 			}
-			else
+			return false;
+		}
+	};
+
+	/// Fill all set cells of a grid with rectangles, clearing them, offsetting results by OffsetX/Y
+	int FillGridWithRectangles(FRectFillGrid& Grid, int OffsetX, int OffsetY, TArray<FIntRect>& OutRects)
+	{
+		int RectCount = 0;
+		int32 SearchWord = 0;
+		int32 LocalStartX, LocalStartY;
+		while (Grid.FindNext(SearchWord, LocalStartX, LocalStartY))
+		{
+			// We try not to create long & thin rects if we can help it, unlike greedy meshing
+			// We're greedy in alternate dims to try to make fatter quads
+			bool bCanExtendX = true, bCanExtendY = true;
+			bool bExtendingX = true;
+			int W = 1;
+			int H = 1;
+
+			while (bCanExtendX || bCanExtendY)
 			{
-				// Try extending down
-				bool ExtendOK = LocalStartY+H < Height;
-				for (int TestX = LocalStartX; ExtendOK && TestX < LocalStartX+W; ++TestX)
+				// Try extending right
+				if (bExtendingX)
 				{
-					if (bDoneMarkers[(LocalStartY+H)*Width + TestX])
+					bool ExtendOK = LocalStartX+W < Grid.Width;
+					for (int TestY = LocalStartY; ExtendOK && TestY < LocalStartY+H; ++TestY)
 					{
-						// No good
-						ExtendOK = false;
+						ExtendOK = Grid.IsSet(LocalStartX+W, TestY);
 					}
-				}
-				if (ExtendOK)
-				{
-					++H;
+					if (ExtendOK)
+					{
+						++W;
+					}
+					else
+					{
+						bCanExtendX = false;
+					}
+					// Flip extending axis if possible
+					if (bCanExtendY)
+						bExtendingX = false;
 				}
 				else
 				{
-					bCanExtendY = false;
+					// Try extending down, testing the whole row segment a word at a time
+					const bool ExtendOK = LocalStartY+H < Grid.Height && Grid.IsRangeSet(LocalStartY+H, LocalStartX, LocalStartX+W);
+					if (ExtendOK)
+					{
+						++H;
+					}
+					else
+					{
+						bCanExtendY = false;
+					}
+					// Flip extending axis if possible
+					if (bCanExtendX)
+						bExtendingX = true;
 				}
-				// Flip extending axis if possible
-				if (bCanExtendX)
-					bExtendingX = true;
+			}
+
+			// We've calculated the max extension
+			for (int y = LocalStartY; y < LocalStartY+H; ++y)
+			{
+				Grid.ClearRange(y, LocalStartX, LocalStartX+W);
+			}
+			OutRects.Add(FIntRect(OffsetX+LocalStartX, OffsetY+LocalStartY, OffsetX+LocalStartX+W-1, OffsetY+LocalStartY+H-1));
+			++RectCount;
+		}
+
+		return RectCount;
+	}
+
+	/// Merge rectangles which share a whole edge, e.g. across tile seams. Rects are min/max inclusive.
+	void MergeAdjacentRects(TArray<FIntRect>& Rects)
+	{
+		// Same Y span, touching in X
+		Rects.Sort([](const FIntRect& A, const FIntRect& B)
+		{
+			if (A.Min.Y != B.Min.Y) return A.Min.Y < B.Min.Y;
+			if (A.Max.Y != B.Max.Y) return A.Max.Y < B.Max.Y;
+			return A.Min.X < B.Min.X;
+		});
+		int32 Num = 0;
+		for (const FIntRect& R : Rects)
+		{
+			FIntRect* Prev = Num > 0 ? &Rects[Num - 1] : nullptr;
+			if (Prev && Prev->Min.Y == R.Min.Y && Prev->Max.Y == R.Max.Y && Prev->Max.X + 1 == R.Min.X)
+			{
+				Prev->Max.X = R.Max.X;
+			}
+			else
+			{
+				Rects[Num++] = R;
 			}
 		}
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+		Rects.SetNum(Num, EAllowShrinking::No);
+#else
+		Rects.SetNum(Num, false);
+#endif
+
+		// Same X span, touching in Y
+		Rects.Sort([](const FIntRect& A, const FIntRect& B)
+		{
+			if (A.Min.X != B.Min.X) return A.Min.X < B.Min.X;
+			if (A.Max.X != B.Max.X) return A.Max.X < B.Max.X;
+			return A.Min.Y < B.Min.Y;
+		});
+		Num = 0;
+		for (const FIntRect& R : Rects)
+		{
+			FIntRect* Prev = Num > 0 ? &Rects[Num - 1] : nullptr;
+			if (Prev && Prev->Min.X == R.Min.X && Prev->Max.X == R.Max.X && Prev->Max.Y + 1 == R.Min.Y)
+			{
+				Prev->Max.Y = R.Max.Y;
+			}
+			else
+			{
+				Rects[Num++] = R;
+			}
+		}
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+		Rects.SetNum(Num, EAllowShrinking::No);
+#else
+		Rects.SetNum(Num, false);
+#endif
+	}
+}
+
+int StevesMathHelpers::Fill2DRegionWithRectangles(int StartX,
+	int StartY,
+	int Width,
+	int Height,
+	std::function<bool(int, int)> CellIncludeFunc,
+	TArray<FIntRect>& OutRects)
+{
+	if (Width <= 0 || Height <= 0)
+	{
+		return 0;
+	}
 
-		// We've calculated the max extension
-		for (int y = LocalStartY; y < LocalStartY+H; ++y)
+	// Initialise the grid based on func
+	FRectFillGrid Grid(Width, Height);
+	for (int y = 0; y < Height; ++y)
+	{
+		for (int x = 0; x < Width; ++x)
 		{
-			for (int x = LocalStartX; x < LocalStartX+W; ++x)
+			if (CellIncludeFunc(x+StartX, y+StartY))
 			{
-				bDoneMarkers[y*Width+x] = true;
-				--CellsTodo;
+				Grid.Set(x, y);
 			}
 		}
-		OutRects.Add(FIntRect(StartX+LocalStartX, StartY+LocalStartY, StartX+LocalStartX+W-1, StartY+LocalStartY+H-1));
-		++RectCount;
-		
 	}
 
-	return RectCount;
-	
+	return FillGridWithRectangles(Grid, StartX, StartY, OutRects);
+}
+
+int StevesMathHelpers::Fill2DRegionWithRectangles(int StartX,
+	int StartY,
+	int Width,
+	int Height,
+	TConstArrayView<uint64> CellBits,
+	int WordsPerRow,
+	TArray<FIntRect>& OutRects,
+	bool bParallel,
+	int TileSize)
+{
+	if (Width <= 0 || Height <= 0)
+	{
+		return 0;
+	}
+	check(WordsPerRow >= FMath::DivideAndRoundUp(Width, 64));
+	check(CellBits.Num() >= WordsPerRow * Height);
+
+	TileSize = FMath::Max(TileSize, 1);
+	const int NumTilesX = FMath::DivideAndRoundUp(Width, TileSize);
+	const int NumTilesY = FMath::DivideAndRoundUp(Height, TileSize);
+	if (!bParallel || NumTilesX * NumTilesY <= 1)
+	{
+		FRectFillGrid Grid(Width, Height);
+		Grid.CopyFrom(CellBits.GetData(), WordsPerRow, 0, 0);
+		return FillGridWithRectangles(Grid, StartX, StartY, OutRects);
+	}
+
+	TArray<TArray<FIntRect>> TileRects;
+	TileRects.SetNum(NumTilesX * NumTilesY);
+	ParallelFor(TileRects.Num(), [&](int32 TileIndex)
+	{
+		const int TileX = (TileIndex % NumTilesX) * TileSize;
+		const int TileY = (TileIndex / NumTilesX) * TileSize;
+		FRectFillGrid Grid(FMath::Min(TileSize, Width - TileX), FMath::Min(TileSize, Height - TileY));
+		Grid.CopyFrom(CellBits.GetData(), WordsPerRow, TileX, TileY);
+		FillGridWithRectangles(Grid, StartX + TileX, StartY + TileY, TileRects[TileIndex]);
+	});
+
+	TArray<FIntRect> Rects;
+	for (const auto& Tile : TileRects)
+	{
+		Rects.Append(Tile);
+	}
+	MergeAdjacentRects(Rects);
+	OutRects.Append(Rects);
+	return Rects.Num();
 }
@@ -0,0 +1,444 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesPoissonDiskSampling.h"
+
+#include "StevesUEHelpers.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/// Refuse to allocate grids larger than this, it's almost certainly a mistake in the distance
+	constexpr int64 MaxGridCells = 64 * 1024 * 1024;
+
+	template <int Dim>
+	struct TPoissonDiskTraits;
+
+	template <>
+	struct TPoissonDiskTraits<2>
+	{
+		using FVec = FVector2D;
+
+		static FVec RandomPoint(FStevesBalancedRandomStream& Stream, const FVec& Min, const FVec& Max)
+		{
+			const FVector2D R = Stream.Rand2D();
+			return FVec(FMath::Lerp(Min.X, Max.X, R.X), FMath::Lerp(Min.Y, Max.Y, R.Y));
+		}
+
+		/// Random offset in the annulus [Radius, 2 * Radius], uniform by area
+		static FVec RandomOffset(FStevesBalancedRandomStream& Stream, double Radius)
+		{
+			const FVector2D R = Stream.Rand2D();
+			const double Angle = R.X * UE_DOUBLE_TWO_PI;
+			const double Dist = Radius * FMath::Sqrt(1.0 + 3.0 * R.Y);
+			return FVec(FMath::Cos(Angle), FMath::Sin(Angle)) * Dist;
+		}
+	};
+
+	template <>
+	struct TPoissonDiskTraits<3>
+	{
+		using FVec = FVector;
+
+		static FVec RandomPoint(FStevesBalancedRandomStream& Stream, const FVec& Min, const FVec& Max)
+		{
+			const FVector R = Stream.Rand3D();
+			return FVec(FMath::Lerp(Min.X, Max.X, R.X), FMath::Lerp(Min.Y, Max.Y, R.Y), FMath::Lerp(Min.Z, Max.Z, R.Z));
+		}
+
+		/// Random offset in the spherical shell [Radius, 2 * Radius], uniform by volume
+		static FVec RandomOffset(FStevesBalancedRandomStream& Stream, double Radius)
+		{
+			const FVector R = Stream.Rand3D();
+			const double Z = 1.0 - 2.0 * R.X;
+			const double Phi = R.Y * UE_DOUBLE_TWO_PI;
+			const double S = FMath::Sqrt(FMath::Max(0.0, 1.0 - Z * Z));
+			const double Dist = Radius * FMath::Pow(1.0 + 7.0 * R.Z, 1.0 / 3.0);
+			return FVec(S * FMath::Cos(Phi), S * FMath::Sin(Phi), Z) * Dist;
+		}
+	};
+
+	/**
+	 * Bridson's algorithm over a background grid, sized so that each cell can hold at most one point. The grid can be
+	 * sampled in tiles, which are aligned to cells so that each cell is only ever written by one tile.
+	 */
+	template <int Dim>
+	class TPoissonDiskSampler
+	{
+	public:
+		using FTraits = TPoissonDiskTraits<Dim>;
+		using FVec = typename FTraits::FVec;
+		using FDistanceFunc = std::function<float(const FVec&)>;
+
+	protected:
+		struct FCell
+		{
+			FVec Pos;
+			/// 0 if empty
+			float Distance = 0;
+		};
+
+		FVec Origin;
+		FVec Extent;
+		double CellSize;
+		int32 Size[Dim];
+		int32 SearchCells;
+		TArray<FCell> Cells;
+		float MinDistance;
+		float MaxDistance;
+		const FDistanceFunc& DistanceFunc;
+		int MaxAttempts;
+
+		/// Get the cell containing a point, unclamped
+		void GetCell(const FVec& P, int32 (&OutCell)[Dim]) const
+		{
+			for (int i = 0; i < Dim; ++i)
+			{
+				OutCell[i] = FMath::FloorToInt32((P[i] - Origin[i]) / CellSize);
+			}
+		}
+
+		int32 GetIndex(const int32 (&Cell)[Dim]) const
+		{
+			int32 Index = Cell[Dim - 1];
+			for (int i = Dim - 2; i >= 0; --i)
+			{
+				Index = Index * Size[i] + Cell[i];
+			}
+			return Index;
+		}
+
+		float GetDistanceAt(const FVec& P) const
+		{
+			return DistanceFunc ? FMath::Clamp(DistanceFunc(P), MinDistance, MaxDistance) : MinDistance;
+		}
+
+		bool IsFarEnough(const FVec& P, const int32 (&Cell)[Dim], float Distance) const
+		{
+			int32 Lo[Dim], Hi[Dim], It[Dim];
+			for (int i = 0; i < Dim; ++i)
+			{
+				Lo[i] = It[i] = FMath::Max(0, Cell[i] - SearchCells);
+				Hi[i] = FMath::Min(Size[i] - 1, Cell[i] + SearchCells);
+			}
+
+			while (true)
+			{
+				const FCell& Other = Cells[GetIndex(It)];
+				if (Other.Distance > 0)
+				{
+					const double Required = FMath::Max(Distance, Other.Distance);
+					if ((Other.Pos - P).SizeSquared() < Required * Required)
+					{
+						return false;
+					}
+				}
+
+				// Next cell in the neighbourhood
+				int i = 0;
+				for (; i < Dim; ++i)
+				{
+					if (++It[i] <= Hi[i])
+					{
+						break;
+					}
+					It[i] = Lo[i];
+				}
+				if (i == Dim)
+				{
+					return true;
+				}
+			}
+		}
+
+		bool IsInTile(const int32 (&Cell)[Dim], const int32 (&TileMin)[Dim], const int32 (&TileMax)[Dim], const FVec& P) const
+		{
+			for (int i = 0; i < Dim; ++i)
+			{
+				if (Cell[i] < TileMin[i] || Cell[i] >= TileMax[i] || P[i] < Origin[i] || P[i] > Origin[i] + Extent[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+	public:
+		TPoissonDiskSampler(const FVec& Min,
+		                    const FVec& Max,
+		                    float InMinDistance,
+		                    float InMaxDistance,
+		                    const FDistanceFunc& InDistanceFunc,
+		                    int InMaxAttempts)
+			: Origin(Min),
+			  Extent(Max - Min),
+			  MinDistance(InMinDistance),
+			  MaxDistance(InDistanceFunc ? FMath::Max(InMinDistance, InMaxDistance) : InMinDistance),
+			  DistanceFunc(InDistanceFunc),
+			  MaxAttempts(FMath::Max(1, InMaxAttempts))
+		{
+			// Diagonal of a cell is the min distance, so no 2 points can share a cell
+			CellSize = MinDistance / FMath::Sqrt((double)Dim);
+			SearchCells = FMath::CeilToInt32(MaxDistance / CellSize);
+			int64 NumCells = 1;
+			for (int i = 0; i < Dim; ++i)
+			{
+				Size[i] = FMath::Max(1, FMath::CeilToInt32(Extent[i] / CellSize));
+				NumCells *= Size[i];
+			}
+
+			if (NumCells > MaxGridCells)
+			{
+				UE_LOG(LogStevesUEHelpers, Error, TEXT("StevesPoissonDiskSampling: Distance %f is too small for the area, would need %lld grid cells"), MinDistance, NumCells);
+				return;
+			}
+			Cells.SetNum(NumCells);
+		}
+
+		bool IsValid() const { return Cells.Num() > 0; }
+		int32 GetSize(int i) const { return Size[i]; }
+		double GetCellSize() const { return CellSize; }
+		int32 GetSearchCells() const { return SearchCells; }
+
+		/// Sample a tile covering cells [TileMin, TileMax), appending to OutPoints
+		int SampleTile(const int32 (&TileMin)[Dim],
+		               const int32 (&TileMax)[Dim],
+		               FStevesBalancedRandomStream& Stream,
+		               TArray<FVec>& OutPoints)
+		{
+			FVec Lo, Hi;
+			for (int i = 0; i < Dim; ++i)
+			{
+				Lo[i] = Origin[i] + TileMin[i] * CellSize;
+				Hi[i] = FMath::Min(Origin[i] + Extent[i], Origin[i] + TileMax[i] * CellSize);
+			}
+
+			struct FActive
+			{
+				FVec Pos;
+				float Distance;
+			};
+			TArray<FActive> Active;
+			// Which active point to expand is picked with a separate stream, so it's not correlated with placement
+			FRandomStream Picker(Stream.GetCurrentSeed());
+			const int32 StartNum = OutPoints.Num();
+
+			auto TryAdd = [&](const FVec& P)
+			{
+				int32 Cell[Dim];
+				GetCell(P, Cell);
+				if (!IsInTile(Cell, TileMin, TileMax, P))
+				{
+					return false;
+				}
+				const float Distance = GetDistanceAt(P);
+				if (!IsFarEnough(P, Cell, Distance))
+				{
+					return false;
+				}
+				Cells[GetIndex(Cell)] = FCell {P, Distance};
+				OutPoints.Add(P);
+				Active.Add(FActive {P, Distance});
+				return true;
+			};
+
+			for (int Attempt = 0; Attempt < MaxAttempts && !TryAdd(FTraits::RandomPoint(Stream, Lo, Hi)); ++Attempt)
+			{
+			}
+
+			while (Active.Num() > 0)
+			{
+				const int32 Index = Picker.RandHelper(Active.Num());
+				const FActive Current = Active[Index];
+				bool bAdded = false;
+				for (int Attempt = 0; Attempt < MaxAttempts && !bAdded; ++Attempt)
+				{
+					bAdded = TryAdd(Current.Pos + FTraits::RandomOffset(Stream, Current.Distance));
+				}
+				if (!bAdded)
+				{
+					Active.RemoveAtSwap(Index);
+				}
+			}
+
+			return OutPoints.Num() - StartNum;
+		}
+
+		int Sample(FStevesBalancedRandomStream& Stream, TArray<FVec>& OutPoints)
+		{
+			if (!IsValid())
+			{
+				return 0;
+			}
+			int32 TileMin[Dim], TileMax[Dim];
+			for (int i = 0; i < Dim; ++i)
+			{
+				TileMin[i] = 0;
+				TileMax[i] = Size[i];
+			}
+			return SampleTile(TileMin, TileMax, Stream, OutPoints);
+		}
+
+		int SampleParallel(uint32 Seed, float TileSize, TArray<FVec>& OutPoints)
+		{
+			if (!IsValid())
+			{
+				return 0;
+			}
+
+			if (TileSize <= 0)
+			{
+				// Roughly 1000 points per tile
+				TileSize = MinDistance * FMath::Pow(1000.0, 1.0 / Dim);
+			}
+			// Tiles in the same pass are a whole tile apart, so as long as a tile is wider than the search, tiles in
+			// the same pass never read cells the other is writing
+			const int32 TileCells = FMath::Max(FMath::CeilToInt32(TileSize / CellSize), SearchCells + 1);
+
+			int32 NumTiles[Dim];
+			int32 TotalTiles = 1;
+			for (int i = 0; i < Dim; ++i)
+			{
+				NumTiles[i] = FMath::DivideAndRoundUp(Size[i], TileCells);
+				TotalTiles *= NumTiles[i];
+			}
+
+			TArray<TArray<FVec>> TileResults;
+			TileResults.SetNum(TotalTiles);
+
+			auto GetTileCoords = [&](int32 TileIndex, int32 (&OutCoords)[Dim])
+			{
+				for (int i = 0; i < Dim; ++i)
+				{
+					OutCoords[i] = TileIndex % NumTiles[i];
+					TileIndex /= NumTiles[i];
+				}
+			};
+
+			// 2^Dim passes, split by odd / even tile coordinate in each dimension
+			for (int32 Pass = 0; Pass < (1 << Dim); ++Pass)
+			{
+				TArray<int32> PassTiles;
+				for (int32 TileIndex = 0; TileIndex < TotalTiles; ++TileIndex)
+				{
+					int32 Coords[Dim];
+					GetTileCoords(TileIndex, Coords);
+					bool bInPass = true;
+					for (int i = 0; i < Dim; ++i)
+					{
+						bInPass &= (Coords[i] & 1) == ((Pass >> i) & 1);
+					}
+					if (bInPass)
+					{
+						PassTiles.Add(TileIndex);
+					}
+				}
+
+				ParallelFor(PassTiles.Num(), [&](int32 i)
+				{
+					const int32 TileIndex = PassTiles[i];
+					int32 Coords[Dim], TileMin[Dim], TileMax[Dim];
+					GetTileCoords(TileIndex, Coords);
+					for (int d = 0; d < Dim; ++d)
+					{
+						TileMin[d] = Coords[d] * TileCells;
+						TileMax[d] = FMath::Min(Size[d], TileMin[d] + TileCells);
+					}
+					FStevesBalancedRandomStream Stream(HashCombineFast(Seed, (uint32)TileIndex));
+					SampleTile(TileMin, TileMax, Stream, TileResults[TileIndex]);
+				});
+			}
+
+			// Combine in tile order so the result doesn't depend on thread timing
+			const int32 StartNum = OutPoints.Num();
+			for (const auto& Points : TileResults)
+			{
+				OutPoints.Append(Points);
+			}
+			return OutPoints.Num() - StartNum;
+		}
+	};
+}
+
+int StevesPoissonDiskSampling::SampleRect(const FBox2D& Rect,
+                                          float Distance,
+                                          FStevesBalancedRandomStream& Stream,
+                                          TArray<FVector2D>& OutPoints,
+                                          int MaxAttempts)
+{
+	return SampleRect(Rect, Distance, Distance, nullptr, Stream, OutPoints, MaxAttempts);
+}
+
+int StevesPoissonDiskSampling::SampleRect(const FBox2D& Rect,
+                                          float MinDistance,
+                                          float MaxDistance,
+                                          std::function<float(const FVector2D&)> DistanceFunc,
+                                          FStevesBalancedRandomStream& Stream,
+                                          TArray<FVector2D>& OutPoints,
+                                          int MaxAttempts)
+{
+	if (MinDistance <= 0 || !Rect.bIsValid)
+	{
+		return 0;
+	}
+	TPoissonDiskSampler<2> Sampler(Rect.Min, Rect.Max, MinDistance, MaxDistance, DistanceFunc, MaxAttempts);
+	return Sampler.Sample(Stream, OutPoints);
+}
+
+int StevesPoissonDiskSampling::SampleRectParallel(const FBox2D& Rect,
+                                                  float MinDistance,
+                                                  float MaxDistance,
+                                                  std::function<float(const FVector2D&)> DistanceFunc,
+                                                  uint32 Seed,
+                                                  TArray<FVector2D>& OutPoints,
+                                                  int MaxAttempts,
+                                                  float TileSize)
+{
+	if (MinDistance <= 0 || !Rect.bIsValid)
+	{
+		return 0;
+	}
+	TPoissonDiskSampler<2> Sampler(Rect.Min, Rect.Max, MinDistance, MaxDistance, DistanceFunc, MaxAttempts);
+	return Sampler.SampleParallel(Seed, TileSize, OutPoints);
+}
+
+int StevesPoissonDiskSampling::SampleBox(const FBox& Box,
+                                         float Distance,
+                                         FStevesBalancedRandomStream& Stream,
+                                         TArray<FVector>& OutPoints,
+                                         int MaxAttempts)
+{
+	return SampleBox(Box, Distance, Distance, nullptr, Stream, OutPoints, MaxAttempts);
+}
+
+int StevesPoissonDiskSampling::SampleBox(const FBox& Box,
+                                         float MinDistance,
+                                         float MaxDistance,
+                                         std::function<float(const FVector&)> DistanceFunc,
+                                         FStevesBalancedRandomStream& Stream,
+                                         TArray<FVector>& OutPoints,
+                                         int MaxAttempts)
+{
+	if (MinDistance <= 0 || !Box.IsValid)
+	{
+		return 0;
+	}
+	TPoissonDiskSampler<3> Sampler(Box.Min, Box.Max, MinDistance, MaxDistance, DistanceFunc, MaxAttempts);
+	return Sampler.Sample(Stream, OutPoints);
+}
+
+int StevesPoissonDiskSampling::SampleBoxParallel(const FBox& Box,
+                                                 float MinDistance,
+                                                 float MaxDistance,
+                                                 std::function<float(const FVector&)> DistanceFunc,
+                                                 uint32 Seed,
+                                                 TArray<FVector>& OutPoints,
+                                                 int MaxAttempts,
+                                                 float TileSize)
+{
+	if (MinDistance <= 0 || !Box.IsValid)
+	{
+		return 0;
+	}
+	TPoissonDiskSampler<3> Sampler(Box.Min, Box.Max, MinDistance, MaxDistance, DistanceFunc, MaxAttempts);
+	return Sampler.SampleParallel(Seed, TileSize, OutPoints);
+}
@@ -0,0 +1,8 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#pragma once
+
+#include "Stats/Stats.h"
+
+/// Shared stat group for the actor and render target pools, view with "stat StevesPools"
+DECLARE_STATS_GROUP(TEXT("StevesPools"), STATGROUP_StevesPools, STATCAT_Advanced);
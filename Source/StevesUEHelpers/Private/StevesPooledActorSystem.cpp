@@ -5,6 +5,38 @@
 #include "Components/PrimitiveComponent.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "StevesPooledActor.h"
+#include "StevesPoolStats.h"
+#include "StevesUEHelpers.h"
+
+DECLARE_CYCLE_STAT(TEXT("Get Pooled Actor"), STAT_PooledActorGet, STATGROUP_StevesPools);
+DECLARE_CYCLE_STAT(TEXT("Release Pooled Actor"), STAT_PooledActorRelease, STATGROUP_StevesPools);
+DECLARE_CYCLE_STAT(TEXT("Actor Pool Tick"), STAT_PooledActorTick, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Actor Hits"), STAT_PooledActorHits, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Actor Misses"), STAT_PooledActorMisses, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Actor Pre-warm Spawns"), STAT_PooledActorPreWarmSpawns, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Actor Refusals"), STAT_PooledActorRefusals, STATGROUP_StevesPools);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Actors In Use"), STAT_PooledActorsActive, STATGROUP_StevesPools);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Actors Available"), STAT_PooledActorsPooled, STATGROUP_StevesPools);
+
+static void DumpStevesPools(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+{
+	if (auto PoolSys = UStevesPooledActorSystem::Get(World))
+	{
+		PoolSys->DumpStats(Ar);
+	}
+	if (auto GS = GetStevesGameSubsystem(World))
+	{
+		for (const auto& Pool : GS->GetTextureRenderTargetPools())
+		{
+			Pool->DumpStats(Ar);
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpStevesPoolsCmd(
+	TEXT("Steves.DumpPools"),
+	TEXT("Dump occupancy, hit rates and memory use of all actor pools and render target pools"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&DumpStevesPools));
 
 UStevesPooledActorSystem* UStevesPooledActorSystem::Get(const UObject* WorldContext)
 {
@@ -19,32 +51,190 @@ UStevesPooledActorSystem* UStevesPooledActorSystem::Get(const UObject* WorldCont
 	return nullptr;
 }
 
-TDeque<TObjectPtr<AActor>>* UStevesPooledActorSystem::GetPool(UClass* Class, bool bCreate)
+UStevesPooledActorSystem::FActorPool* UStevesPooledActorSystem::GetPool(UClass* Class, bool bCreate)
 {
 	auto pPool = Pools.Find(Class);
 	if (!pPool && bCreate)
 	{
 		// Create new pool
 		pPool = &Pools.Emplace(Class);
+		pPool->bImplementsPooledActor = Class->ImplementsInterface(UStevesPooledActor::StaticClass());
 	}
 
 	return pPool;
 }
 
+UStevesPooledActorSystem::FPooledActorEntry& UStevesPooledActorSystem::TrackActor(AActor* Actor, UClass* Class, FActorPool* pPool)
+{
+	if (auto pEntry = PooledActorEntries.Find(Actor))
+	{
+		return *pEntry;
+	}
+
+	Actor->OnDestroyed.AddUniqueDynamic(this, &UStevesPooledActorSystem::OnPooledActorDestroyed);
+	FPooledActorEntry& Entry = PooledActorEntries.Add(Actor);
+	Entry.PoolClass = Class;
+	// Newly tracked actors start off in use
+	++pPool->NumActive;
+	INC_DWORD_STAT(STAT_PooledActorsActive);
+	return Entry;
+}
+
+void UStevesPooledActorSystem::UntrackActor(AActor* Actor)
+{
+	if (PooledActorEntries.Remove(Actor) > 0)
+	{
+		Actor->OnDestroyed.RemoveDynamic(this, &UStevesPooledActorSystem::OnPooledActorDestroyed);
+	}
+}
+
+void UStevesPooledActorSystem::PushToPool(FActorPool* pPool, AActor* Actor, FPooledActorEntry& Entry)
+{
+	Entry.PoolIndex = pPool->Actors.Add(Actor);
+	--pPool->NumActive;
+	INC_DWORD_STAT(STAT_PooledActorsPooled);
+	DEC_DWORD_STAT(STAT_PooledActorsActive);
+}
+
+AActor* UStevesPooledActorSystem::PopFromPool(FActorPool* pPool)
+{
+	// Destroyed actors are evicted eagerly, but be defensive in case something slipped through (e.g. pending kill)
+	while (pPool->Actors.Num() > 0)
+	{
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+		AActor* Actor = pPool->Actors.Pop(EAllowShrinking::No);
+#else
+		AActor* Actor = pPool->Actors.Pop(false);
+#endif
+		DEC_DWORD_STAT(STAT_PooledActorsPooled);
+		if (!IsValid(Actor))
+		{
+			UntrackActor(Actor);
+			continue;
+		}
+
+		FPooledActorEntry& Entry = PooledActorEntries.FindChecked(Actor);
+		Entry.PoolIndex = INDEX_NONE;
+		++pPool->NumActive;
+		++pPool->NumHits;
+		INC_DWORD_STAT(STAT_PooledActorsActive);
+		INC_DWORD_STAT(STAT_PooledActorHits);
+		MarkActive(pPool, Actor, Entry);
+		return Actor;
+	}
+	return nullptr;
+}
+
+void UStevesPooledActorSystem::MarkActive(FActorPool* pPool, AActor* Actor, FPooledActorEntry& Entry)
+{
+	++Entry.ActiveSerial;
+	if (pPool->NumActive >= pPool->HighWaterActive)
+	{
+		pPool->HighWaterActive = pPool->NumActive;
+		pPool->HighWaterTime = GetWorld()->GetTimeSeconds();
+	}
+
+	if (pPool->bHasPolicy && pPool->Policy.OverflowBehaviour == EStevesPoolOverflowBehaviour::RecycleOldest)
+	{
+		pPool->ActiveOrder.PushLast({Actor, Entry.ActiveSerial});
+
+		// Records for actors that have since been released are only discarded when they reach the front, so
+		// compact occasionally to stop the queue growing without bound
+		if (pPool->ActiveOrder.Num() > pPool->NumActive * 2 + 32)
+		{
+			TDeque<FActorPool::FActiveRecord> Kept;
+			for (const auto& Record : pPool->ActiveOrder)
+			{
+				auto pEntry = PooledActorEntries.Find(Record.Actor);
+				if (pEntry && !pEntry->IsPooled() && pEntry->ActiveSerial == Record.Serial)
+				{
+					Kept.PushLast(Record);
+				}
+			}
+			pPool->ActiveOrder = MoveTemp(Kept);
+		}
+	}
+}
+
+AActor* UStevesPooledActorSystem::RecycleOldestActive(FActorPool* pPool)
+{
+	FActorPool::FActiveRecord Record;
+	while (pPool->ActiveOrder.TryPopFirst(Record))
+	{
+		auto pEntry = PooledActorEntries.Find(Record.Actor);
+		if (pEntry && !pEntry->IsPooled() && pEntry->ActiveSerial == Record.Serial && IsValid(Record.Actor))
+		{
+			// Caller is responsible for calling DeactivateOnAddedToPool, so that all bookkeeping is done first
+			return Record.Actor;
+		}
+	}
+	return nullptr;
+}
+
+void UStevesPooledActorSystem::RemoveFromPoolAt(FActorPool* pPool, int32 Index)
+{
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+	pPool->Actors.RemoveAtSwap(Index, EAllowShrinking::No);
+#else
+	pPool->Actors.RemoveAtSwap(Index, 1, false);
+#endif
+	DEC_DWORD_STAT(STAT_PooledActorsPooled);
+	if (pPool->Actors.IsValidIndex(Index))
+	{
+		// The last actor was moved into this slot, so update its record
+		if (auto pMoved = PooledActorEntries.Find(pPool->Actors[Index]))
+		{
+			pMoved->PoolIndex = Index;
+		}
+	}
+}
+
+void UStevesPooledActorSystem::OnPooledActorDestroyed(AActor* Actor)
+{
+	FPooledActorEntry Entry;
+	if (PooledActorEntries.RemoveAndCopyValue(Actor, Entry))
+	{
+		if (auto pPool = GetPool(Entry.PoolClass, false))
+		{
+			if (Entry.IsPooled())
+			{
+				RemoveFromPoolAt(pPool, Entry.PoolIndex);
+			}
+			else
+			{
+				--pPool->NumActive;
+				DEC_DWORD_STAT(STAT_PooledActorsActive);
+			}
+		}
+	}
+}
+
+bool UStevesPooledActorSystem::IsActorInPool(const AActor* Actor) const
+{
+	auto pEntry = PooledActorEntries.Find(Actor);
+	return pEntry && pEntry->IsPooled();
+}
+
 void UStevesPooledActorSystem::AddActorToPool(AActor* Actor)
 {
+	SCOPE_CYCLE_COUNTER(STAT_PooledActorRelease);
+
 	if (!IsValid(Actor))
 	{
 		return;
 	}
 
 	UClass* Class = Actor->GetClass()->GetAuthoritativeClass();
-
-	if (auto pPool = GetPool(Class, true))
+	FActorPool* pPool = GetPool(Class, true);
+	FPooledActorEntry& Entry = TrackActor(Actor, Class, pPool);
+	if (Entry.IsPooled())
 	{
-		pPool->PushLast(Actor);
-		DisableActor(Actor);
+		UE_LOG(LogStevesUEHelpers, Warning, TEXT("UStevesPooledActorSystem: Ignoring attempt to add %s to the pool when it's already pooled"), *Actor->GetName());
+		return;
 	}
+
+	PushToPool(pPool, Actor, Entry);
+	DisableActor(Actor, pPool, Entry);
 }
 
 void UStevesPooledActorSystem::ReleasePooledActor(AActor* Actor)
@@ -59,28 +249,164 @@ AActor* UStevesPooledActorSystem::GetPooledActor(TSubclassOf<AActor> ActorClass,
                                                FRotator const& Rotation,
                                                bool& bWasReused)
 {
+	SCOPE_CYCLE_COUNTER(STAT_PooledActorGet);
+
 	UClass* Class = ActorClass->GetAuthoritativeClass();
+	// Create the pool even if we're going to spawn, so that usage is tracked
+	FActorPool* pPool = GetPool(Class, true);
+	const FTransform Transform(Rotation, Location);
 
-	if (auto pPool = GetPool(Class, false))
+	if (AActor* Ret = PopFromPool(pPool))
 	{
-		// We use the end of the deque meaning we get most recently used actor for better potential cache use
-		TObjectPtr<AActor> Ret = nullptr;
-		// In case someone has destroyed the actors we've got in the pool, keep trying if not valid until empty
-		while (pPool->TryPopLast(Ret))
+		ReviveActor(Ret, Transform, false, pPool, PooledActorEntries.FindChecked(Ret));
+		bWasReused = true;
+		return Ret;
+	}
+
+	if (IsPoolAtMax(pPool))
+	{
+		if (pPool->Policy.OverflowBehaviour == EStevesPoolOverflowBehaviour::RecycleOldest)
 		{
-			if (IsValid(Ret.Get()))
+			if (AActor* Ret = RecycleOldestActive(pPool))
 			{
-				ReviveActor(Ret.Get(), Location, Rotation);
+				FPooledActorEntry& Entry = PooledActorEntries.FindChecked(Ret);
+				MarkActive(pPool, Ret, Entry);
+				++pPool->NumRecycled;
+				// Give the actor a chance to clean up from its previous use
+				if (pPool->bImplementsPooledActor)
+				{
+					IStevesPooledActor::Execute_DeactivateOnAddedToPool(Ret);
+				}
+				ReviveActor(Ret, Transform, false, GetPool(Class, true), PooledActorEntries.FindChecked(Ret));
 				bWasReused = true;
-				return Ret.Get();
+				return Ret;
 			}
 		}
+		UE_LOG(LogStevesUEHelpers, Verbose, TEXT("UStevesPooledActorSystem: Refused request for %s, pool is at its maximum of %d actors"), *Class->GetName(), pPool->Policy.MaxActors);
+		++pPool->NumRefused;
+		INC_DWORD_STAT(STAT_PooledActorRefusals);
+		bWasReused = false;
+		return nullptr;
 	}
 
 	// We need to spawn a new one
 	// We don't add this to the pool of course, because the caller is getting it
 	bWasReused = false;
-	return SpawnNewActor(Class, Location, Rotation);
+	AActor* Ret = SpawnNewActor(Class, Transform);
+	// Spawning can run arbitrary code which may create other pools, so don't rely on the earlier pointer
+	pPool = GetPool(Class, true);
+	++pPool->NumMisses;
+	INC_DWORD_STAT(STAT_PooledActorMisses);
+	MarkActive(pPool, Ret, TrackActor(Ret, Class, pPool));
+	return Ret;
+}
+
+int UStevesPooledActorSystem::GetPooledActors(UClass* ActorClass,
+                                              TArrayView<const FTransform> Transforms,
+                                              TArray<AActor*>& OutActors,
+                                              int& OutNumReused)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PooledActorGet);
+
+	OutActors.Reset(Transforms.Num());
+	OutNumReused = 0;
+	if (!ActorClass || Transforms.Num() == 0)
+	{
+		return 0;
+	}
+
+	UClass* Class = ActorClass->GetAuthoritativeClass();
+	FActorPool* pPool = GetPool(Class, true);
+	const int NumWanted = Transforms.Num();
+
+	// Do all the pool bookkeeping up front, before any actor code gets to run
+	while (OutActors.Num() < NumWanted)
+	{
+		AActor* Actor = PopFromPool(pPool);
+		if (!Actor)
+		{
+			break;
+		}
+		OutActors.Add(Actor);
+	}
+	const int NumPopped = OutActors.Num();
+
+	// Work out how many we're allowed to spawn before recycling, so a batch which crosses the max spawns up to it
+	// and only recycles for the rest, same as calling GetPooledActor repeatedly
+	int NumToSpawn = NumWanted - NumPopped;
+	if (pPool->bHasPolicy && pPool->Policy.MaxActors > 0)
+	{
+		NumToSpawn = FMath::Clamp(pPool->Policy.MaxActors - pPool->NumTotal(), 0, NumToSpawn);
+	}
+
+	if (OutActors.Num() + NumToSpawn < NumWanted &&
+		pPool->bHasPolicy && pPool->Policy.OverflowBehaviour == EStevesPoolOverflowBehaviour::RecycleOldest)
+	{
+		// Never recycle actors we've just handed out in this batch
+		int NumRecyclable = pPool->NumActive - NumPopped;
+		while (OutActors.Num() + NumToSpawn < NumWanted && NumRecyclable-- > 0)
+		{
+			AActor* Actor = RecycleOldestActive(pPool);
+			if (!Actor)
+			{
+				break;
+			}
+			MarkActive(pPool, Actor, PooledActorEntries.FindChecked(Actor));
+			++pPool->NumRecycled;
+			OutActors.Add(Actor);
+		}
+	}
+	OutNumReused = OutActors.Num();
+
+	const bool bImplementsPooledActor = pPool->bImplementsPooledActor;
+
+	// Now revive everything we re-used
+	for (int i = 0; i < OutNumReused; ++i)
+	{
+		AActor* Actor = OutActors[i];
+		if (i >= NumPopped && bImplementsPooledActor)
+		{
+			// Recycled, give the actor a chance to clean up from its previous use
+			IStevesPooledActor::Execute_DeactivateOnAddedToPool(Actor);
+		}
+		// Actor callbacks may have changed the pool map, so look up again
+		ReviveActor(Actor, Transforms[i], true, GetPool(Class, true), PooledActorEntries.FindChecked(Actor));
+	}
+
+	// And spawn the shortfall
+	for (int i = 0; i < NumToSpawn; ++i)
+	{
+		AActor* Actor = SpawnNewActor(Class, Transforms[OutNumReused + i]);
+		pPool = GetPool(Class, true);
+		++pPool->NumMisses;
+		INC_DWORD_STAT(STAT_PooledActorMisses);
+		MarkActive(pPool, Actor, TrackActor(Actor, Class, pPool));
+		OutActors.Add(Actor);
+	}
+
+	if (OutActors.Num() < NumWanted)
+	{
+		// Actor callbacks above may have changed the pool map
+		pPool = GetPool(Class, true);
+		pPool->NumRefused += NumWanted - OutActors.Num();
+		INC_DWORD_STAT_BY(STAT_PooledActorRefusals, NumWanted - OutActors.Num());
+		UE_LOG(LogStevesUEHelpers, Verbose, TEXT("UStevesPooledActorSystem: Refused %d of %d requested %s actors, pool is at its maximum"), NumWanted - OutActors.Num(), NumWanted, *Class->GetName());
+	}
+
+	return OutActors.Num();
+}
+
+int UStevesPooledActorSystem::GetPooledActorsForTransforms(TSubclassOf<AActor> ActorClass,
+                                                           const TArray<FTransform>& Transforms,
+                                                           TArray<AActor*>& OutActors,
+                                                           int& NumReused)
+{
+	return GetPooledActors(ActorClass, Transforms, OutActors, NumReused);
+}
+
+bool UStevesPooledActorSystem::IsPoolAtMax(const FActorPool* pPool) const
+{
+	return pPool->bHasPolicy && pPool->Policy.MaxActors > 0 && pPool->NumTotal() >= pPool->Policy.MaxActors;
 }
 
 void UStevesPooledActorSystem::PreWarmActorPool(TSubclassOf<AActor> ActorClass,
@@ -89,29 +415,161 @@ void UStevesPooledActorSystem::PreWarmActorPool(TSubclassOf<AActor> ActorClass,
 	UClass* Class = ActorClass->GetAuthoritativeClass();
 	if (auto pPool = GetPool(Class, true))
 	{
-		for (int i = pPool->Num(); i < Count; ++i)
+		const int Limit = GetPreWarmLimit(pPool, Count);
+		for (int i = pPool->Actors.Num(); i < Limit; ++i)
+		{
+			pPool = SpawnIntoPool(Class);
+		}
+	}
+}
+
+void UStevesPooledActorSystem::PreWarmActorPoolAsync(TSubclassOf<AActor> ActorClass, int Count)
+{
+	if (!ActorClass)
+	{
+		return;
+	}
+
+	UClass* Class = ActorClass->GetAuthoritativeClass();
+	GetPool(Class, true);
+
+	// Merge with any existing request for this class, so we don't double-spawn
+	for (auto& Pending : PendingPreWarms)
+	{
+		if (Pending.Class.Get() == Class)
+		{
+			Pending.TargetCount = FMath::Max(Pending.TargetCount, Count);
+			return;
+		}
+	}
+	PendingPreWarms.Add(FPendingPreWarm(Class, Count));
+}
+
+bool UStevesPooledActorSystem::GetPreWarmStatus(TSubclassOf<AActor> ActorClass, int& NumReady, int& NumQueued)
+{
+	NumReady = 0;
+	NumQueued = 0;
+	if (!ActorClass)
+	{
+		return false;
+	}
+
+	UClass* Class = ActorClass->GetAuthoritativeClass();
+	if (auto pPool = GetPool(Class, false))
+	{
+		NumReady = pPool->Actors.Num();
+	}
+
+	for (const auto& Pending : PendingPreWarms)
+	{
+		if (Pending.Class.Get() == Class)
+		{
+			NumQueued = FMath::Max(0, Pending.TargetCount - NumReady);
+			return true;
+		}
+	}
+	return false;
+}
+
+UStevesPooledActorSystem::FActorPool* UStevesPooledActorSystem::SpawnIntoPool(UClass* Class)
+{
+	auto Actor = SpawnNewActor(Class, FTransform(StorageLocation));
+	// Spawning can run arbitrary code which may create other pools, so only look up the pool afterwards
+	FActorPool* pPool = GetPool(Class, true);
+	++pPool->NumPreWarmed;
+	INC_DWORD_STAT(STAT_PooledActorPreWarmSpawns);
+	FPooledActorEntry& Entry = TrackActor(Actor, Class, pPool);
+	PushToPool(pPool, Actor, Entry);
+	DisableActor(Actor, pPool, Entry);
+	return pPool;
+}
+
+int UStevesPooledActorSystem::GetPreWarmLimit(const FActorPool* pPool, int Count) const
+{
+	if (pPool->bHasPolicy && pPool->Policy.MaxActors > 0)
+	{
+		return FMath::Min(Count, pPool->Policy.MaxActors - pPool->NumActive);
+	}
+	return Count;
+}
+
+bool UStevesPooledActorSystem::IsPreWarmPending(const UClass* Class) const
+{
+	for (const auto& Pending : PendingPreWarms)
+	{
+		if (Pending.Class.Get() == Class)
 		{
-			auto Actor = SpawnNewActor(Class, StorageLocation, FRotator::ZeroRotator);
-			DisableActor(Actor);
-			pPool->PushLast(TObjectPtr<AActor>(Actor));
+			return true;
 		}
 	}
+	return false;
 }
 
-AActor* UStevesPooledActorSystem::SpawnNewActor(UClass* Class, const FVector& Location, const FRotator& Rotation)
+void UStevesPooledActorSystem::TickPreWarm()
+{
+	const double EndTime = FPlatformTime::Seconds() + PreWarmMaxFrameTimeMs * 0.001;
+	int SpawnsLeft = FMath::Max(1, PreWarmMaxSpawnsPerFrame);
+
+	while (PendingPreWarms.Num() > 0)
+	{
+		// Always work on the oldest request first so callers get their pools in the order they asked
+		FPendingPreWarm& Pending = PendingPreWarms[0];
+		UClass* Class = Pending.Class.Get();
+		auto pPool = Class ? GetPool(Class, true) : nullptr;
+		if (!pPool)
+		{
+			// Class has gone away
+			PendingPreWarms.RemoveAt(0);
+			continue;
+		}
+
+		const int Target = GetPreWarmLimit(pPool, Pending.TargetCount);
+		bool bSpawned = false;
+		while (pPool->Actors.Num() < Target && SpawnsLeft > 0)
+		{
+			pPool = SpawnIntoPool(Class);
+			bSpawned = true;
+			--SpawnsLeft;
+			if (FPlatformTime::Seconds() >= EndTime)
+			{
+				SpawnsLeft = 0;
+			}
+		}
+
+		const int NumReady = pPool->Actors.Num();
+		if (bSpawned)
+		{
+			OnPreWarmProgress.Broadcast(Class, NumReady, Target);
+		}
+
+		if (NumReady >= Target)
+		{
+			// Remove before broadcast in case listeners queue more work
+			PendingPreWarms.RemoveAt(0);
+			OnPreWarmComplete.Broadcast(Class);
+		}
+
+		if (SpawnsLeft <= 0)
+		{
+			break;
+		}
+	}
+}
+
+AActor* UStevesPooledActorSystem::SpawnNewActor(UClass* Class, const FTransform& Transform)
 {
 	FActorSpawnParameters Params;
 	Params.Name = FName(FString::Printf(TEXT("Pooled_%s"), *Class->GetName()));
 	Params.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
 	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-	AActor* Ret = GetWorld()->SpawnActor(Class, &Location, &Rotation, Params);
+	AActor* Ret = GetWorld()->SpawnActor(Class, &Transform, Params);
 #if WITH_EDITOR
 	Ret->SetActorLabel(Ret->GetName());
 #endif
 	return Ret;
 }
 
-void UStevesPooledActorSystem::DisableActor(AActor* Actor)
+void UStevesPooledActorSystem::DisableActor(AActor* Actor, const FActorPool* pPool, FPooledActorEntry& Entry)
 {
 	if (Actor)
 	{
@@ -123,68 +581,390 @@ void UStevesPooledActorSystem::DisableActor(AActor* Actor)
 			Prim->ResetSceneVelocity();
 #endif
 		}
-		Actor->SetActorLocation(StorageLocation, false, nullptr, ETeleportType::ResetPhysics);
 
-		if (Actor->Implements<UStevesPooledActor>())
+		bool bNeedsTeleport = true;
+		if (pPool->bHasDeactivationProfile)
+		{
+			const FStevesPooledActorDeactivationProfile& Profile = pPool->DeactivationProfile;
+			if (Profile.bDisableActorTick && Actor->IsActorTickEnabled())
+			{
+				Actor->SetActorTickEnabled(false);
+				Entry.bRestoreActorTick = true;
+			}
+			if (Profile.bDisableCollision)
+			{
+				if (Actor->GetActorEnableCollision())
+				{
+					Actor->SetActorEnableCollision(false);
+					Entry.bRestoreCollision = true;
+				}
+				// Hidden & no collision, so it doesn't matter where it is
+				bNeedsTeleport = false;
+			}
+			if (Profile.bDisableComponentTick || Profile.bDestroyRenderState)
+			{
+				Actor->ForEachComponent(false, [&Profile, &Entry](UActorComponent* Comp)
+				{
+					if (Profile.bDisableComponentTick && Comp->IsComponentTickEnabled())
+					{
+						Comp->SetComponentTickEnabled(false);
+						Entry.RestoreTickComponents.Add(Comp);
+					}
+					if (Profile.bDestroyRenderState)
+					{
+						auto Prim = Cast<UPrimitiveComponent>(Comp);
+						if (Prim && Prim->IsVisible())
+						{
+							// Invisible primitives are not added to the scene
+							Prim->SetVisibility(false);
+							Entry.RestoreVisibleComponents.Add(Prim);
+						}
+					}
+				});
+			}
+		}
+
+		if (bNeedsTeleport)
+		{
+			Actor->SetActorLocation(StorageLocation, false, nullptr, ETeleportType::ResetPhysics);
+		}
+
+		if (pPool->bImplementsPooledActor)
 		{
 			IStevesPooledActor::Execute_DeactivateOnAddedToPool(Actor);
 		}
 	}
 }
 
-void UStevesPooledActorSystem::ReviveActor(AActor* Actor, const FVector& Location, const FRotator& Rotator)
+void UStevesPooledActorSystem::ReviveActor(AActor* Actor,
+                                           const FTransform& Transform,
+                                           bool bApplyScale,
+                                           const FActorPool* pPool,
+                                           FPooledActorEntry& Entry)
 {
 	if (Actor)
 	{
+		// Everything below can run actor code (e.g. overlaps) which may get or spawn pooled actors, which can
+		// reallocate the entry & pool maps. So take what we need from them now, and don't touch them afterwards
+		const bool bImplementsPooledActor = pPool->bImplementsPooledActor;
+		const bool bRestoreCollision = Entry.bRestoreCollision;
+		const bool bRestoreActorTick = Entry.bRestoreActorTick;
+		const TArray<TWeakObjectPtr<UActorComponent>> RestoreTickComponents = MoveTemp(Entry.RestoreTickComponents);
+		const TArray<TWeakObjectPtr<UPrimitiveComponent>> RestoreVisibleComponents = MoveTemp(Entry.RestoreVisibleComponents);
+		Entry.bRestoreCollision = false;
+		Entry.bRestoreActorTick = false;
+		Entry.RestoreTickComponents.Reset();
+		Entry.RestoreVisibleComponents.Reset();
+
+		for (const auto& Prim : RestoreVisibleComponents)
+		{
+			if (Prim.IsValid())
+			{
+				Prim->SetVisibility(true);
+			}
+		}
 		Actor->SetActorHiddenInGame(false);
 		// We don't enable physics, because caller may not want that. 
-		Actor->SetActorLocation(Location, false, nullptr, ETeleportType::ResetPhysics);
-		Actor->SetActorRotation(Rotator, ETeleportType::ResetPhysics);
-		
-		if (Actor->Implements<UStevesPooledActor>())
+		if (bApplyScale)
+		{
+			Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		}
+		else
+		{
+			Actor->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+		}
+		// Collision is restored after the move so overlaps are only generated at the new location
+		if (bRestoreCollision)
+		{
+			Actor->SetActorEnableCollision(true);
+		}
+		if (bRestoreActorTick)
+		{
+			Actor->SetActorTickEnabled(true);
+		}
+		for (const auto& Comp : RestoreTickComponents)
+		{
+			if (Comp.IsValid())
+			{
+				Comp->SetComponentTickEnabled(true);
+			}
+		}
+
+		if (bImplementsPooledActor)
 		{
 			IStevesPooledActor::Execute_ReactivateOnRemovedFromPool(Actor);
 		}
 	}
 }
 
+void UStevesPooledActorSystem::TickTrim(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	int TrimsLeft = TrimMaxActorsPerFrame;
+	// Destroying runs actor code, which could change the pool map while we're iterating it
+	TArray<AActor*, TInlineAllocator<16>> ActorsToDestroy;
+
+	for (auto& Pair : Pools)
+	{
+		FActorPool& Pool = Pair.Value;
+		if (!Pool.bHasPolicy || Pool.Policy.IdleTrimDelay <= 0)
+		{
+			continue;
+		}
+
+		// Only trim once usage has stayed below the high-water mark for a while, and never while pre-warming
+		if (Now - Pool.HighWaterTime < Pool.Policy.IdleTrimDelay || IsPreWarmPending(Pair.Key))
+		{
+			Pool.TrimAccumulator = 0;
+			continue;
+		}
+
+		// The old peak no longer reflects demand, so let it decay to current usage
+		Pool.HighWaterActive = Pool.NumActive;
+		const int TargetPooled = FMath::Max(Pool.Policy.MinPooled, Pool.Policy.TargetHeadroom);
+		const int Surplus = Pool.Actors.Num() - TargetPooled;
+		if (Surplus <= 0)
+		{
+			Pool.TrimAccumulator = 0;
+			continue;
+		}
+
+		Pool.TrimAccumulator = FMath::Min(Pool.TrimAccumulator + DeltaTime * Pool.Policy.IdleTrimRate, (float)Surplus);
+		const int NumToTrim = FMath::Min(FMath::FloorToInt(Pool.TrimAccumulator), TrimsLeft);
+		if (NumToTrim > 0)
+		{
+			// Trim from the front, the least recently used end. Must preserve the order of the rest, so can't
+			// use RemoveFromPoolAt which swaps the most recently used actor to the front
+			for (int i = 0; i < NumToTrim; ++i)
+			{
+				AActor* Actor = Pool.Actors[i];
+				UntrackActor(Actor);
+				ActorsToDestroy.Add(Actor);
+			}
+			Pool.Actors.RemoveAt(0, NumToTrim);
+			DEC_DWORD_STAT_BY(STAT_PooledActorsPooled, NumToTrim);
+			for (int32 i = 0; i < Pool.Actors.Num(); ++i)
+			{
+				if (auto pEntry = PooledActorEntries.Find(Pool.Actors[i]))
+				{
+					pEntry->PoolIndex = i;
+				}
+			}
+		}
+		Pool.TrimAccumulator -= NumToTrim;
+		TrimsLeft -= NumToTrim;
+
+		if (TrimsLeft <= 0)
+		{
+			break;
+		}
+	}
+
+	DestroyActors(ActorsToDestroy);
+}
+
+void UStevesPooledActorSystem::SetPoolPolicy(TSubclassOf<AActor> ActorClass, const FStevesPooledActorPolicy& Policy)
+{
+	if (!ActorClass)
+	{
+		return;
+	}
+
+	FActorPool* pPool = GetPool(ActorClass->GetAuthoritativeClass(), true);
+	const bool bWasTrimming = pPool->bHasPolicy && pPool->Policy.IdleTrimDelay > 0;
+	const bool bIsTrimming = Policy.IdleTrimDelay > 0;
+	NumTrimmingPools += (int)bIsTrimming - (int)bWasTrimming;
+
+	pPool->Policy = Policy;
+	pPool->bHasPolicy = true;
+	// Give the pool a full idle period under the new policy before trimming
+	pPool->HighWaterTime = GetWorld()->GetTimeSeconds();
+	if (Policy.OverflowBehaviour != EStevesPoolOverflowBehaviour::RecycleOldest)
+	{
+		pPool->ActiveOrder.Empty();
+	}
+}
+
+void UStevesPooledActorSystem::ClearPoolPolicy(TSubclassOf<AActor> ActorClass)
+{
+	if (!ActorClass)
+	{
+		return;
+	}
+
+	if (auto pPool = GetPool(ActorClass->GetAuthoritativeClass(), false))
+	{
+		if (pPool->bHasPolicy && pPool->Policy.IdleTrimDelay > 0)
+		{
+			--NumTrimmingPools;
+		}
+		pPool->bHasPolicy = false;
+		pPool->Policy = FStevesPooledActorPolicy();
+		pPool->ActiveOrder.Empty();
+	}
+}
+
+bool UStevesPooledActorSystem::GetPoolPolicy(TSubclassOf<AActor> ActorClass, FStevesPooledActorPolicy& OutPolicy)
+{
+	if (ActorClass)
+	{
+		if (auto pPool = GetPool(ActorClass->GetAuthoritativeClass(), false))
+		{
+			if (pPool->bHasPolicy)
+			{
+				OutPolicy = pPool->Policy;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void UStevesPooledActorSystem::SetPoolDeactivationProfile(TSubclassOf<AActor> ActorClass,
+	const FStevesPooledActorDeactivationProfile& Profile)
+{
+	if (ActorClass)
+	{
+		FActorPool* pPool = GetPool(ActorClass->GetAuthoritativeClass(), true);
+		pPool->DeactivationProfile = Profile;
+		pPool->bHasDeactivationProfile = true;
+	}
+}
+
+void UStevesPooledActorSystem::ClearPoolDeactivationProfile(TSubclassOf<AActor> ActorClass)
+{
+	if (ActorClass)
+	{
+		if (auto pPool = GetPool(ActorClass->GetAuthoritativeClass(), false))
+		{
+			pPool->bHasDeactivationProfile = false;
+			pPool->DeactivationProfile = FStevesPooledActorDeactivationProfile();
+		}
+	}
+}
+
+void UStevesPooledActorSystem::GetPoolUsage(TSubclassOf<AActor> ActorClass, int& NumActive, int& NumPooled, int& HighWater)
+{
+	NumActive = NumPooled = HighWater = 0;
+	if (ActorClass)
+	{
+		if (auto pPool = GetPool(ActorClass->GetAuthoritativeClass(), false))
+		{
+			NumActive = pPool->NumActive;
+			NumPooled = pPool->Actors.Num();
+			HighWater = pPool->HighWaterActive;
+		}
+	}
+}
+
+void UStevesPooledActorSystem::DumpStats(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("Actor pools for %s:"), *GetWorld()->GetName());
+	for (const auto& Pair : Pools)
+	{
+		const FActorPool& Pool = Pair.Value;
+		const uint32 NumRequests = Pool.NumHits + Pool.NumRecycled + Pool.NumMisses + Pool.NumRefused;
+		const float HitRate = NumRequests > 0 ? 100.0f * (Pool.NumHits + Pool.NumRecycled) / NumRequests : 0.0f;
+		Ar.Logf(TEXT("  %s: %d in use, %d pooled, high-water %d | %u requests, %.1f%% hit rate, %u hits, %u recycled, %u misses (spawned), %u refused, %u pre-warmed"),
+			*GetNameSafe(Pair.Key),
+			Pool.NumActive,
+			Pool.Actors.Num(),
+			Pool.HighWaterActive,
+			NumRequests,
+			HitRate,
+			Pool.NumHits,
+			Pool.NumRecycled,
+			Pool.NumMisses,
+			Pool.NumRefused,
+			Pool.NumPreWarmed);
+	}
+}
+
 void UStevesPooledActorSystem::DrainActorPool(TSubclassOf<AActor> ActorClass, int NumberToKeep)
 {
 	UClass* Class = ActorClass->GetAuthoritativeClass();
 	if (auto pPool = GetPool(Class, false))
 	{
-		DrainPool(pPool, NumberToKeep);
+		TArray<AActor*> ActorsToDestroy;
+		DrainPool(pPool, NumberToKeep, ActorsToDestroy);
+		DestroyActors(ActorsToDestroy);
+	}
+}
+
+void UStevesPooledActorSystem::DrainPool(FActorPool* pPool, int NumberToKeep, TArray<AActor*>& OutActorsToDestroy)
+{
+	while (pPool->Actors.Num() > NumberToKeep)
+	{
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+		AActor* Actor = pPool->Actors.Pop(EAllowShrinking::No);
+#else
+		AActor* Actor = pPool->Actors.Pop(false);
+#endif
+		DEC_DWORD_STAT(STAT_PooledActorsPooled);
+		// Untrack first so that OnDestroyed doesn't try to remove it from the pool again
+		UntrackActor(Actor);
+		OutActorsToDestroy.Add(Actor);
 	}
 }
 
-void UStevesPooledActorSystem::DrainPool(TDeque<TObjectPtr<AActor>>* pPool, int NumberToKeep)
+void UStevesPooledActorSystem::DestroyActors(TConstArrayView<AActor*> Actors)
 {
-	while (pPool->Num() > NumberToKeep)
+	for (AActor* Actor : Actors)
 	{
-		TObjectPtr<AActor> Actor = nullptr;
-		if(pPool->TryPopLast(Actor))
+		if (IsValid(Actor))
 		{
 			Actor->Destroy();
 		}
-		else
-		{
-			// Should never happen but just in case, prevent infinite loop
-			break;
-		}
 	}
 }
 
 void UStevesPooledActorSystem::DrainAllActorPools()
 {
+	// Destroying runs actor code, which could change the pool map while we're iterating it
+	TArray<AActor*> ActorsToDestroy;
 	for (auto& Pair : Pools)
 	{
-		DrainPool(&Pair.Value, 0);
+		DrainPool(&Pair.Value, 0, ActorsToDestroy);
 	}
+	DestroyActors(ActorsToDestroy);
 }
 
 void UStevesPooledActorSystem::Deinitialize()
 {
 	Super::Deinitialize();
 
+	PendingPreWarms.Empty();
 	DrainAllActorPools();
+	for (const auto& Pair : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_PooledActorsActive, Pair.Value.NumActive);
+	}
+	PooledActorEntries.Empty();
+	Pools.Empty();
+	NumTrimmingPools = 0;
+}
+
+void UStevesPooledActorSystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_PooledActorTick);
+
+	if (PendingPreWarms.Num() > 0)
+	{
+		TickPreWarm();
+	}
+	if (NumTrimmingPools > 0)
+	{
+		TickTrim(DeltaTime);
+	}
+}
+
+bool UStevesPooledActorSystem::IsTickable() const
+{
+	return PendingPreWarms.Num() > 0 || NumTrimmingPools > 0;
+}
+
+TStatId UStevesPooledActorSystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStevesPooledActorSystem, STATGROUP_Tickables);
 }
@@ -0,0 +1,70 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesRandomStreamRegistry.h"
+
+namespace
+{
+	std::atomic<uint32> NextRegistryId {1};
+
+	/// Salt for thread stream seeds, so they're unrelated to any task seed with the default salt
+	constexpr uint32 ThreadStreamSalt = 0x7468726du;
+
+	struct FThreadStream
+	{
+		uint32 Generation = 0;
+		FStevesBalancedRandomStream Stream;
+	};
+
+	/// Per-thread streams keyed by registry id, so a thread can use several registries without resetting its streams.
+	/// Held by pointer so the references we return survive the map growing. Threads usually only ever see a handful
+	/// of registries, so entries for destroyed ones are left until the thread exits.
+	thread_local TMap<uint32, TUniquePtr<FThreadStream>> ThreadStreams;
+}
+
+FStevesRandomStreamRegistry::FStevesRandomStreamRegistry()
+	: FStevesRandomStreamRegistry(0)
+{
+}
+
+FStevesRandomStreamRegistry::FStevesRandomStreamRegistry(uint32 MasterSeed, uint32 InTaskStride)
+	: Id(NextRegistryId.fetch_add(1, std::memory_order_relaxed))
+{
+	Initialize(MasterSeed, InTaskStride);
+}
+
+void FStevesRandomStreamRegistry::Initialize(uint32 MasterSeed, uint32 InTaskStride)
+{
+	Master.Initialize(MasterSeed);
+	TaskStride = FMath::Max(1u, InTaskStride);
+	NextThreadSlot.store(0, std::memory_order_relaxed);
+	Generation.fetch_add(1, std::memory_order_release);
+}
+
+FStevesBalancedRandomStream FStevesRandomStreamRegistry::GetTaskStream(uint32 TaskIndex) const
+{
+	FStevesBalancedRandomStream Ret = Master;
+	Ret.SeekTo((uint64)TaskIndex * TaskStride);
+	return Ret;
+}
+
+uint32 FStevesRandomStreamRegistry::GetTaskSeed(uint32 TaskIndex, uint32 Salt) const
+{
+	return MurmurFinalize32(HashCombineFast(MurmurFinalize32(Master.GetInitialSeed()), HashCombineFast(TaskIndex, Salt)));
+}
+
+FStevesBalancedRandomStream& FStevesRandomStreamRegistry::GetThreadStream()
+{
+	const uint32 CurrentGeneration = Generation.load(std::memory_order_acquire);
+	TUniquePtr<FThreadStream>& ThreadStream = ThreadStreams.FindOrAdd(Id);
+	if (!ThreadStream.IsValid() || ThreadStream->Generation != CurrentGeneration)
+	{
+		if (!ThreadStream.IsValid())
+		{
+			ThreadStream = MakeUnique<FThreadStream>();
+		}
+		ThreadStream->Generation = CurrentGeneration;
+		const uint32 Slot = NextThreadSlot.fetch_add(1, std::memory_order_relaxed);
+		ThreadStream->Stream.Initialize(GetTaskSeed(Slot, ThreadStreamSalt));
+	}
+	return ThreadStream->Stream;
+}
@@ -2,49 +2,162 @@
 // Released under the MIT license
 #include "StevesTextureRenderTargetPool.h"
 
+#include "StevesPoolStats.h"
 #include "StevesUEHelpers.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "UObject/UObjectGlobals.h"
 #include "UObject/Package.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render Target Pool Hits"), STAT_RenderTargetPoolHits, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render Target Pool Misses"), STAT_RenderTargetPoolMisses, STATGROUP_StevesPools);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render Target Pool Evictions"), STAT_RenderTargetPoolEvictions, STATGROUP_StevesPools);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Render Targets Reserved"), STAT_RenderTargetPoolReserved, STATGROUP_StevesPools);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Render Targets Unreserved"), STAT_RenderTargetPoolUnreserved, STATGROUP_StevesPools);
+DECLARE_MEMORY_STAT(TEXT("Render Target Pool Memory"), STAT_RenderTargetPoolMemory, STATGROUP_StevesPools);
+
 FStevesTextureRenderTargetReservation::~FStevesTextureRenderTargetReservation()
 {
 	//UE_LOG(LogStevesUEHelpers, Log, TEXT("FStevesTextureRenderTargetReservation: destruction"));
 	if (ParentPool.IsValid() && Texture.IsValid())
 	{
-		ParentPool.Pin()->ReleaseReservation(Texture.Get());
+		ParentPool.Pin()->ReleaseReservation(Texture.Get(), this);
 		Texture = nullptr;
 	}
 }
 
-void FStevesTextureRenderTargetPool::ReleaseReservation(UTextureRenderTarget2D* Tex)
+void FStevesTextureRenderTargetPool::ReleaseReservation(UTextureRenderTarget2D* Tex,
+                                                        const FStevesTextureRenderTargetReservation* Reservation)
 {
 	if (!Tex)
 	{
 		UE_LOG(LogStevesUEHelpers, Warning, TEXT("FStevesTextureRenderTargetPool: Attempted to release a null texture"));
 		return;
 	}
-	
-	for (int i = 0; i < Reservations.Num(); ++i)
+
+	const FReservationInfo* R = Reservations.Find(Tex);
+	if (R && R->Reservation == Reservation)
 	{
-		const FReservationInfo& R = Reservations[i];
-		if (R.Texture.IsValid() && R.Texture.Get() == Tex)
+		UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Released texture reservation on %s"), *Tex->GetName());
+		ReservationsByOwner.RemoveSingle(R->Owner, Tex);
+		UnreserveTexture(Tex, *R);
+		Reservations.Remove(Tex);
+		return;
+	}
+
+	UE_LOG(LogStevesUEHelpers, Warning, TEXT("FStevesTextureRenderTargetPool: Attempted to release a reservation on %s that was not found"), *Tex->GetName());
+
+}
+
+void FStevesTextureRenderTargetPool::UnreserveTexture(const UTextureRenderTarget2D* Tex, const FReservationInfo& Info)
+{
+	UTextureRenderTarget2D* MutableTex = const_cast<UTextureRenderTarget2D*>(Tex);
+	AddUnreservedTexture(Info.Key, MutableTex);
+	ReservedTextures.Remove(MutableTex);
+	DEC_DWORD_STAT(STAT_RenderTargetPoolReserved);
+	EnforceMemoryBudget();
+}
+
+void FStevesTextureRenderTargetPool::AddUnreservedTexture(const FTextureKey& Key, UTextureRenderTarget2D* Tex)
+{
+	const double Now = FPlatformTime::Seconds();
+	UnreservedTextures.Add(Key, Tex);
+	UnreservedTimes.Add(Tex, Now);
+	UnreservedOrder.PushLast({Tex, Now});
+	INC_DWORD_STAT(STAT_RenderTargetPoolUnreserved);
+
+	// Records for textures that have since been reserved again are only discarded when they reach the front, so
+	// compact occasionally to stop the queue growing without bound
+	if (UnreservedOrder.Num() > UnreservedTimes.Num() * 2 + 32)
+	{
+		TDeque<FUnreservedRecord> Kept;
+		for (const auto& Record : UnreservedOrder)
 		{
-			UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Released texture reservation on %s"), *Tex->GetName());
-			UnreservedTextures.Add(R.Key, Tex);
-			Reservations.RemoveAtSwap(i);
-			ReservedTextures.Remove(Tex);
-			
-			return;
+			const double* pTime = UnreservedTimes.Find(Record.Texture);
+			if (pTime && *pTime == Record.Time)
+			{
+				Kept.PushLast(Record);
+			}
 		}
+		UnreservedOrder = MoveTemp(Kept);
 	}
+}
 
-	UE_LOG(LogStevesUEHelpers, Warning, TEXT("FStevesTextureRenderTargetPool: Attempted to release a reservation on %s that was not found"), *Tex->GetName());
+bool FStevesTextureRenderTargetPool::GetOldestUnreservedTexture(FUnreservedRecord& OutRecord)
+{
+	while (UnreservedOrder.Num() > 0)
+	{
+		const FUnreservedRecord& Record = UnreservedOrder.First();
+		const double* pTime = UnreservedTimes.Find(Record.Texture);
+		if (pTime && *pTime == Record.Time)
+		{
+			OutRecord = Record;
+			return true;
+		}
+		UnreservedOrder.PopFirst();
+	}
+	return false;
+}
 
+bool FStevesTextureRenderTargetPool::EvictOldestUnreservedTexture()
+{
+	FUnreservedRecord Record;
+	if (!GetOldestUnreservedTexture(Record))
+	{
+		return false;
+	}
+
+	UnreservedOrder.PopFirst();
+	UnreservedTimes.Remove(Record.Texture);
+	UTextureRenderTarget2D* Tex = const_cast<UTextureRenderTarget2D*>(Record.Texture);
+	// Unreserved textures are always keyed by their real size
+	UnreservedTextures.RemoveSingle(FTextureKey {FIntPoint(Tex->SizeX, Tex->SizeY), Tex->RenderTargetFormat}, Tex);
+	DEC_DWORD_STAT(STAT_RenderTargetPoolUnreserved);
+	++NumEvictions;
+	INC_DWORD_STAT(STAT_RenderTargetPoolEvictions);
+	UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Evicted unreserved texture %s"), *Tex->GetName());
+	ReleaseTexture(Tex);
+	return true;
+}
+
+void FStevesTextureRenderTargetPool::EnforceMemoryBudget()
+{
+	if (MemoryBudget == 0)
+	{
+		return;
+	}
+
+	while (TotalMemory > MemoryBudget && EvictOldestUnreservedTexture())
+	{
+	}
+}
+
+void FStevesTextureRenderTargetPool::SetMemoryBudget(uint64 Bytes)
+{
+	MemoryBudget = Bytes;
+	EnforceMemoryBudget();
+}
+
+void FStevesTextureRenderTargetPool::EvictIdleTextures()
+{
+	if (IdleEvictTime <= 0)
+	{
+		return;
+	}
+
+	const double Cutoff = FPlatformTime::Seconds() - IdleEvictTime;
+	FUnreservedRecord Record;
+	while (GetOldestUnreservedTexture(Record) && Record.Time <= Cutoff)
+	{
+		EvictOldestUnreservedTexture();
+	}
 }
 
 FStevesTextureRenderTargetPool::~FStevesTextureRenderTargetPool()
 {
+	if (PendingTickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PendingTickHandle);
+	}
 	DrainPool(true);
 }
 
@@ -65,56 +178,325 @@ FString FStevesTextureRenderTargetPool::GetReferencerName() const
 FStevesTextureRenderTargetReservationPtr FStevesTextureRenderTargetPool::ReserveTexture(FIntPoint Size,
                                                                                         ETextureRenderTargetFormat Format, const UObject* Owner)
 {
-	const FTextureKey Key {Size, Format};
-	UTextureRenderTarget2D* Tex = nullptr;
-	if (auto Pooled = UnreservedTextures.Find(Key))
+	return ReserveTextureInternal(Size, Format, Owner, false);
+}
+
+FStevesTextureRenderTargetReservationPtr FStevesTextureRenderTargetPool::ReserveTextureAsync(FIntPoint Size,
+	ETextureRenderTargetFormat Format,
+	const UObject* Owner,
+	FOnStevesTextureRenderTargetReady OnReady)
+{
+	auto Ret = ReserveTextureInternal(Size, Format, Owner, true);
+	if (Ret.IsValid() && Ret->bPending)
 	{
-		Tex = *Pooled;
-		UnreservedTextures.RemoveSingle(Key, Tex);
+		PendingReservations.Add({Ret, OnReady});
+		StartPendingTicker();
+	}
+	else if (Ret.IsValid())
+	{
+		OnReady.ExecuteIfBound(Ret);
+	}
+	return Ret;
+}
+
+void FStevesTextureRenderTargetPool::StartPendingTicker()
+{
+	if (!PendingTickHandle.IsValid())
+	{
+		PendingTickHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateSP(this, &FStevesTextureRenderTargetPool::TickPending));
+	}
+}
+
+bool FStevesTextureRenderTargetPool::TickPending(float DeltaTime)
+{
+	for (auto It = PendingTextures.CreateIterator(); It; ++It)
+	{
+		if (It.Value().IsFenceComplete())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Collect first, callbacks may make more reservations
+	TArray<TPair<FStevesTextureRenderTargetReservationPtr, FOnStevesTextureRenderTargetReady>> Ready;
+	for (int i = 0; i < PendingReservations.Num(); ++i)
+	{
+		auto Res = PendingReservations[i].Reservation.Pin();
+		if (Res.IsValid() && Res->Texture.IsValid() && PendingTextures.Contains(Res->Texture.Get()))
+		{
+			continue;
+		}
+		if (Res.IsValid())
+		{
+			Res->bPending = false;
+			Ready.Emplace(Res, MoveTemp(PendingReservations[i].OnReady));
+		}
+		// Can't use RemoveAtSwap because callbacks should be in reservation order
+		PendingReservations.RemoveAt(i);
+		--i;
+	}
+
+	for (auto& Pair : Ready)
+	{
+		Pair.Value.ExecuteIfBound(Pair.Key);
+	}
+
+	if (PendingTextures.Num() == 0 && PendingReservations.Num() == 0)
+	{
+		PendingTickHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+UTextureRenderTarget2D* FStevesTextureRenderTargetPool::CreateTexture(const FTextureKey& Key, bool bAsync)
+{
+	// Texture owner should be a valid UObject that will determine lifespan
+	UObject* TextureOwner = PoolOwner.IsValid() ? PoolOwner.Get() : GetTransientPackage();
+	UTextureRenderTarget2D* Tex = NewObject<UTextureRenderTarget2D>(TextureOwner);
+	Tex->RenderTargetFormat = Key.Format;
+	// This only enqueues the resource init on the render thread
+	Tex->InitAutoFormat(Key.Size.X, Key.Size.Y);
+	if (bAsync)
+	{
+		PendingTextures.Add(Tex).BeginFence();
+	}
+	else
+	{
+		Tex->UpdateResourceImmediate(true);
+	}
+
+	const uint64 TexMemory = GetTextureMemorySize(Tex);
+	TotalMemory += TexMemory;
+	INC_MEMORY_STAT_BY(STAT_RenderTargetPoolMemory, TexMemory);
+
+	UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Created new texture %s"), *Tex->GetName());
+	return Tex;
+}
+
+int32 FStevesTextureRenderTargetPool::PreWarm(TConstArrayView<FStevesTextureRenderTargetPreWarmSpec> Specs)
+{
+	int32 NumCreated = 0;
+	for (const auto& Spec : Specs)
+	{
+		if (Spec.Size.X <= 0 || Spec.Size.Y <= 0)
+		{
+			continue;
+		}
+
+		const FTextureKey Key {GetPooledSize(Spec.Size), Spec.Format};
+		const uint64 Bytes = EstimateTextureMemorySize(Key.Size, Key.Format);
+		for (int32 i = 0; i < Spec.Count; ++i)
+		{
+			// Don't evict to make room, that would just evict what we pre-warmed
+			if ((MaxMemory > 0 && TotalMemory + Bytes > MaxMemory) ||
+				(MemoryBudget > 0 && TotalMemory + Bytes > MemoryBudget))
+			{
+				UE_LOG(LogStevesUEHelpers, Warning, TEXT("FStevesTextureRenderTargetPool: Stopped pre-warming pool %s after %d textures, memory limit reached"), *Name.ToString(), NumCreated);
+				return NumCreated;
+			}
+
+			AddUnreservedTexture(Key, CreateTexture(Key, true));
+			++NumCreated;
+		}
+	}
+
+	if (PendingTextures.Num() > 0)
+	{
+		StartPendingTicker();
+	}
+	return NumCreated;
+}
+
+FStevesTextureRenderTargetReservationPtr FStevesTextureRenderTargetPool::ReserveTextureInternal(FIntPoint Size,
+	ETextureRenderTargetFormat Format,
+	const UObject* Owner,
+	bool bAsync)
+{
+	const FTextureKey RequestKey {GetPooledSize(Size), Format};
+	UTextureRenderTarget2D* Tex = TakeUnreservedTexture(RequestKey, Size);
+	if (Tex)
+	{
+		++NumHits;
+		INC_DWORD_STAT(STAT_RenderTargetPoolHits);
+		DEC_DWORD_STAT(STAT_RenderTargetPoolUnreserved);
 		UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Re-used pooled texture %s"), *Tex->GetName());
+
+		// Pre-warmed textures may not be ready yet; that's fine for async but otherwise we have to wait
+		if (!bAsync)
+		{
+			FRenderCommandFence Fence;
+			if (PendingTextures.RemoveAndCopyValue(Tex, Fence))
+			{
+				Fence.Wait();
+			}
+		}
 	}
 	else if (Size.X > 0 && Size.Y > 0)
 	{
-		// No existing texture, so create
-		// Texture owner should be a valid UObject that will determine lifespan
-		UObject* TextureOwner = PoolOwner.IsValid() ? PoolOwner.Get() : GetTransientPackage();
-		Tex = NewObject<UTextureRenderTarget2D>(TextureOwner);
-		Tex->RenderTargetFormat = Format;
-		Tex->InitAutoFormat(Size.X, Size.Y);
-		Tex->UpdateResourceImmediate(true);
+		if (!MakeRoomFor(EstimateTextureMemorySize(RequestKey.Size, Format)))
+		{
+			UE_LOG(LogStevesUEHelpers, Warning, TEXT("FStevesTextureRenderTargetPool: Unable to create %dx%d texture in pool %s, would exceed memory cap"), RequestKey.Size.X, RequestKey.Size.Y, *Name.ToString());
+			return nullptr;
+		}
 
-		UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Created new texture %s"), *Tex->GetName());
+		// No existing texture, so create
+		Tex = CreateTexture(RequestKey, bAsync);
+		++NumMisses;
+		INC_DWORD_STAT(STAT_RenderTargetPoolMisses);
+		EnforceMemoryBudget();
 	}
 
-	// Record reservation
-	Reservations.Add(FReservationInfo(Key, Owner, Tex));
+	if (!Tex)
+	{
+		// Nothing to reserve (invalid size)
+		return MakeShared<FStevesTextureRenderTargetReservation>(nullptr, this->AsShared(), Owner, Size);
+	}
 
 	// Reservation doesn't keep the texture alive; if caller doesn't hold a strong pointer to it, it'll be destroyed
 	// So we need to hold it ourselves
 	ReservedTextures.Add(Tex);
-	
-	return MakeShared<FStevesTextureRenderTargetReservation>(Tex, this->AsShared(), Owner);
+	INC_DWORD_STAT(STAT_RenderTargetPoolReserved);
+
+	auto Ret = MakeShared<FStevesTextureRenderTargetReservation>(Tex, this->AsShared(), Owner, Size);
+
+	// Record reservation against the texture's real size, so it's returned to the right place
+	FReservationInfo& Info = Reservations.Emplace(Tex, FReservationInfo(FTextureKey {FIntPoint(Tex->SizeX, Tex->SizeY), Format}, Owner));
+	Info.Reservation = &Ret.Get();
+	ReservationsByOwner.Add(Info.Owner, Tex);
+
+	Ret->bPending = PendingTextures.Contains(Tex);
+
+	return Ret;
+}
+
+FIntPoint FStevesTextureRenderTargetPool::GetPooledSize(FIntPoint RequestedSize) const
+{
+	if (RequestedSize.X <= 0 || RequestedSize.Y <= 0)
+	{
+		return RequestedSize;
+	}
+
+	switch (Sizing)
+	{
+	case EStevesTextureRenderTargetSizing::PowerOfTwo:
+		return FIntPoint(FMath::RoundUpToPowerOfTwo(RequestedSize.X), FMath::RoundUpToPowerOfTwo(RequestedSize.Y));
+	case EStevesTextureRenderTargetSizing::Bucketed:
+		return FIntPoint(FMath::DivideAndRoundUp(RequestedSize.X, BucketGranularity) * BucketGranularity,
+		                 FMath::DivideAndRoundUp(RequestedSize.Y, BucketGranularity) * BucketGranularity);
+	default:
+	case EStevesTextureRenderTargetSizing::Exact:
+		return RequestedSize;
+	}
+}
+
+UTextureRenderTarget2D* FStevesTextureRenderTargetPool::TakeUnreservedTexture(const FTextureKey& Key, FIntPoint RequestedSize)
+{
+	if (auto Pooled = UnreservedTextures.Find(Key))
+	{
+		UTextureRenderTarget2D* Tex = *Pooled;
+		UnreservedTextures.RemoveSingle(Key, Tex);
+		UnreservedTimes.Remove(Tex);
+		return Tex;
+	}
+
+	if (Sizing == EStevesTextureRenderTargetSizing::Exact)
+	{
+		return nullptr;
+	}
+
+	// Look for the smallest larger texture of the same format
+	const int64 KeyArea = (int64)Key.Size.X * Key.Size.Y;
+	const FTextureKey* BestKey = nullptr;
+	UTextureRenderTarget2D* BestTex = nullptr;
+	int64 BestArea = MAX_int64;
+	for (const auto& Pair : UnreservedTextures)
+	{
+		const FTextureKey& K = Pair.Key;
+		if (K.Format == Key.Format && K.Size.X >= RequestedSize.X && K.Size.Y >= RequestedSize.Y)
+		{
+			const int64 Area = (int64)K.Size.X * K.Size.Y;
+			if (Area < BestArea && Area <= KeyArea * MaxBestFitAreaRatio)
+			{
+				BestArea = Area;
+				BestKey = &K;
+				BestTex = Pair.Value;
+			}
+		}
+	}
+
+	if (BestTex)
+	{
+		// Copy key, removal invalidates it
+		const FTextureKey RemoveKey = *BestKey;
+		UnreservedTextures.RemoveSingle(RemoveKey, BestTex);
+		UnreservedTimes.Remove(BestTex);
+	}
+	return BestTex;
+}
+
+bool FStevesTextureRenderTargetPool::MakeRoomFor(uint64 Bytes)
+{
+	if (MaxMemory == 0)
+	{
+		return true;
+	}
+
+	while (TotalMemory + Bytes > MaxMemory && EvictOldestUnreservedTexture())
+	{
+	}
+
+	return TotalMemory + Bytes <= MaxMemory;
+}
+
+void FStevesTextureRenderTargetPool::ReleaseTexture(UTextureRenderTarget2D* Tex)
+{
+	// Render commands are processed in order so there's no need to wait for a pending init
+	PendingTextures.Remove(Tex);
+	const uint64 TexMemory = GetTextureMemorySize(Tex);
+	TotalMemory -= FMath::Min(TotalMemory, TexMemory);
+	DEC_MEMORY_STAT_BY(STAT_RenderTargetPoolMemory, TexMemory);
+	UKismetRenderingLibrary::ReleaseRenderTarget2D(Tex);
+}
+
+void FStevesTextureRenderTargetPool::SetSizing(EStevesTextureRenderTargetSizing InSizing,
+                                               int32 InBucketGranularity,
+                                               float InMaxBestFitAreaRatio)
+{
+	Sizing = InSizing;
+	BucketGranularity = FMath::Max(1, InBucketGranularity);
+	MaxBestFitAreaRatio = FMath::Max(1.0f, InMaxBestFitAreaRatio);
 }
 
 void FStevesTextureRenderTargetPool::RevokeReservations(const UObject* ForOwner)
 {
-	for (int i = 0; i < Reservations.Num(); ++i)
+	if (ForOwner)
 	{
-		const FReservationInfo& R = Reservations[i];
-		if (!ForOwner || R.Owner == ForOwner)
+		const TObjectKey<UObject> OwnerKey(ForOwner);
+		TArray<const UTextureRenderTarget2D*> Textures;
+		ReservationsByOwner.MultiFind(OwnerKey, Textures);
+		ReservationsByOwner.Remove(OwnerKey);
+		for (const UTextureRenderTarget2D* Tex : Textures)
 		{
-			if (R.Texture.IsValid())
+			FReservationInfo Info(FTextureKey(), nullptr);
+			if (Reservations.RemoveAndCopyValue(Tex, Info))
 			{
-				UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Revoked texture reservation on %s"), *R.Texture->GetName());
-				UnreservedTextures.Add(R.Key, R.Texture.Get());
-				ReservedTextures.Remove(R.Texture.Get());
+				UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Revoked texture reservation on %s"), *Tex->GetName());
+				UnreserveTexture(Tex, Info);
 			}
-			// Can't use RemoveAtSwap because it'll change order
-			Reservations.RemoveAt(i);
-			// Adjust index backwards to compensate
-			--i;
 		}
 	}
+	else
+	{
+		for (const auto& Pair : Reservations)
+		{
+			UE_LOG(LogStevesUEHelpers, Verbose, TEXT("FStevesTextureRenderTargetPool: Revoked texture reservation on %s"), *Pair.Key->GetName());
+			UnreserveTexture(Pair.Key, Pair.Value);
+		}
+		Reservations.Empty();
+		ReservationsByOwner.Empty();
+	}
 }
 
 void FStevesTextureRenderTargetPool::DrainPool(bool bForceAndRevokeReservations)
@@ -124,9 +506,73 @@ void FStevesTextureRenderTargetPool::DrainPool(bool bForceAndRevokeReservations)
 
 	for (auto& TexPair : UnreservedTextures)
 	{
-		UKismetRenderingLibrary::ReleaseRenderTarget2D(TexPair.Value);
+		ReleaseTexture(TexPair.Value);
 	}
+	DEC_DWORD_STAT_BY(STAT_RenderTargetPoolUnreserved, UnreservedTextures.Num());
 	UnreservedTextures.Empty();
-	ReservedTextures.Empty();
+	UnreservedTimes.Empty();
+	UnreservedOrder.Empty();
+
+}
+
+uint64 FStevesTextureRenderTargetPool::GetTextureMemorySize(const UTextureRenderTarget2D* Tex)
+{
+	return IsValid(Tex) ? EstimateTextureMemorySize(FIntPoint(Tex->SizeX, Tex->SizeY), Tex->RenderTargetFormat) : 0;
+}
+
+uint64 FStevesTextureRenderTargetPool::EstimateTextureMemorySize(FIntPoint Size, ETextureRenderTargetFormat Format)
+{
+	// Pooled render targets have no mips, so this is a close enough estimate without needing the resource
+	const EPixelFormat PixelFormat = GetPixelFormatFromRenderTargetFormat(Format);
+	return (uint64)FMath::Max(0, Size.X) * FMath::Max(0, Size.Y) * GPixelFormats[PixelFormat].BlockBytes;
+}
+
+void FStevesTextureRenderTargetPool::DumpStats(FOutputDevice& Ar) const
+{
+	const uint32 NumRequests = NumHits + NumMisses;
+	const float HitRate = NumRequests > 0 ? 100.0f * NumHits / NumRequests : 0.0f;
+	Ar.Logf(TEXT("Render target pool %s: %d reserved, %d unreserved, %.2f MB (budget %.2f MB) | %u requests, %.1f%% hit rate, %u misses (created), %u evicted"),
+		*Name.ToString(),
+		ReservedTextures.Num(),
+		UnreservedTextures.Num(),
+		TotalMemory / (1024.0 * 1024.0),
+		MemoryBudget / (1024.0 * 1024.0),
+		NumRequests,
+		HitRate,
+		NumMisses,
+		NumEvictions);
 
+	// Break down memory by format & size
+	struct FBucket
+	{
+		int NumReserved = 0;
+		int NumUnreserved = 0;
+		uint64 Memory = 0;
+	};
+	TMap<FTextureKey, FBucket> Buckets;
+	for (const auto& Tex : ReservedTextures)
+	{
+		if (IsValid(Tex))
+		{
+			FBucket& B = Buckets.FindOrAdd(FTextureKey {FIntPoint(Tex->SizeX, Tex->SizeY), Tex->RenderTargetFormat});
+			++B.NumReserved;
+			B.Memory += GetTextureMemorySize(Tex);
+		}
+	}
+	for (const auto& Pair : UnreservedTextures)
+	{
+		FBucket& B = Buckets.FindOrAdd(Pair.Key);
+		++B.NumUnreserved;
+		B.Memory += GetTextureMemorySize(Pair.Value);
+	}
+	for (const auto& Pair : Buckets)
+	{
+		Ar.Logf(TEXT("  %dx%d %s: %d reserved, %d unreserved, %.2f MB"),
+			Pair.Key.Size.X,
+			Pair.Key.Size.Y,
+			*UEnum::GetValueAsString(Pair.Key.Format),
+			Pair.Value.NumReserved,
+			Pair.Value.NumUnreserved,
+			Pair.Value.Memory / (1024.0 * 1024.0));
+	}
 }
@@ -0,0 +1,17 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesUEHelpersVersion.h"
+
+#include "Serialization/CustomVersion.h"
+
+const FGuid FStevesUEHelpersVersion::GUID(0x7F479187, 0xFCDD4604, 0xBFB5A62F, 0x3DED7A2F);
+
+int32 FStevesUEHelpersVersion::Get(const FArchive& Ar)
+{
+	const FCustomVersion* Version = Ar.GetCustomVersions().GetVersion(GUID);
+	return Version ? Version->Version : LatestVersion;
+}
+
+FCustomVersionRegistration GRegisterStevesUEHelpersVersion(FStevesUEHelpersVersion::GUID,
+                                                          FStevesUEHelpersVersion::LatestVersion,
+                                                          TEXT("StevesUEHelpersVer"));
@@ -0,0 +1,298 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesBalancedRandomStream.h"
+#include "StevesShuffleBag.h"
+
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 SerializeSentinel = 0x5EED5EED;
+
+	/**
+	 * Save a stream the way save games usually do, through a proxy over a plain memory archive which carries no custom
+	 * versions, then load it into a new stream and check the two carry on identically.
+	 * @param Draw Get the next value from a stream, as a vector so every stream type can be compared
+	 */
+	template <typename TStream, typename TDrawFunc>
+	void TestStreamRoundTrip(FAutomationTestBase& Test, const TCHAR* What, TStream& Stream, TDrawFunc Draw)
+	{
+		// Step well past the start, so the position and any incremental state are both non-trivial
+		for (int32 i = 0; i < 1000; ++i)
+		{
+			Draw(Stream);
+		}
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		FObjectAndNameAsStringProxyArchive SaveProxy(Writer, false);
+		Stream.Serialize(SaveProxy);
+		int32 Sentinel = SerializeSentinel;
+		SaveProxy << Sentinel;
+
+		TStream Loaded;
+		FMemoryReader Reader(Bytes);
+		FObjectAndNameAsStringProxyArchive LoadProxy(Reader, true);
+		Test.TestTrue(FString::Printf(TEXT("%s loads natively"), What), Loaded.Serialize(LoadProxy));
+		int32 LoadedSentinel = 0;
+		LoadProxy << LoadedSentinel;
+		Test.TestEqual(FString::Printf(TEXT("%s reads exactly what was written"), What), LoadedSentinel, SerializeSentinel);
+
+		for (int32 i = 0; i < 100; ++i)
+		{
+			if (Draw(Stream) != Draw(Loaded))
+			{
+				Test.AddError(FString::Printf(TEXT("%s differs after loading, at value %d"), What, i));
+				return;
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesRandomStreamSerializeRoundTripTest,
+                                 "StevesUEHelpers.RandomStreams.SerializeRoundTrip",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesRandomStreamSerializeRoundTripTest::RunTest(const FString& Parameters)
+{
+	{
+		FStevesBalancedRandomStream Stream(1234);
+		TestStreamRoundTrip(*this, TEXT("Balanced"), Stream, [](auto& S) { return S.Rand3D(); });
+	}
+	{
+		FStevesBalancedRandomStream1D Stream(1234);
+		TestStreamRoundTrip(*this, TEXT("Balanced 1D"), Stream, [](auto& S) { return FVector(S.Rand()); });
+	}
+	{
+		FStevesBalancedRandomStream2D Stream(1234);
+		TestStreamRoundTrip(*this, TEXT("Balanced 2D"), Stream, [](auto& S) { return FVector(FVector2D(S.Rand2D()), 0); });
+	}
+	{
+		FStevesBalancedRandomStream3D Stream(1234);
+		TestStreamRoundTrip(*this, TEXT("Balanced 3D"), Stream, [](auto& S) { return S.Rand3D(); });
+	}
+	{
+		FStevesSobolRandomStream Stream(1234, 3);
+		TestStreamRoundTrip(*this, TEXT("Sobol"), Stream, [](auto& S) { return S.Rand3D(); });
+	}
+	{
+		FStevesRdRandomStream Stream(1234, 3);
+		TestStreamRoundTrip(*this, TEXT("R-d"), Stream, [](auto& S) { return S.Rand3D(); });
+	}
+	{
+		FStevesScrambledHaltonRandomStream Stream(1234, 3);
+		TestStreamRoundTrip(*this, TEXT("Scrambled Halton"), Stream, [](auto& S) { return S.Rand3D(); });
+	}
+
+	// Shuffle bags serialise their stream inline rather than via the struct
+	FStevesShuffleBag<int32, FStevesBalancedRandomStream> Bag(1234);
+	for (int32 i = 0; i < 20; ++i)
+	{
+		Bag.Add(i);
+	}
+	for (int32 i = 0; i < 7; ++i)
+	{
+		Bag.Next();
+	}
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	FObjectAndNameAsStringProxyArchive SaveProxy(Writer, false);
+	SaveProxy << Bag;
+
+	FStevesShuffleBag<int32, FStevesBalancedRandomStream> LoadedBag;
+	FMemoryReader Reader(Bytes);
+	FObjectAndNameAsStringProxyArchive LoadProxy(Reader, true);
+	LoadProxy << LoadedBag;
+	TestTrue(TEXT("Shuffle bag reads exactly what was written"), Reader.Tell() == Bytes.Num());
+	for (int32 i = 0; i < 50; ++i)
+	{
+		if (Bag.Next() != LoadedBag.Next())
+		{
+			AddError(FString::Printf(TEXT("Shuffle bag differs after loading, at draw %d"), i));
+			break;
+		}
+	}
+
+	return true;
+}
+
+namespace
+{
+	/**
+	 * Step a stream from a start seed, and check that seeking, splitting and batches all give bit-identical values.
+	 * Starting near the end of the period covers the wrap back to seed 0.
+	 */
+	template <typename TStream, typename TValue, typename TDrawFunc, typename TBatchFunc>
+	void TestSeekMatchesStepping(FAutomationTestBase& Test, const TCHAR* What, uint32 StartSeed, TDrawFunc Draw, TBatchFunc Batch)
+	{
+		constexpr int32 NumValues = 2000;
+		TStream Stepped(StartSeed);
+		TArray<TValue> Expected;
+		Expected.SetNumUninitialized(NumValues);
+		for (int32 i = 0; i < NumValues; ++i)
+		{
+			Expected[i] = Draw(Stepped);
+		}
+
+		for (int32 i = 0; i < NumValues; i += 37)
+		{
+			TStream Seeked(StartSeed);
+			Seeked.SeekTo(i);
+			if (Draw(Seeked) != Expected[i])
+			{
+				Test.AddError(FString::Printf(TEXT("%s from seed %u: SeekTo(%d) differs from stepping"), What, StartSeed, i));
+				return;
+			}
+		}
+
+		TArray<TStream> Partitions;
+		const uint32 PerPartition = TStream(StartSeed).Split(7, NumValues, Partitions);
+		for (int32 p = 0; p < Partitions.Num(); ++p)
+		{
+			const int32 Start = p * PerPartition;
+			const int32 End = FMath::Min(NumValues, Start + (int32)PerPartition);
+			for (int32 i = Start; i < End; ++i)
+			{
+				if (Draw(Partitions[p]) != Expected[i])
+				{
+					Test.AddError(FString::Printf(TEXT("%s from seed %u: partition %d differs from stepping at %d"), What, StartSeed, p, i));
+					return;
+				}
+			}
+		}
+
+		// Odd sizes, so batches don't line up with any vector width
+		TStream Batched(StartSeed);
+		TArray<TValue> Values;
+		for (int32 Start = 0, Size = 1; Start < NumValues; Start += Size, Size = Size * 2 + 1)
+		{
+			const int32 Count = FMath::Min(Size, NumValues - Start);
+			Values.SetNumUninitialized(Count);
+			Batch(Batched, TArrayView<TValue>(Values));
+			for (int32 i = 0; i < Count; ++i)
+			{
+				if (Values[i] != Expected[Start + i])
+				{
+					Test.AddError(FString::Printf(TEXT("%s from seed %u: batch differs from stepping at %d"), What, StartSeed, Start + i));
+					return;
+				}
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesRandomStreamSeekMatchesSteppingTest,
+                                 "StevesUEHelpers.RandomStreams.SeekMatchesStepping",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesRandomStreamSeekMatchesSteppingTest::RunTest(const FString& Parameters)
+{
+	// Include starts just before high digits carry, and just before the period wraps
+	for (const uint32 StartSeed : {0u, 1234u, StevesRandConstants::kPow3_15 - 1000, StevesRandConstants::kSafeMaxSeed2D - 1000})
+	{
+		TestSeekMatchesStepping<FStevesBalancedRandomStream2D, FVector2f>(*this, TEXT("Balanced 2D"), StartSeed,
+			[](FStevesBalancedRandomStream2D& S) { return S.Rand2D(); },
+			[](FStevesBalancedRandomStream2D& S, TArrayView<FVector2f> Out) { S.Rand2DBatch(Out); });
+	}
+	for (const uint32 StartSeed : {0u, 1234u, StevesRandConstants::kPow5_10 / 5 - 1000, StevesRandConstants::kSafeMaxSeed3D - 1000})
+	{
+		TestSeekMatchesStepping<FStevesBalancedRandomStream3D, FVector3f>(*this, TEXT("Balanced 3D"), StartSeed,
+			[](FStevesBalancedRandomStream3D& S) { return FVector3f(S.Rand3D()); },
+			[](FStevesBalancedRandomStream3D& S, TArrayView<FVector3f> Out) { S.Rand3DBatch(Out); });
+	}
+
+	return true;
+}
+
+namespace
+{
+	/**
+	 * Time generating batches of each size with a scalar loop and with the batch function, and log points / sec.
+	 * Both sum what they generate, so neither can be optimised away, and the sums must match exactly.
+	 */
+	template <typename TStream, typename TValue, typename TDrawFunc, typename TBatchFunc, typename TSumFunc>
+	void BenchmarkBatch(FAutomationTestBase& Test, const TCHAR* What, TDrawFunc Draw, TBatchFunc Batch, TSumFunc Sum)
+	{
+		// Enough points per size that the timings aren't just noise
+		constexpr int32 PointsPerSize = 1 << 22;
+		TArray<TValue> Values;
+		for (const int32 Size : {64, 1024, 16384, 262144, 1048576})
+		{
+			const int32 Reps = PointsPerSize / Size;
+			Values.SetNumUninitialized(Size);
+
+			TStream ScalarStream(1234);
+			double ScalarSum = 0;
+			const double ScalarStart = FPlatformTime::Seconds();
+			for (int32 r = 0; r < Reps; ++r)
+			{
+				for (int32 i = 0; i < Size; ++i)
+				{
+					Values[i] = Draw(ScalarStream);
+				}
+				ScalarSum += Sum(Values);
+			}
+			const double ScalarTime = FPlatformTime::Seconds() - ScalarStart;
+
+			TStream BatchStream(1234);
+			double BatchSum = 0;
+			const double BatchStart = FPlatformTime::Seconds();
+			for (int32 r = 0; r < Reps; ++r)
+			{
+				Batch(BatchStream, TArrayView<TValue>(Values));
+				BatchSum += Sum(Values);
+			}
+			const double BatchTime = FPlatformTime::Seconds() - BatchStart;
+
+			Test.TestEqual(FString::Printf(TEXT("%s batches of %d match scalar"), What, Size), BatchSum, ScalarSum);
+			const double Points = (double)Reps * Size;
+			Test.AddInfo(FString::Printf(TEXT("%s batches of %7d: scalar %.1f M points/sec, batch %.1f M points/sec (%.2fx)"),
+			                             What, Size,
+			                             Points / FMath::Max(ScalarTime, 1e-9) * 1e-6,
+			                             Points / FMath::Max(BatchTime, 1e-9) * 1e-6,
+			                             ScalarTime / FMath::Max(BatchTime, 1e-9)));
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesRandomStreamBatchBenchmark,
+                                 "StevesUEHelpers.RandomStreams.BatchBenchmark",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesRandomStreamBatchBenchmark::RunTest(const FString& Parameters)
+{
+	BenchmarkBatch<FStevesBalancedRandomStream2D, FVector2f>(*this, TEXT("Balanced 2D"),
+		[](FStevesBalancedRandomStream2D& S) { return S.Rand2D(); },
+		[](FStevesBalancedRandomStream2D& S, TArrayView<FVector2f> Out) { S.Rand2DBatch(Out); },
+		[](const TArray<FVector2f>& Values)
+		{
+			double Total = 0;
+			for (const FVector2f& V : Values)
+			{
+				Total += V.X + V.Y;
+			}
+			return Total;
+		});
+	BenchmarkBatch<FStevesBalancedRandomStream3D, FVector3f>(*this, TEXT("Balanced 3D"),
+		[](FStevesBalancedRandomStream3D& S) { return FVector3f(S.Rand3D()); },
+		[](FStevesBalancedRandomStream3D& S, TArrayView<FVector3f> Out) { S.Rand3DBatch(Out); },
+		[](const TArray<FVector3f>& Values)
+		{
+			double Total = 0;
+			for (const FVector3f& V : Values)
+			{
+				Total += V.X + V.Y + V.Z;
+			}
+			return Total;
+		});
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,158 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesEditorVisComponent.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "RenderCore.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 NumBenchmarkShapes = 10000;
+	constexpr int32 NumWarmupFrames = 10;
+	constexpr int32 NumMeasuredFrames = 120;
+
+	/// The world being rendered; PIE if it's running, otherwise the editor world
+	UWorld* FindRenderedWorld()
+	{
+		UWorld* Found = nullptr;
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if (Context.WorldType == EWorldType::PIE || Context.WorldType == EWorldType::Game)
+			{
+				return Context.World();
+			}
+			if (Context.WorldType == EWorldType::Editor)
+			{
+				Found = Context.World();
+			}
+		}
+		return Found;
+	}
+
+	/// Frame times summed over the measured frames, for one way of drawing the lines
+	struct FDebugRenderFrameTimes
+	{
+		double GameMs = 0;
+		double RenderMs = 0;
+		double FrameMs = 0;
+		int32 NumFrames = 0;
+
+		FString ToString() const
+		{
+			const int32 N = FMath::Max(NumFrames, 1);
+			return FString::Printf(TEXT("frame %.2f ms, game thread %.2f ms, render thread %.2f ms"),
+			                       FrameMs / N, GameMs / N, RenderMs / N);
+		}
+	};
+
+	struct FDebugRenderBenchmarkState
+	{
+		TWeakObjectPtr<AActor> Actor;
+		IConsoleVariable* LineGeometryVar = nullptr;
+		bool bOldLineGeometry = true;
+		/// 0 = lines through the PDI, 1 = line geometry
+		int32 Mode = 0;
+		int32 Frame = 0;
+		FDebugRenderFrameTimes Times[2];
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesDebugRenderLineBenchmark,
+                                 "StevesUEHelpers.DebugRender.TessellatedLineBenchmark",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesDebugRenderLineBenchmark::RunTest(const FString& Parameters)
+{
+	// Needs a rendering viewport for the timings to mean anything, so run it in the editor rather than with -nullrhi
+	UWorld* World = FindRenderedWorld();
+	if (!TestNotNull(TEXT("World being rendered"), World))
+	{
+		return false;
+	}
+	TSharedRef<FDebugRenderBenchmarkState> State = MakeShared<FDebugRenderBenchmarkState>();
+	State->LineGeometryVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Steves.DebugRender.LineGeometry"));
+	if (!TestNotNull(TEXT("Line geometry console variable"), State->LineGeometryVar))
+	{
+		return false;
+	}
+	State->bOldLineGeometry = State->LineGeometryVar->GetBool();
+
+	FActorSpawnParameters Params;
+	Params.ObjectFlags = RF_Transient;
+	AActor* Actor = World->SpawnActor<AActor>(Params);
+	UStevesEditorVisComponent* Vis = NewObject<UStevesEditorVisComponent>(Actor);
+	Actor->SetRootComponent(Vis);
+	Vis->RegisterComponent();
+	State->Actor = Actor;
+
+	// An even mix of the shapes which are pre-tessellated, scattered around the origin
+	FRandomStream Rand(1234);
+	for (int32 i = 0; i < NumBenchmarkShapes; ++i)
+	{
+		const FVector Location = Rand.GetUnitVector() * Rand.FRandRange(0.f, 5000.f);
+		const FRotator Rotation = Rand.GetUnitVector().Rotation();
+		const float Size = Rand.FRandRange(10.f, 200.f);
+		switch (i % 4)
+		{
+		case 0:
+			Vis->Circles.Add(FStevesEditorVisCircle(Location, Rotation, Size, 32, FColor::Green));
+			break;
+		case 1:
+			Vis->Arcs.Add(FStevesEditorVisArc(Location, Rotation, 0, 270, Size, 24, FColor::Yellow));
+			break;
+		case 2:
+			Vis->Cylinders.Add(FStevesEditorVisCylinder(Location, Size * 2, Size * 0.5f, Rotation, FColor::Cyan));
+			break;
+		default:
+			Vis->Capsules.Add(FStevesEditorVisCapsule(Location, Size * 2, Size * 0.5f, Rotation, FColor::Magenta));
+			break;
+		}
+	}
+	Vis->MarkShapesChanged();
+
+	// Draw the same shapes each way for a number of frames, after letting things settle
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([State]()
+	{
+		if (State->Frame == 0)
+		{
+			State->LineGeometryVar->Set(State->Mode == 1, ECVF_SetByConsole);
+		}
+		if (State->Frame >= NumWarmupFrames)
+		{
+			FDebugRenderFrameTimes& Times = State->Times[State->Mode];
+			Times.GameMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+			Times.RenderMs += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+			Times.FrameMs += FApp::GetDeltaTime() * 1000.0;
+			++Times.NumFrames;
+		}
+		if (++State->Frame < NumWarmupFrames + NumMeasuredFrames)
+		{
+			return false;
+		}
+		State->Frame = 0;
+		return ++State->Mode == 2;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]()
+	{
+		State->LineGeometryVar->Set(State->bOldLineGeometry, ECVF_SetByConsole);
+		if (AActor* Actor = State->Actor.Get())
+		{
+			Actor->Destroy();
+		}
+		AddInfo(FString::Printf(TEXT("%d shapes, lines through the PDI: %s"), NumBenchmarkShapes, *State->Times[0].ToString()));
+		AddInfo(FString::Printf(TEXT("%d shapes, line geometry: %s"), NumBenchmarkShapes, *State->Times[1].ToString()));
+		return true;
+	}));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,471 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesMathHelpers.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/// One cone and a set of spheres around it, as structure of arrays
+	struct FSphereConeCase
+	{
+		FStevesPreparedCone Cone;
+		TArray<float> X, Y, Z, Radii;
+
+		FSphereConeCase(FRandomStream& Rand, int32 NumSpheres)
+			: Cone(Rand.VRand() * 1000.0, Rand.VRand(), FMath::DegreesToRadians(Rand.FRandRange(5.f, 80.f)), Rand.FRandRange(100.f, 2000.f))
+		{
+			X.SetNumUninitialized(NumSpheres);
+			Y.SetNumUninitialized(NumSpheres);
+			Z.SetNumUninitialized(NumSpheres);
+			Radii.SetNumUninitialized(NumSpheres);
+			for (int32 i = 0; i < NumSpheres; ++i)
+			{
+				// Scatter around the cone, from behind the apex to beyond the cap, so every feature gets hits and misses
+				const float Along = Rand.FRandRange(-0.3f, 1.3f) * Cone.Distance;
+				const float Spread = FMath::Abs(Along) * Cone.TanHalfAngle * 1.5f + 50.f;
+				const FVector Centre = Cone.Origin + Cone.Dir * Along + Rand.VRand() * Rand.FRandRange(0.f, Spread);
+				X[i] = Centre.X;
+				Y[i] = Centre.Y;
+				Z[i] = Centre.Z;
+				Radii[i] = Rand.FRandRange(1.f, 200.f);
+			}
+		}
+
+		FVector Centre(int32 i) const { return FVector(X[i], Y[i], Z[i]); }
+
+		int32 Batch(TArray<uint32>& OutMask) const
+		{
+			return StevesMathHelpers::SphereOverlapConeBatch(Cone, X, Y, Z, Radii, OutMask);
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesSphereOverlapConeBatchTest,
+                                 "StevesUEHelpers.MathHelpers.SphereOverlapConeBatchMatchesScalar",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesSphereOverlapConeBatchTest::RunTest(const FString& Parameters)
+{
+	// 16 cones x 65536 spheres, just over 1M pairs
+	FRandomStream Rand(1234);
+	int32 NumBoundary = 0;
+	int32 NumHits = 0;
+	for (int32 c = 0; c < 16; ++c)
+	{
+		const FSphereConeCase Case(Rand, 65536);
+		TArray<uint32> Mask;
+		NumHits += Case.Batch(Mask);
+
+		for (int32 i = 0; i < Case.X.Num(); ++i)
+		{
+			const FVector Centre = Case.Centre(i);
+			const float Radius = Case.Radii[i];
+			const bool bScalar = StevesMathHelpers::SphereOverlapCone(Case.Cone, Centre, Radius);
+			const bool bBatch = (Mask[i / 32] & (1u << (i % 32))) != 0;
+			if (bScalar != bBatch)
+			{
+				// Overlap only grows with the radius, so if nudging the radius either way gives the same answer the
+				// sphere isn't within float precision of the surface, and the batch result is wrong
+				const float Nudge = Radius * 1e-4f + 1e-2f;
+				if (StevesMathHelpers::SphereOverlapCone(Case.Cone, Centre, FMath::Max(0.f, Radius - Nudge)) ==
+					StevesMathHelpers::SphereOverlapCone(Case.Cone, Centre, Radius + Nudge))
+				{
+					AddError(FString::Printf(TEXT("Cone %d sphere %d: batch says %d, scalar says %d"), c, i, (int32)bBatch, (int32)bScalar));
+					return false;
+				}
+				++NumBoundary;
+			}
+		}
+	}
+
+	TestTrue(TEXT("Cases include hits and misses"), NumHits > 0 && NumHits < 16 * 65536);
+	AddInfo(FString::Printf(TEXT("%d hits, %d pairs within float precision of the surface"), NumHits, NumBoundary));
+
+	// Indices version agrees with the mask, including a tail which isn't a multiple of 4
+	const FSphereConeCase Small(Rand, 103);
+	TArray<uint32> Mask;
+	TArray<int32> Indices;
+	const int32 MaskCount = Small.Batch(Mask);
+	const int32 IndexCount = StevesMathHelpers::SphereOverlapConeBatch(Small.Cone, Small.X, Small.Y, Small.Z, Small.Radii, Indices);
+	TestEqual(TEXT("Index count"), IndexCount, MaskCount);
+	TestEqual(TEXT("Indices added"), Indices.Num(), MaskCount);
+	for (const int32 i : Indices)
+	{
+		TestTrue(TEXT("Index is set in mask"), (Mask[i / 32] & (1u << (i % 32))) != 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesSphereOverlapConeBenchmark,
+                                 "StevesUEHelpers.MathHelpers.SphereOverlapConeBenchmark",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesSphereOverlapConeBenchmark::RunTest(const FString& Parameters)
+{
+	FRandomStream Rand(5678);
+	// From a few dozen AI vision cones over 5k spheres, to batches big enough to go parallel
+	for (const int32 NumSpheres : {64, 1024, 5000, 65536, 1048576})
+	{
+		const FSphereConeCase Case(Rand, NumSpheres);
+		const int32 Reps = FMath::Max(1, (1 << 23) / NumSpheres);
+
+		int32 ScalarHits = 0;
+		const double ScalarStart = FPlatformTime::Seconds();
+		for (int32 r = 0; r < Reps; ++r)
+		{
+			for (int32 i = 0; i < NumSpheres; ++i)
+			{
+				ScalarHits += StevesMathHelpers::SphereOverlapCone(Case.Cone, Case.Centre(i), Case.Radii[i]) ? 1 : 0;
+			}
+		}
+		const double ScalarTime = FPlatformTime::Seconds() - ScalarStart;
+
+		int32 BatchHits = 0;
+		TArray<uint32> Mask;
+		const double BatchStart = FPlatformTime::Seconds();
+		for (int32 r = 0; r < Reps; ++r)
+		{
+			BatchHits += Case.Batch(Mask);
+		}
+		const double BatchTime = FPlatformTime::Seconds() - BatchStart;
+
+		// Hits are logged so neither loop can be optimised away; SphereOverlapConeBatchMatchesScalar checks them
+		const double Tests = (double)Reps * NumSpheres;
+		AddInfo(FString::Printf(TEXT("%7d spheres: scalar %.1f M tests/sec, batch %.1f M tests/sec (%.2fx), %d / %d hits"),
+		                        NumSpheres,
+		                        Tests / FMath::Max(ScalarTime, 1e-9) * 1e-6,
+		                        Tests / FMath::Max(BatchTime, 1e-9) * 1e-6,
+		                        ScalarTime / FMath::Max(BatchTime, 1e-9),
+		                        ScalarHits, BatchHits));
+	}
+
+	return true;
+}
+
+namespace
+{
+	/// Row-major bitmap of valid cells, in the layout the bitmap Fill2DRegionWithRectangles takes
+	struct FFillTestGrid
+	{
+		int Width;
+		int Height;
+		int WordsPerRow;
+		TArray<uint64> Bits;
+
+		FFillTestGrid(int InWidth, int InHeight)
+			: Width(InWidth),
+			  Height(InHeight),
+			  WordsPerRow(FMath::DivideAndRoundUp(InWidth, 64))
+		{
+			Bits.SetNumZeroed(WordsPerRow * Height);
+		}
+
+		bool Get(int X, int Y) const { return (Bits[Y * WordsPerRow + X / 64] >> (X % 64)) & 1; }
+
+		void Set(int X, int Y, bool bValid)
+		{
+			uint64& Word = Bits[Y * WordsPerRow + X / 64];
+			Word = bValid ? Word | (1ull << (X % 64)) : Word & ~(1ull << (X % 64));
+		}
+
+		void SetRect(const FIntRect& Rect, bool bValid)
+		{
+			for (int Y = Rect.Min.Y; Y <= Rect.Max.Y; ++Y)
+			{
+				for (int X = Rect.Min.X; X <= Rect.Max.X; ++X)
+				{
+					Set(X, Y, bValid);
+				}
+			}
+		}
+
+		FIntRect RandRect(FRandomStream& Rand, int MaxSize) const
+		{
+			const int X = Rand.RandRange(0, Width - 1);
+			const int Y = Rand.RandRange(0, Height - 1);
+			return FIntRect(X, Y, FMath::Min(Width - 1, X + Rand.RandRange(0, MaxSize - 1)),
+			                FMath::Min(Height - 1, Y + Rand.RandRange(0, MaxSize - 1)));
+		}
+
+		/// Each cell valid independently
+		static FFillTestGrid MakeRandom(FRandomStream& Rand, int Width, int Height, float Density)
+		{
+			FFillTestGrid Grid(Width, Height);
+			for (int Y = 0; Y < Height; ++Y)
+			{
+				for (int X = 0; X < Width; ++X)
+				{
+					Grid.Set(X, Y, Rand.FRand() < Density);
+				}
+			}
+			return Grid;
+		}
+
+		/// Mostly invalid, with a few valid rectangles which may overlap
+		static FFillTestGrid MakeSparse(FRandomStream& Rand, int Width, int Height, int NumRects, int MaxSize)
+		{
+			FFillTestGrid Grid(Width, Height);
+			for (int i = 0; i < NumRects; ++i)
+			{
+				Grid.SetRect(Grid.RandRect(Rand, MaxSize), true);
+			}
+			return Grid;
+		}
+
+		/// Mostly valid, with a few invalid rectangles carved out
+		static FFillTestGrid MakeDense(FRandomStream& Rand, int Width, int Height, int NumHoles, int MaxSize)
+		{
+			FFillTestGrid Grid(Width, Height);
+			Grid.SetRect(FIntRect(0, 0, Width - 1, Height - 1), true);
+			for (int i = 0; i < NumHoles; ++i)
+			{
+				Grid.SetRect(Grid.RandRect(Rand, MaxSize), false);
+			}
+			return Grid;
+		}
+	};
+
+	/// Fill2DRegionWithRectangles as it was before the bitmap core, with a bool per cell, for comparison
+	int LegacyFill2DRegionWithRectangles(int StartX,
+	                                     int StartY,
+	                                     int Width,
+	                                     int Height,
+	                                     std::function<bool(int, int)> CellIncludeFunc,
+	                                     TArray<FIntRect>& OutRects)
+	{
+		int RectCount = 0;
+
+		const int Len = Width*Height;
+		TArray<bool> bDoneMarkers;
+		bDoneMarkers.SetNumUninitialized(Len);
+		int CellsTodo = 0;
+
+		int StartN = 0;
+		for (int y = 0; y < Height; ++y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				const bool Include = CellIncludeFunc(x+StartX, y+StartY);
+				bDoneMarkers[y*Width + x] = !Include;
+				if (Include)
+				{
+					if (++CellsTodo == 1)
+					{
+						StartN = y*Width + x;
+					}
+				}
+			}
+		}
+
+		while (CellsTodo > 0)
+		{
+			for (; StartN < Len && bDoneMarkers[StartN]; ++StartN) {}
+			if (StartN >= Len)
+				break;
+
+			const int LocalStartX = StartN % Width;
+			const int LocalStartY = StartN / Width;
+
+			bool bCanExtendX = true, bCanExtendY = true;
+			bool bExtendingX = true;
+			int W = 1;
+			int H = 1;
+
+			while (bCanExtendX || bCanExtendY)
+			{
+				if (bExtendingX)
+				{
+					bool ExtendOK = LocalStartX+W < Width;
+					for (int TestY = LocalStartY; ExtendOK && TestY < LocalStartY+H; ++TestY)
+					{
+						if (bDoneMarkers[TestY*Width + LocalStartX+W])
+						{
+							ExtendOK = false;
+						}
+					}
+					if (ExtendOK)
+					{
+						++W;
+					}
+					else
+					{
+						bCanExtendX = false;
+					}
+					if (bCanExtendY)
+						bExtendingX = false;
+				}
+				else
+				{
+					bool ExtendOK = LocalStartY+H < Height;
+					for (int TestX = LocalStartX; ExtendOK && TestX < LocalStartX+W; ++TestX)
+					{
+						if (bDoneMarkers[(LocalStartY+H)*Width + TestX])
+						{
+							ExtendOK = false;
+						}
+					}
+					if (ExtendOK)
+					{
+						++H;
+					}
+					else
+					{
+						bCanExtendY = false;
+					}
+					if (bCanExtendX)
+						bExtendingX = true;
+				}
+			}
+
+			for (int y = LocalStartY; y < LocalStartY+H; ++y)
+			{
+				for (int x = LocalStartX; x < LocalStartX+W; ++x)
+				{
+					bDoneMarkers[y*Width+x] = true;
+					--CellsTodo;
+				}
+			}
+			OutRects.Add(FIntRect(StartX+LocalStartX, StartY+LocalStartY, StartX+LocalStartX+W-1, StartY+LocalStartY+H-1));
+			++RectCount;
+		}
+
+		return RectCount;
+	}
+
+	/// Check rectangles cover every valid cell exactly once, and no invalid cells
+	bool TestRectsCoverGrid(FAutomationTestBase& Test, const FString& What, const FFillTestGrid& Grid, int StartX, int StartY, const TArray<FIntRect>& Rects)
+	{
+		TArray<uint8> Coverage;
+		Coverage.SetNumZeroed(Grid.Width * Grid.Height);
+		for (const FIntRect& Rect : Rects)
+		{
+			for (int Y = Rect.Min.Y - StartY; Y <= Rect.Max.Y - StartY; ++Y)
+			{
+				for (int X = Rect.Min.X - StartX; X <= Rect.Max.X - StartX; ++X)
+				{
+					if (X < 0 || Y < 0 || X >= Grid.Width || Y >= Grid.Height || !Grid.Get(X, Y) || Coverage[Y * Grid.Width + X]++)
+					{
+						Test.AddError(FString::Printf(TEXT("%s: cell %d,%d is outside the valid area or covered twice"), *What, X, Y));
+						return false;
+					}
+				}
+			}
+		}
+		for (int Y = 0; Y < Grid.Height; ++Y)
+		{
+			for (int X = 0; X < Grid.Width; ++X)
+			{
+				if (Grid.Get(X, Y) && !Coverage[Y * Grid.Width + X])
+				{
+					Test.AddError(FString::Printf(TEXT("%s: valid cell %d,%d is not covered"), *What, X, Y));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesFill2DRegionMatchesLegacyTest,
+                                 "StevesUEHelpers.MathHelpers.Fill2DRegionMatchesLegacy",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesFill2DRegionMatchesLegacyTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Rand(1234);
+	for (int GridIndex = 0; GridIndex < 300; ++GridIndex)
+	{
+		// Sizes either side of word boundaries, and a mix of grid types
+		const int Width = Rand.RandRange(1, 200);
+		const int Height = Rand.RandRange(1, 200);
+		const FFillTestGrid Grid =
+			GridIndex % 3 == 0 ? FFillTestGrid::MakeRandom(Rand, Width, Height, Rand.FRand()) :
+			GridIndex % 3 == 1 ? FFillTestGrid::MakeSparse(Rand, Width, Height, Rand.RandRange(0, 20), 40) :
+			                     FFillTestGrid::MakeDense(Rand, Width, Height, Rand.RandRange(0, 20), 40);
+		const int StartX = Rand.RandRange(-50, 50);
+		const int StartY = Rand.RandRange(-50, 50);
+		auto IsValid = [&](int X, int Y) { return Grid.Get(X - StartX, Y - StartY); };
+
+		TArray<FIntRect> Legacy, Callback, Bitmap, Parallel;
+		LegacyFill2DRegionWithRectangles(StartX, StartY, Width, Height, IsValid, Legacy);
+		const int CallbackCount = StevesMathHelpers::Fill2DRegionWithRectangles(StartX, StartY, Width, Height, IsValid, Callback);
+		const int BitmapCount = StevesMathHelpers::Fill2DRegionWithRectangles(StartX, StartY, Width, Height, Grid.Bits, Grid.WordsPerRow, Bitmap);
+		StevesMathHelpers::Fill2DRegionWithRectangles(StartX, StartY, Width, Height, Grid.Bits, Grid.WordsPerRow, Parallel, true, 32);
+
+		if (Callback != Legacy || Bitmap != Legacy || CallbackCount != Legacy.Num() || BitmapCount != Legacy.Num())
+		{
+			AddError(FString::Printf(TEXT("Grid %d (%dx%d): %d legacy rects, %d callback, %d bitmap, or they differ"),
+			                         GridIndex, Width, Height, Legacy.Num(), Callback.Num(), Bitmap.Num()));
+			return false;
+		}
+		if (!TestRectsCoverGrid(*this, FString::Printf(TEXT("Grid %d"), GridIndex), Grid, StartX, StartY, Legacy) ||
+			!TestRectsCoverGrid(*this, FString::Printf(TEXT("Grid %d parallel"), GridIndex), Grid, StartX, StartY, Parallel))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesFill2DRegionBenchmark,
+                                 "StevesUEHelpers.MathHelpers.Fill2DRegionBenchmark",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesFill2DRegionBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int Size = 2048;
+	FRandomStream Rand(5678);
+	struct FCase
+	{
+		const TCHAR* Name;
+		FFillTestGrid Grid;
+	};
+	const FCase Cases[] =
+	{
+		{TEXT("Random 50%"), FFillTestGrid::MakeRandom(Rand, Size, Size, 0.5f)},
+		{TEXT("Sparse"), FFillTestGrid::MakeSparse(Rand, Size, Size, 500, 64)},
+		{TEXT("Dense"), FFillTestGrid::MakeDense(Rand, Size, Size, 500, 64)},
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		const FFillTestGrid& Grid = Case.Grid;
+		auto IsValid = [&](int X, int Y) { return Grid.Get(X, Y); };
+		TArray<FIntRect> Rects;
+
+		double Start = FPlatformTime::Seconds();
+		LegacyFill2DRegionWithRectangles(0, 0, Size, Size, IsValid, Rects);
+		const double LegacyTime = FPlatformTime::Seconds() - Start;
+		const int NumRects = Rects.Num();
+
+		Rects.Reset();
+		Start = FPlatformTime::Seconds();
+		StevesMathHelpers::Fill2DRegionWithRectangles(0, 0, Size, Size, IsValid, Rects);
+		const double CallbackTime = FPlatformTime::Seconds() - Start;
+
+		Rects.Reset();
+		Start = FPlatformTime::Seconds();
+		StevesMathHelpers::Fill2DRegionWithRectangles(0, 0, Size, Size, Grid.Bits, Grid.WordsPerRow, Rects);
+		const double BitmapTime = FPlatformTime::Seconds() - Start;
+		TestEqual(FString::Printf(TEXT("%s bitmap rects"), Case.Name), Rects.Num(), NumRects);
+
+		Rects.Reset();
+		Start = FPlatformTime::Seconds();
+		StevesMathHelpers::Fill2DRegionWithRectangles(0, 0, Size, Size, Grid.Bits, Grid.WordsPerRow, Rects, true);
+		const double ParallelTime = FPlatformTime::Seconds() - Start;
+
+		AddInfo(FString::Printf(TEXT("%s %dx%d, %d rects: legacy %.2f ms, callback %.2f ms, bitmap %.2f ms, parallel %.2f ms (%d rects)"),
+		                        Case.Name, Size, Size, NumRects,
+		                        LegacyTime * 1000.0, CallbackTime * 1000.0, BitmapTime * 1000.0, ParallelTime * 1000.0,
+		                        Rects.Num()));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,184 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesPooledActorSystem.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/// A game world which exists for the scope of a test, so the pool system can spawn actors into it
+	struct FPoolTestWorld
+	{
+		UWorld* World;
+
+		FPoolTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("StevesPoolTestWorld"));
+			FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+			Context.SetCurrentWorld(World);
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+		}
+
+		~FPoolTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UStevesPooledActorSystem* GetPoolSystem() const { return UStevesPooledActorSystem::Get(World); }
+	};
+
+	/// Number of actors in the pool for a class, ready to be used
+	int GetNumPooled(UStevesPooledActorSystem* PoolSys, UClass* Class)
+	{
+		int NumReady, NumQueued;
+		PoolSys->GetPreWarmStatus(Class, NumReady, NumQueued);
+		return NumReady;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesPooledActorGetReleaseStressTest,
+                                 "StevesUEHelpers.PooledActors.GetReleaseStress",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesPooledActorGetReleaseStressTest::RunTest(const FString& Parameters)
+{
+	FPoolTestWorld TestWorld;
+	UStevesPooledActorSystem* PoolSys = TestWorld.GetPoolSystem();
+	if (!TestNotNull(TEXT("Pool system"), PoolSys))
+	{
+		return false;
+	}
+
+	constexpr int32 NumCycles = 100000;
+	constexpr int32 MaxHeld = 64;
+	UClass* Class = AActor::StaticClass();
+	PoolSys->PreWarmActorPool(Class, MaxHeld + 1);
+
+	// Hold a working set and release a random one for every get, so actors come back out of order
+	FRandomStream Rand(1234);
+	TArray<AActor*> Held;
+	int32 NumSpawned = 0;
+	const double Start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumCycles; ++i)
+	{
+		bool bWasReused;
+		Held.Add(PoolSys->GetPooledActor<AActor>(Class, FVector(i, 0, 0), FRotator::ZeroRotator, bWasReused));
+		NumSpawned += bWasReused ? 0 : 1;
+		if (Held.Num() > MaxHeld)
+		{
+			const int32 Index = Rand.RandRange(0, Held.Num() - 1);
+			PoolSys->ReleasePooledActor(Held[Index]);
+			Held.RemoveAtSwap(Index);
+		}
+	}
+	const double Time = FPlatformTime::Seconds() - Start;
+
+	const double CyclesPerSec = NumCycles / FMath::Max(Time, 1e-9);
+	AddInfo(FString::Printf(TEXT("%d get/release cycles in %.2f ms, %.0f cycles/sec"), NumCycles, Time * 1000.0, CyclesPerSec));
+	if (CyclesPerSec < 100000)
+	{
+		AddWarning(TEXT("Below the target of 100k get/release cycles/sec"));
+	}
+	TestEqual(TEXT("Pre-warmed actors were enough"), NumSpawned, 0);
+
+	for (AActor* Actor : Held)
+	{
+		PoolSys->ReleasePooledActor(Actor);
+	}
+	TestEqual(TEXT("Every actor is back in the pool"), GetNumPooled(PoolSys, Class), MaxHeld + 1);
+
+	// Releasing twice is rejected, rather than pooling the same actor twice
+	AActor* Actor = PoolSys->GetPooledActor<AActor>(Class, FVector::ZeroVector, FRotator::ZeroRotator);
+	PoolSys->ReleasePooledActor(Actor);
+	AddExpectedError(TEXT("already pooled"), EAutomationExpectedErrorFlags::Contains, 1);
+	PoolSys->ReleasePooledActor(Actor);
+	TestEqual(TEXT("Double release is ignored"), GetNumPooled(PoolSys, Class), MaxHeld + 1);
+
+	// Destroyed actors leave the pool straight away
+	Actor->Destroy();
+	TestFalse(TEXT("Destroyed actor is not pooled"), PoolSys->IsActorInPool(Actor));
+	TestEqual(TEXT("Destroyed actor is evicted"), GetNumPooled(PoolSys, Class), MaxHeld);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesPooledActorBatchedGetBenchmark,
+                                 "StevesUEHelpers.PooledActors.BatchedGetBenchmark",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FStevesPooledActorBatchedGetBenchmark::RunTest(const FString& Parameters)
+{
+	FPoolTestWorld TestWorld;
+	UStevesPooledActorSystem* PoolSys = TestWorld.GetPoolSystem();
+	if (!TestNotNull(TEXT("Pool system"), PoolSys))
+	{
+		return false;
+	}
+
+	UClass* Class = AActor::StaticClass();
+	constexpr int32 NumActors = 100000;
+	// Bursts the size of a weapon firing projectiles, up to bigger batches
+	for (const int32 BurstSize : {1, 8, 30, 60, 256})
+	{
+		PoolSys->PreWarmActorPool(Class, BurstSize);
+		TArray<FTransform> Transforms;
+		for (int32 i = 0; i < BurstSize; ++i)
+		{
+			Transforms.Add(FTransform(FVector(i, 0, 0)));
+		}
+		const int32 NumBursts = NumActors / BurstSize;
+
+		// Only the gets are timed; both sides release the same way
+		TArray<AActor*> Actors;
+		double SingleTime = 0;
+		for (int32 b = 0; b < NumBursts; ++b)
+		{
+			const double Start = FPlatformTime::Seconds();
+			for (const FTransform& Transform : Transforms)
+			{
+				Actors.Add(PoolSys->GetPooledActor<AActor>(Class, Transform.GetLocation(), Transform.Rotator()));
+			}
+			SingleTime += FPlatformTime::Seconds() - Start;
+			for (AActor* Actor : Actors)
+			{
+				PoolSys->ReleasePooledActor(Actor);
+			}
+			Actors.Reset();
+		}
+
+		double BatchedTime = 0;
+		int NumReused = 0;
+		int TotalReused = 0;
+		for (int32 b = 0; b < NumBursts; ++b)
+		{
+			const double Start = FPlatformTime::Seconds();
+			PoolSys->GetPooledActors(Class, Transforms, Actors, NumReused);
+			BatchedTime += FPlatformTime::Seconds() - Start;
+			TotalReused += NumReused;
+			for (AActor* Actor : Actors)
+			{
+				PoolSys->ReleasePooledActor(Actor);
+			}
+			Actors.Reset();
+		}
+		TestEqual(FString::Printf(TEXT("Bursts of %d re-use pooled actors"), BurstSize), TotalReused, NumBursts * BurstSize);
+
+		const double NumGot = (double)NumBursts * BurstSize;
+		AddInfo(FString::Printf(TEXT("Bursts of %3d: single %.2f M actors/sec, batched %.2f M actors/sec (%.2fx)"),
+		                        BurstSize,
+		                        NumGot / FMath::Max(SingleTime, 1e-9) * 1e-6,
+		                        NumGot / FMath::Max(BatchedTime, 1e-9) * 1e-6,
+		                        SingleTime / FMath::Max(BatchedTime, 1e-9)));
+	}
+
+	return true;
+}
+
+#endif
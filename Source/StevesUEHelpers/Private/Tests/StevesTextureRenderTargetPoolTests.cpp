@@ -0,0 +1,229 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#include "StevesTextureRenderTargetPool.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const FIntPoint TestSize(64, 64);
+	/// Same memory as TestSize, so a texture of this size needs exactly one TestSize texture evicted to make room
+	const FIntPoint OtherTestSize(128, 32);
+	constexpr ETextureRenderTargetFormat TestFormat = RTF_RGBA8;
+
+	FStevesTextureRenderTargetPoolPtr MakeTestPool()
+	{
+		return MakeShared<FStevesTextureRenderTargetPool>(FName("StevesAutomationTest"), GetTransientPackage());
+	}
+
+	/// Owners are only used as keys by the pool, so any transient object will do
+	UObject* MakeTestOwner(const TCHAR* BaseName)
+	{
+		const FName Name = MakeUniqueObjectName(nullptr, UPackage::StaticClass(), FName(BaseName));
+		return NewObject<UPackage>(nullptr, Name, RF_Transient);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesTextureRenderTargetPoolReleaseTest,
+                                 "StevesUEHelpers.TextureRenderTargetPool.Release",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesTextureRenderTargetPoolReleaseTest::RunTest(const FString& Parameters)
+{
+	auto Pool = MakeTestPool();
+	UObject* Owner = MakeTestOwner(TEXT("ReleaseOwner"));
+
+	auto Res = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	if (!TestTrue(TEXT("Reservation is ready"), Res.IsValid() && Res->IsReady()))
+	{
+		return false;
+	}
+	const UTextureRenderTarget2D* Tex = Res->Texture.Get();
+	TestEqual(TEXT("Misses after first reservation"), (int32)Pool->GetNumMisses(), 1);
+
+	// While reserved, the same texture mustn't be handed out again
+	auto Other = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestTrue(TEXT("Reserved texture is not shared"), Other.IsValid() && Other->Texture.Get() != Tex);
+	TestEqual(TEXT("Misses while first is reserved"), (int32)Pool->GetNumMisses(), 2);
+
+	// Keep the other one reserved so the released texture is the only one to choose from
+	Res.Reset();
+	auto Again = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestTrue(TEXT("Released texture is re-used"), Again.IsValid() && Again->Texture.Get() == Tex);
+	TestEqual(TEXT("Hits after re-use"), (int32)Pool->GetNumHits(), 1);
+	TestEqual(TEXT("No textures created by re-use"), (int32)Pool->GetNumMisses(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesTextureRenderTargetPoolRevokeByOwnerTest,
+                                 "StevesUEHelpers.TextureRenderTargetPool.RevokeByOwner",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesTextureRenderTargetPoolRevokeByOwnerTest::RunTest(const FString& Parameters)
+{
+	auto Pool = MakeTestPool();
+	UObject* OwnerA = MakeTestOwner(TEXT("RevokeOwnerA"));
+	UObject* OwnerB = MakeTestOwner(TEXT("RevokeOwnerB"));
+
+	auto ResA = Pool->ReserveTexture(TestSize, TestFormat, OwnerA);
+	auto ResB = Pool->ReserveTexture(TestSize, TestFormat, OwnerB);
+	if (!TestTrue(TEXT("Reservations are ready"), ResA.IsValid() && ResA->IsReady() && ResB.IsValid() && ResB->IsReady()))
+	{
+		return false;
+	}
+	const UTextureRenderTarget2D* TexA = ResA->Texture.Get();
+	const UTextureRenderTarget2D* TexB = ResB->Texture.Get();
+
+	Pool->RevokeReservations(OwnerA);
+
+	// Only A's texture should have gone back to the pool
+	auto ResC = Pool->ReserveTexture(TestSize, TestFormat, OwnerB);
+	TestTrue(TEXT("Revoked texture is re-used"), ResC.IsValid() && ResC->Texture.Get() == TexA);
+	auto ResD = Pool->ReserveTexture(TestSize, TestFormat, OwnerB);
+	TestTrue(TEXT("Other owner's texture is still reserved"), ResD.IsValid() && ResD->Texture.Get() != TexB && ResD->Texture.Get() != TexA);
+	TestEqual(TEXT("Hits"), (int32)Pool->GetNumHits(), 1);
+	TestEqual(TEXT("Misses"), (int32)Pool->GetNumMisses(), 3);
+
+	// Revoking an owner with nothing reserved does nothing
+	Pool->RevokeReservations(OwnerA);
+	auto ResE = Pool->ReserveTexture(TestSize, TestFormat, OwnerA);
+	TestEqual(TEXT("Misses after revoking an owner with no reservations"), (int32)Pool->GetNumMisses(), 4);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesTextureRenderTargetPoolStaleReservationTest,
+                                 "StevesUEHelpers.TextureRenderTargetPool.StaleRevokedReservation",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesTextureRenderTargetPoolStaleReservationTest::RunTest(const FString& Parameters)
+{
+	auto Pool = MakeTestPool();
+	UObject* OwnerA = MakeTestOwner(TEXT("StaleOwnerA"));
+	UObject* OwnerB = MakeTestOwner(TEXT("StaleOwnerB"));
+
+	auto Stale = Pool->ReserveTexture(TestSize, TestFormat, OwnerA);
+	if (!TestTrue(TEXT("Reservation is ready"), Stale.IsValid() && Stale->IsReady()))
+	{
+		return false;
+	}
+	const UTextureRenderTarget2D* Tex = Stale->Texture.Get();
+
+	Pool->RevokeReservations(OwnerA);
+	auto Current = Pool->ReserveTexture(TestSize, TestFormat, OwnerB);
+	if (!TestTrue(TEXT("Revoked texture is reserved again"), Current.IsValid() && Current->Texture.Get() == Tex))
+	{
+		return false;
+	}
+
+	// Destroying the stale reservation must not release the texture from under the new one
+	AddExpectedError(TEXT("that was not found"), EAutomationExpectedErrorFlags::Contains, 1);
+	Stale.Reset();
+	TestTrue(TEXT("Current reservation still has its texture"), Current->IsReady() && Current->Texture.Get() == Tex);
+	auto Other = Pool->ReserveTexture(TestSize, TestFormat, OwnerA);
+	TestTrue(TEXT("Texture is still reserved"), Other.IsValid() && Other->Texture.Get() != Tex);
+	TestEqual(TEXT("Misses"), (int32)Pool->GetNumMisses(), 2);
+
+	// The current reservation still releases normally
+	Current.Reset();
+	auto Again = Pool->ReserveTexture(TestSize, TestFormat, OwnerA);
+	TestTrue(TEXT("Texture is re-used once the current reservation is released"), Again.IsValid() && Again->Texture.Get() == Tex);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesTextureRenderTargetPoolMemoryCapTest,
+                                 "StevesUEHelpers.TextureRenderTargetPool.MemoryCapEvictsLeastRecentlyUsed",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesTextureRenderTargetPoolMemoryCapTest::RunTest(const FString& Parameters)
+{
+	auto Pool = MakeTestPool();
+	UObject* Owner = MakeTestOwner(TEXT("MemoryCapOwner"));
+
+	auto Res1 = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	if (!TestTrue(TEXT("Reservation is ready"), Res1.IsValid() && Res1->IsReady()))
+	{
+		return false;
+	}
+	const uint64 TexMemory = Pool->GetTotalMemory();
+	if (!TestTrue(TEXT("Texture memory is estimated"), TexMemory > 0))
+	{
+		return false;
+	}
+	Pool->SetMaxMemory(TexMemory * 3);
+
+	auto Res2 = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	auto Res3 = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	const UTextureRenderTarget2D* Tex1 = Res1->Texture.Get();
+	const UTextureRenderTarget2D* Tex3 = Res3->Texture.Get();
+
+	// Release out of creation order, so LRU order is 2, 1, 3
+	Res2.Reset();
+	Res1.Reset();
+	Res3.Reset();
+
+	// Pool is full, so each new size has to evict the least recently released texture
+	auto Big1 = Pool->ReserveTexture(OtherTestSize, TestFormat, Owner);
+	TestTrue(TEXT("First reservation over the cap succeeds"), Big1.IsValid() && Big1->IsReady());
+	TestEqual(TEXT("Evictions after first reservation over the cap"), (int32)Pool->GetNumEvictions(), 1);
+	auto Big2 = Pool->ReserveTexture(OtherTestSize, TestFormat, Owner);
+	TestTrue(TEXT("Second reservation over the cap succeeds"), Big2.IsValid() && Big2->IsReady());
+	TestEqual(TEXT("Evictions after second reservation over the cap"), (int32)Pool->GetNumEvictions(), 2);
+	TestTrue(TEXT("Memory is within the cap"), Pool->GetTotalMemory() <= Pool->GetMaxMemory());
+
+	// 2 then 1 were evicted, so the only texture left to re-use is 3
+	auto Survivor = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestTrue(TEXT("Most recently released texture survives"), Survivor.IsValid() && Survivor->Texture.Get() == Tex3 && Survivor->Texture.Get() != Tex1);
+
+	// Nothing left to evict, so exceeding the cap fails
+	AddExpectedError(TEXT("would exceed memory cap"), EAutomationExpectedErrorFlags::Contains, 1);
+	auto Failed = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestFalse(TEXT("Reservation fails when nothing can be evicted"), Failed.IsValid());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStevesTextureRenderTargetPoolDrainTest,
+                                 "StevesUEHelpers.TextureRenderTargetPool.DrainUnreserved",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FStevesTextureRenderTargetPoolDrainTest::RunTest(const FString& Parameters)
+{
+	auto Pool = MakeTestPool();
+	UObject* Owner = MakeTestOwner(TEXT("DrainOwner"));
+
+	auto Kept = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	auto Released = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	if (!TestTrue(TEXT("Reservations are ready"), Kept.IsValid() && Kept->IsReady() && Released.IsValid() && Released->IsReady()))
+	{
+		return false;
+	}
+	const UTextureRenderTarget2D* KeptTex = Kept->Texture.Get();
+	const uint64 TexMemory = Pool->GetTotalMemory() / 2;
+	Released.Reset();
+
+	Pool->DrainPool(false);
+
+	TestTrue(TEXT("Reserved texture survives"), Kept->IsReady() && Kept->Texture.Get() == KeptTex);
+	TestTrue(TEXT("Only the reserved texture's memory remains"), Pool->GetTotalMemory() == TexMemory);
+
+	// Unreserved texture has gone, so a new one has to be created
+	auto Res = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestTrue(TEXT("New texture created after drain"), Res.IsValid() && Res->Texture.Get() != KeptTex);
+	TestEqual(TEXT("Hits"), (int32)Pool->GetNumHits(), 0);
+	TestEqual(TEXT("Misses"), (int32)Pool->GetNumMisses(), 3);
+
+	// The kept reservation still releases back into the pool
+	Kept.Reset();
+	auto Again = Pool->ReserveTexture(TestSize, TestFormat, Owner);
+	TestTrue(TEXT("Kept texture is re-used after release"), Again.IsValid() && Again->Texture.Get() == KeptTex);
+
+	return true;
+}
+
+#endif
@@ -77,6 +77,59 @@ public:
 	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
 	static FVector BalancedRandomPointInBox(FStevesBalancedRandomStream& Stream, const FVector& Min, const FVector& Max) { return Stream.RandPointInBox(FBox(Min, Max)); }
 
+	UFUNCTION(BlueprintPure, Category="StevesUEHelpers|Random", meta=(NativeMakeFunc))
+	static FStevesSobolRandomStream MakeSobolRandomStream(int64 Seed, int NumDimensions = 3);
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector2D SobolRandom2D(FStevesSobolRandomStream& Stream) { return FVector2D(Stream.Rand2D()); }
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector SobolRandom3D(FStevesSobolRandomStream& Stream) { return Stream.Rand3D(); }
+
+	UFUNCTION(BlueprintPure, Category="StevesUEHelpers|Random", meta=(NativeMakeFunc))
+	static FStevesRdRandomStream MakeRdRandomStream(int64 Seed, int NumDimensions = 3);
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector2D RdRandom2D(FStevesRdRandomStream& Stream) { return FVector2D(Stream.Rand2D()); }
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector RdRandom3D(FStevesRdRandomStream& Stream) { return Stream.Rand3D(); }
+
+	UFUNCTION(BlueprintPure, Category="StevesUEHelpers|Random", meta=(NativeMakeFunc))
+	static FStevesScrambledHaltonRandomStream MakeScrambledHaltonRandomStream(int64 Seed, int NumDimensions = 3);
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector2D ScrambledHaltonRandom2D(FStevesScrambledHaltonRandomStream& Stream) { return FVector2D(Stream.Rand2D()); }
+
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static FVector ScrambledHaltonRandom3D(FStevesScrambledHaltonRandomStream& Stream) { return Stream.Rand3D(); }
+
+	/**
+	 * Generate Poisson disk distributed points in a 2D rectangle; points will be no closer than Distance to each other
+	 * but will fill the area without large gaps.
+	 * @param Stream The random stream to use
+	 * @param Min The minimum corner of the rectangle
+	 * @param Max The maximum corner of the rectangle
+	 * @param Distance The minimum distance between points
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @return The generated points
+	 */
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static TArray<FVector2D> PoissonDiskPointsInRect(FStevesBalancedRandomStream& Stream, const FVector2D& Min, const FVector2D& Max, float Distance, int MaxAttempts = 30);
+
+	/**
+	 * Generate Poisson disk distributed points in a 3D box; points will be no closer than Distance to each other
+	 * but will fill the volume without large gaps.
+	 * @param Stream The random stream to use
+	 * @param Min The minimum corner of the box
+	 * @param Max The maximum corner of the box
+	 * @param Distance The minimum distance between points
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @return The generated points
+	 */
+	UFUNCTION(BlueprintCallable, Category="StevesUEHelpers|Random")
+	static TArray<FVector> PoissonDiskPointsInBox(FStevesBalancedRandomStream& Stream, const FVector& Min, const FVector& Max, float Distance, int MaxAttempts = 30);
+
 	
 	/**
 	 * Let the content streaming system know that there is a viewpoint other than a possessed camera that should be taken
@@ -17,6 +17,42 @@ namespace StevesRandConstants
 	constexpr float kOneOverThree = 1.0f / 3.0f;
 	constexpr float kOneOverFive = 1.0f / 5.0f;
 
+	/// Maximum dimensions for the Sobol, R-d and scrambled Halton streams
+	constexpr int32 kMaxLowDiscrepancyDimensions = 8;
+	/// Bases used by each dimension of the scrambled Halton stream
+	constexpr uint32 kHaltonBases[kMaxLowDiscrepancyDimensions] = {2, 3, 5, 7, 11, 13, 17, 19};
+	constexpr int32 kMaxHaltonBase = 19;
+
+	/// Convert a full range 32-bit integer to a float 0..1, exclusive of 1
+	FORCEINLINE float UIntToUnitFloat(uint32 Value)
+	{
+		// Only 24 bits fit in a float mantissa; using more would round up to 1
+		return (Value >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/// 3^16, the period of the 2D stream. Base 3 digits of its seeds are reversed over 16 places
+	constexpr uint32 kPow3_16 = 43046721;
+	/// 3^15 and 5^10. Base 3 and base 5 digits of the 3D stream's seeds are reversed over 15 and 10 places
+	constexpr uint32 kPow3_15 = 14348907;
+	constexpr uint32 kPow5_10 = 9765625;
+	constexpr float kInvPow3_16 = (float)(1.0 / kPow3_16);
+	constexpr float kInvPow3_15 = (float)(1.0 / kPow3_15);
+	constexpr float kInvPow5_10 = (float)(1.0 / kPow5_10);
+	static_assert(kSafeMaxSeed2D + 1 == kPow3_16 && kSafeMaxSeed3D + 1 == kPow5_10 && kSafeMaxSeed3D < kPow3_15,
+	              "Digit reversal must cover every safe seed");
+
+	/**
+	 * Convert the digits of a seed, reversed about the radix point and held as an integer, to a float 0..1.
+	 * The 2D / 3D streams derive every value this way from integer state, whether they stepped or seeked to it, so
+	 * values only depend on the position in the sequence.
+	 * @param Reversed The reversed digits, < Base^NumDigits
+	 * @param InvScale 1 / Base^NumDigits
+	 */
+	FORCEINLINE float ReversedDigitsToUnitFloat(uint32 Reversed, float InvScale)
+	{
+		return (float)(int32)Reversed * InvScale;
+	}
+
 }
 
 /// "Balanced" random stream, using the Halton Sequence
@@ -266,6 +302,65 @@ public:
 	}
 	
 	
+	/**
+	 * Get the number of values generated since the stream was initialised / reset, i.e. the index of the next value,
+	 * modulo the period of the stream.
+	 */
+	uint32 GetPosition() const
+	{
+		// Seeds run InitialSeed..kSafeMaxSeed3D, then wrap to 1
+		constexpr uint32 Period = StevesRandConstants::kSafeMaxSeed3D;
+		return Seed >= InitialSeed ? Seed - InitialSeed : Period - InitialSeed + Seed;
+	}
+
+	/**
+	 * Jump to a position in the sequence, as if the stream had been reset and then Rand / Rand2D / Rand3D had been
+	 * called Index times. Cost is O(log Index), not O(Index).
+	 * @param Index The number of values from the initial seed
+	 */
+	void SeekTo(uint64 Index)
+	{
+		// See SafeSeed, after the first pass seeds cycle through 1..kSafeMaxSeed3D
+		constexpr uint64 Period = StevesRandConstants::kSafeMaxSeed3D;
+		const uint64 Target = (uint64)InitialSeed + Index;
+		Seed = Target <= Period ? (uint32)Target : (uint32)((Target - 1) % Period) + 1;
+		UpdateSeeds();
+	}
+
+	/**
+	 * Split the next Count values of this stream into contiguous partitions which can be generated independently,
+	 * e.g. one per worker in a ParallelFor. Partition i covers values [i * N, min((i + 1) * N, Count)) relative to the
+	 * current position, where N is the return value. This stream is not advanced; SeekTo past the range afterwards
+	 * if you want to carry on from the end of it.
+	 * @param NumPartitions The number of partitions
+	 * @param Count The total number of values to partition
+	 * @param OutStreams One stream per partition, positioned at the start of that partition
+	 * @return The number of values in each partition (the last one may have fewer)
+	 */
+	uint32 Split(int32 NumPartitions, uint32 Count, TArray<FStevesBalancedRandomStream>& OutStreams) const
+	{
+		NumPartitions = FMath::Max(1, NumPartitions);
+		const uint32 PerPartition = FMath::DivideAndRoundUp(Count, (uint32)NumPartitions);
+		const uint64 Start = GetPosition();
+		OutStreams.SetNum(NumPartitions);
+		for (int32 i = 0; i < NumPartitions; ++i)
+		{
+			OutStreams[i] = *this;
+			OutStreams[i].SeekTo(Start + (uint64)i * PerPartition);
+		}
+		return PerPartition;
+	}
+
+	/**
+	 * Serialise the state of the stream compactly, as just the initial seed and position (plus the number of
+	 * dimensions where relevant). Everything else is derived on load via SeekTo, so restoring is O(log n) rather
+	 * than replaying every value.
+	 */
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	/// Replicates the compact state, so clients can reproduce the same sequence from a few bytes
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 	FString ToString() const
 	{
 		return FString::Printf(TEXT("FStevesBalancedRandomStream(InitialSeed=%u, Seed=%u)"), InitialSeed, Seed);
@@ -274,6 +369,16 @@ public:
 	
 };
 
+template<>
+struct TStructOpsTypeTraits<FStevesBalancedRandomStream> : public TStructOpsTypeTraitsBase2<FStevesBalancedRandomStream>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
 /// "Balanced" random stream, using the Halton Sequence, one dimension only (more efficient for this than FStevesBalancedRandomStream)
 /// This is deterministic and more uniform in appearance than a general random stream (although not perfectly uniform)
 USTRUCT(BlueprintType)
@@ -411,6 +516,55 @@ public:
 	}
 	
 	
+	/**
+	 * Get the number of values generated since the stream was initialised / reset, i.e. the index of the next value,
+	 * modulo the period of the stream.
+	 */
+	uint32 GetPosition() const
+	{
+		return Seed - InitialSeed;
+	}
+
+	/**
+	 * Jump to a position in the sequence, as if the stream had been reset and then Rand had been
+	 * called Index times. Cost is O(log Index), not O(Index).
+	 * @param Index The number of values from the initial seed
+	 */
+	void SeekTo(uint64 Index)
+	{
+		// Seed wraps at 32 bits
+		Seed = InitialSeed + (uint32)Index;
+	}
+
+	/**
+	 * Split the next Count values of this stream into contiguous partitions which can be generated independently,
+	 * e.g. one per worker in a ParallelFor. Partition i covers values [i * N, min((i + 1) * N, Count)) relative to the
+	 * current position, where N is the return value. This stream is not advanced; SeekTo past the range afterwards
+	 * if you want to carry on from the end of it.
+	 * @param NumPartitions The number of partitions
+	 * @param Count The total number of values to partition
+	 * @param OutStreams One stream per partition, positioned at the start of that partition
+	 * @return The number of values in each partition (the last one may have fewer)
+	 */
+	uint32 Split(int32 NumPartitions, uint32 Count, TArray<FStevesBalancedRandomStream1D>& OutStreams) const
+	{
+		NumPartitions = FMath::Max(1, NumPartitions);
+		const uint32 PerPartition = FMath::DivideAndRoundUp(Count, (uint32)NumPartitions);
+		const uint64 Start = GetPosition();
+		OutStreams.SetNum(NumPartitions);
+		for (int32 i = 0; i < NumPartitions; ++i)
+		{
+			OutStreams[i] = *this;
+			OutStreams[i].SeekTo(Start + (uint64)i * PerPartition);
+		}
+		return PerPartition;
+	}
+
+	/// Serialise the state compactly as the initial seed & position, see FStevesBalancedRandomStream::SerializeState
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 	FString ToString() const
 	{
 		return FString::Printf(TEXT("FStevesBalancedRandomStream1D(InitialSeed=%u, Seed=%u)"), InitialSeed, Seed);
@@ -418,6 +572,16 @@ public:
 	
 };
 
+template<>
+struct TStructOpsTypeTraits<FStevesBalancedRandomStream1D> : public TStructOpsTypeTraitsBase2<FStevesBalancedRandomStream1D>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
 
 /// "Balanced" 2D random stream, using the Halton Sequence. More efficient than the general FStevesBalancedRandomStream for 2D work
 /// This is deterministic and more uniform in appearance than a general random stream (although not perfectly uniform)
@@ -430,10 +594,63 @@ protected:
 	uint32 InitialSeed = 0;
 	uint32 Base2Seed = 0;
 	uint32 Base3Seed = 0;
+	/// Base 3 digits of Base2Seed reversed over 16 places, so digit i has weight 3^(15-i)
+	uint32 Base3Reversed = 0;
 
 	
 	FVector2f CurrentValue = FVector2f::ZeroVector;
 
+	/// Move to the next value in the sequence, updating CurrentValue
+	FORCEINLINE void Advance()
+	{
+		AdvanceDigits();
+		CurrentValue = GetValue(Base2Seed, Base3Reversed);
+	}
+
+	/// Move to the next seed, updating the integer state but not CurrentValue
+	FORCEINLINE void AdvanceDigits()
+	{
+		// base 2 is just the bits reversed, so only needs the seed
+		Base2Seed++;
+
+		/////////////////////////////////////
+		// base 3: use 2 bits for each base 3 digit.
+		// Digits are accumulated in integers rather than floats, so the value is exact wherever we arrived from
+
+		uint32_t Mask = 0x3;  // also the max base 3 digit
+		uint32_t Add  = 0x1;  // amount to Add to force carry once digit==3
+		uint32_t Weight = StevesRandConstants::kPow3_16 / 3;
+
+		Base3Seed++;
+
+		// expected iterations: 1.5
+		while (true)
+		{
+			if ((Base3Seed & Mask) == Mask)
+			{
+				Base3Seed += Add;          // force carry into next 2-bit digit
+				Base3Reversed -= 2 * Weight;
+
+				Mask = Mask << 2;
+				Add  = Add  << 2;
+
+				Weight /= 3;
+			}
+			else
+			{
+				Base3Reversed += Weight;     // we know digit n has gone from a to a + 1
+				break;
+			}
+		}
+	}
+
+	/// The value for a seed, from its integer state. The only place values are calculated, so stepping, seeking and
+	/// batches always agree bit for bit
+	static FORCEINLINE FVector2f GetValue(uint32 InBase2Seed, uint32 InBase3Reversed)
+	{
+		return FVector2f(StevesRandConstants::UIntToUnitFloat(ReverseBits(InBase2Seed)),
+		                 StevesRandConstants::ReversedDigitsToUnitFloat(InBase3Reversed, StevesRandConstants::kInvPow3_16));
+	}
 
 public:
 
@@ -477,22 +694,20 @@ public:
 		}
 		
 		InitialSeed = Base2Seed = InSeed;
-		
-		CurrentValue.X = Halton(Base2Seed, 2);
 
-		CurrentValue.Y = 0;
 		Base3Seed = 0;
-
-		float ip = StevesRandConstants::kOneOverThree;
-		float p = ip;
+		Base3Reversed = 0;
+		uint32 Weight = StevesRandConstants::kPow3_16 / 3;
 
 		for (int i = 0, k = Base2Seed; k; i += 2, k /= 3)
 		{
 			int d = (k % 3);
 			Base3Seed |= d << i;
-			CurrentValue.Y += d * p;
-			p *= ip;
+			Base3Reversed += d * Weight;
+			Weight /= 3;
 		}
+
+		CurrentValue = GetValue(Base2Seed, Base3Reversed);
 	}
 
 	/**
@@ -548,64 +763,7 @@ public:
 		// This uses Andrew Wilmott's approach of calculating the next value at the same time as incrementing
 		// We calculate the new value while initialising / incrementing, so it's currently correct
 		const FVector2f Ret = CurrentValue;
-		
-		/////////////////////////////////////
-		// base 2
-
-		uint32_t OldBase2Seed = Base2Seed;
-		Base2Seed++;
-		uint32_t Diff = Base2Seed ^ OldBase2Seed;
-
-		// bottom bit always changes, higher bits
-		// change less frequently.
-		float s = 0.5f;
-
-		// Diff will be of the form 0 * 1 +, i.e. one bits up until the last carry.
-		// expected iterations = 1 + 0.5 + 0.25 + ... = 2
-		do
-		{
-			if (OldBase2Seed & 1)
-				CurrentValue.X -= s;
-			else
-				CurrentValue.X += s;
-
-			s *= 0.5f;
-
-			Diff = Diff >> 1;
-			OldBase2Seed = OldBase2Seed >> 1;
-		}
-		while (Diff);
-
-
-		/////////////////////////////////////
-		// base 3: use 2 bits for each base 3 digit.
-
-		uint32_t Mask = 0x3;  // also the max base 3 digit
-		uint32_t Add  = 0x1;  // amount to Add to force carry once digit==3
-		s = StevesRandConstants::kOneOverThree;
-
-		Base3Seed++;
-
-		// expected iterations: 1.5
-		while (true)
-		{
-			if ((Base3Seed & Mask) == Mask)
-			{
-				Base3Seed += Add;          // force carry into next 2-bit digit
-				CurrentValue.Y -= 2 * s;
-
-				Mask = Mask << 2;
-				Add  = Add  << 2;
-
-				s *= StevesRandConstants::kOneOverThree;
-			}
-			else
-			{
-				CurrentValue.Y += s;     // we know digit n has gone from a to a + 1
-				break;
-			}
-		}
-		
+		Advance();
 		return Ret;
 	}
 	
@@ -628,6 +786,28 @@ public:
 		return FVector2f(FMath::Lerp(Rect.Min.X, Rect.Max.X, R2.X),
 					   FMath::Lerp(Rect.Min.Y, Rect.Max.Y, R2.Y));
 	}
+
+	/**
+	 * Fill an array with consecutive 2D values, bit-identical to calling Rand2D for each one. Values are converted
+	 * 4 at a time in vector registers, so large batches are faster than calling Rand2D in a loop.
+	 * @param OutValues Values to fill; the stream advances by the number of elements
+	 */
+	void Rand2DBatch(TArrayView<FVector2f> OutValues);
+
+	/**
+	 * Fill an array with consecutive random points in a 2D rectangle, identical to calling RandPointInBox2D for each.
+	 * @param Rect The rectangle
+	 * @param OutPoints Points to fill; the stream advances by the number of elements
+	 */
+	void RandPointInBox2DBatch(const FBox2D& Rect, TArrayView<FVector2f> OutPoints)
+	{
+		Rand2DBatch(OutPoints);
+		for (FVector2f& P : OutPoints)
+		{
+			P = FVector2f(FMath::Lerp(Rect.Min.X, Rect.Max.X, P.X),
+			              FMath::Lerp(Rect.Min.Y, Rect.Max.Y, P.Y));
+		}
+	}
 	
 	/// Random point in a circle
 	FORCEINLINE FVector2f RandPointInCircle(float Radius = 1.0)
@@ -654,12 +834,77 @@ public:
 	}
 	
 	
+	/**
+	 * Get the number of values generated since the stream was initialised / reset, i.e. the index of the next value,
+	 * modulo the period of the stream.
+	 */
+	uint32 GetPosition() const
+	{
+		// Seeds run InitialSeed..kSafeMaxSeed2D-1, then wrap to 0
+		constexpr uint32 Period = StevesRandConstants::kSafeMaxSeed2D;
+		return ((uint64)Base2Seed + Period - InitialSeed) % Period;
+	}
+
+	/**
+	 * Jump to a position in the sequence, as if the stream had been reset and then Rand2D had been
+	 * called Index times. Cost is O(log Index), not O(Index).
+	 * Values only depend on the position, so they're bit-identical to a stream which stepped there with Rand2D; the
+	 * same goes for Split partitions and batches, whatever way the work is divided up.
+	 * @param Index The number of values from the initial seed
+	 */
+	void SeekTo(uint64 Index)
+	{
+		constexpr uint64 Period = StevesRandConstants::kSafeMaxSeed2D;
+		const uint32 KeepInitialSeed = InitialSeed;
+		Initialize((uint32)(((uint64)InitialSeed + Index) % Period));
+		InitialSeed = KeepInitialSeed;
+	}
+
+	/**
+	 * Split the next Count values of this stream into contiguous partitions which can be generated independently,
+	 * e.g. one per worker in a ParallelFor. Partition i covers values [i * N, min((i + 1) * N, Count)) relative to the
+	 * current position, where N is the return value. This stream is not advanced; SeekTo past the range afterwards
+	 * if you want to carry on from the end of it.
+	 * @param NumPartitions The number of partitions
+	 * @param Count The total number of values to partition
+	 * @param OutStreams One stream per partition, positioned at the start of that partition
+	 * @return The number of values in each partition (the last one may have fewer)
+	 */
+	uint32 Split(int32 NumPartitions, uint32 Count, TArray<FStevesBalancedRandomStream2D>& OutStreams) const
+	{
+		NumPartitions = FMath::Max(1, NumPartitions);
+		const uint32 PerPartition = FMath::DivideAndRoundUp(Count, (uint32)NumPartitions);
+		const uint64 Start = GetPosition();
+		OutStreams.SetNum(NumPartitions);
+		for (int32 i = 0; i < NumPartitions; ++i)
+		{
+			OutStreams[i] = *this;
+			OutStreams[i].SeekTo(Start + (uint64)i * PerPartition);
+		}
+		return PerPartition;
+	}
+
+	/// Serialise the state compactly as the initial seed, position & current value
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 	FString ToString() const
 	{
 		return FString::Printf(TEXT("FStevesBalancedRandomStream2D(InitialSeed=%u, Seed=%u)"), InitialSeed, Base2Seed);
 	}	
 };
 
+template<>
+struct TStructOpsTypeTraits<FStevesBalancedRandomStream2D> : public TStructOpsTypeTraitsBase2<FStevesBalancedRandomStream2D>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
 /// "Balanced" random 3D stream, using the Halton Sequence. Optimised for 3D only, more efficient than FStevesBalancedRandomStream
 /// This is deterministic and more uniform in appearance than a general random stream (although not perfectly uniform)
 USTRUCT(BlueprintType)
@@ -672,8 +917,93 @@ protected:
 	uint32 Base2Seed = 0;
 	uint32 Base3Seed = 0;
 	uint32 Base5Seed = 0;
+	/// Base 3 & 5 digits of Base2Seed reversed over 15 & 10 places, so digit i has weight 3^(14-i) / 5^(9-i)
+	uint32 Base3Reversed = 0;
+	uint32 Base5Reversed = 0;
 	
 	FVector3f CurrentValue = FVector3f::ZeroVector;
+
+	/// Move to the next value in the sequence, updating CurrentValue
+	FORCEINLINE void Advance()
+	{
+		AdvanceDigits();
+		CurrentValue = GetValue(Base2Seed, Base3Reversed, Base5Reversed);
+	}
+
+	/// Move to the next seed, updating the integer state but not CurrentValue
+	FORCEINLINE void AdvanceDigits()
+	{
+		// base 2 is just the bits reversed, so only needs the seed
+		Base2Seed++;
+
+		// base 3: use 2 bits for each base 3 digit.
+		// Digits are accumulated in integers rather than floats, so the value is exact wherever we arrived from
+		uint32_t Mask = 0x3;  // also the max base 3 digit
+		uint32_t Add  = 0x1;  // amount to add to force carry once digit==3
+		uint32_t Weight = StevesRandConstants::kPow3_15 / 3;
+
+		Base3Seed++;
+
+		// expected iterations: 1.5
+		while (true)
+		{
+			if ((Base3Seed & Mask) == Mask)
+			{
+				Base3Seed += Add;          // force carry into next 2-bit digit
+				Base3Reversed -= 2 * Weight;
+
+				Mask = Mask << 2;
+				Add  = Add  << 2;
+
+				Weight /= 3;
+			}
+			else
+			{
+				Base3Reversed += Weight;     // we know digit n has gone from a to a + 1
+				break;
+			}
+		};
+
+		// base 5: use 3 bits for each base 5 digit.
+		Mask = 0x7;
+		Add  = 0x3;  // amount to add to force carry once digit==dmax
+		uint32_t Dmax = 0x5;  // max digit
+
+		Weight = StevesRandConstants::kPow5_10 / 5;
+
+		Base5Seed++;
+
+		// expected iterations: 1.25
+		while (true)
+		{
+			if ((Base5Seed & Mask) == Dmax)
+			{
+				Base5Seed += Add;          // force carry into next 3-bit digit
+				Base5Reversed -= 4 * Weight;
+
+				Mask = Mask << 3;
+				Dmax = Dmax << 3;
+				Add  = Add  << 3;
+
+				Weight /= 5;
+			}
+			else
+			{
+				Base5Reversed += Weight;     // we know digit n has gone from a to a + 1
+				break;
+			}
+		};
+	}
+
+	/// The value for a seed, from its integer state. The only place values are calculated, so stepping, seeking and
+	/// batches always agree bit for bit
+	static FORCEINLINE FVector3f GetValue(uint32 InBase2Seed, uint32 InBase3Reversed, uint32 InBase5Reversed)
+	{
+		return FVector3f(StevesRandConstants::UIntToUnitFloat(ReverseBits(InBase2Seed)),
+		                 StevesRandConstants::ReversedDigitsToUnitFloat(InBase3Reversed, StevesRandConstants::kInvPow3_15),
+		                 StevesRandConstants::ReversedDigitsToUnitFloat(InBase5Reversed, StevesRandConstants::kInvPow5_10));
+	}
+
 public:
 
 	FStevesBalancedRandomStream3D()
@@ -715,34 +1045,32 @@ public:
 		}
 		
 		InitialSeed = Base2Seed = InSeed;
-		
-		CurrentValue.X = Halton(Base2Seed, 2);
 
-		CurrentValue.Y = 0.0f;
 		Base3Seed = 0;
-
-		float p = StevesRandConstants::kOneOverThree;
+		Base3Reversed = 0;
+		uint32 Weight = StevesRandConstants::kPow3_15 / 3;
 
 		for (int i = 0, k = Base2Seed; k; i += 2, k /= 3)
 		{
 			int d = (k % 3);
 			Base3Seed |= d << i;
-			CurrentValue.Y += d * p;
-			p *= StevesRandConstants::kOneOverThree;
+			Base3Reversed += d * Weight;
+			Weight /= 3;
 		}
 
-		CurrentValue.Z = 0.0f;
 		Base5Seed = 0;
-
-		p = StevesRandConstants::kOneOverFive;
+		Base5Reversed = 0;
+		Weight = StevesRandConstants::kPow5_10 / 5;
 
 		for (int i = 0, k = Base2Seed; k; i += 3, k /= 5)
 		{
 			int d = (k % 5);
 			Base5Seed |= d << i;
-			CurrentValue.Z += d * p;
-			p *= StevesRandConstants::kOneOverFive;
+			Base5Reversed += d * Weight;
+			Weight /= 5;
 		}
+
+		CurrentValue = GetValue(Base2Seed, Base3Reversed, Base5Reversed);
 	}
 
 	/**
@@ -797,133 +1125,870 @@ public:
 		// This uses Andrew Wilmott's approach of calculating the next value at the same time as incrementing
 		// We calculate the new value while initialising / incrementing, so it's currently correct
 		const FVector3f Ret = CurrentValue;
-		
-		// base 2: 1 bit per digit
-		uint32_t OldBase2 = Base2Seed;
-		Base2Seed++;
-		uint32_t Diff = Base2Seed ^ OldBase2;
+		Advance();
 
-		// bottom bit always changes, higher bits
-		// change less frequently.
-		float s = 0.5f;
+		return FVector(Ret.X, Ret.Y, Ret.Z);
+	}
+	
 
-		// diff will be of the form 0 * 1 + , i.e. one bits up until the last carry.
-		// expected iterations = 1 + 0.5 + 0.25 + ... = 2
-		do
-		{
-			if (OldBase2 & 1)
-				CurrentValue.X -= s;
-			else
-				CurrentValue.X += s;
+	/**
+	 * Fill an array with consecutive 3D values, bit-identical to calling Rand3D for each one. Values are converted
+	 * 4 at a time in vector registers, so large batches are faster than calling Rand3D in a loop.
+	 * @param OutValues Values to fill; the stream advances by the number of elements
+	 */
+	void Rand3DBatch(TArrayView<FVector3f> OutValues);
 
-			s *= 0.5f;
+	/// Random point in a 3D box
+	FORCEINLINE FVector RandPointInBox(const FBox& Box)
+	{
+		const FVector R3 = Rand3D();
+		return FVector(FMath::Lerp(Box.Min.X, Box.Max.X, R3.X),
+		               FMath::Lerp(Box.Min.Y, Box.Max.Y, R3.Y),
+		               FMath::Lerp(Box.Min.Z, Box.Max.Z, R3.Z));
+	}
 
-			Diff = Diff >> 1;
-			OldBase2 = OldBase2 >> 1;
+	/**
+	 * Fill an array with consecutive random points in a 3D box, identical to calling RandPointInBox for each.
+	 * @param Box The box
+	 * @param OutPoints Points to fill; the stream advances by the number of elements
+	 */
+	void RandPointInBoxBatch(const FBox& Box, TArrayView<FVector> OutPoints)
+	{
+		// Generate in chunks so the unit values stay in cache / on the stack
+		constexpr int32 ChunkSize = 256;
+		FVector3f Values[ChunkSize];
+		for (int32 Start = 0; Start < OutPoints.Num(); Start += ChunkSize)
+		{
+			const int32 Count = FMath::Min(ChunkSize, OutPoints.Num() - Start);
+			Rand3DBatch(TArrayView<FVector3f>(Values, Count));
+			for (int32 i = 0; i < Count; ++i)
+			{
+				const FVector3f& R3 = Values[i];
+				OutPoints[Start + i] = FVector(FMath::Lerp(Box.Min.X, Box.Max.X, (double)R3.X),
+				                               FMath::Lerp(Box.Min.Y, Box.Max.Y, (double)R3.Y),
+				                               FMath::Lerp(Box.Min.Z, Box.Max.Z, (double)R3.Z));
+			}
 		}
-		while (Diff);
-
-
-		// base 3: use 2 bits for each base 3 digit.
-		uint32_t Mask = 0x3;  // also the max base 3 digit
-		uint32_t Add  = 0x1;  // amount to add to force carry once digit==3
-		s = StevesRandConstants::kOneOverThree;
+	}
 
-		Base3Seed++;
-
-		// expected iterations: 1.5
+	
+	/// Random point in a sphere
+	FORCEINLINE FVector RandPointInSphere(float Radius = 1.0)
+	{
+		// Just use rejection sampling for simplicity / speed
 		while (true)
 		{
-			if ((Base3Seed & Mask) == Mask)
+			const FVector Candidate = Rand3D();
+			if (Candidate.SquaredLength() <= 1.0)
 			{
-				Base3Seed += Add;          // force carry into next 2-bit digit
-				CurrentValue.Y -= 2 * s;
+				return Candidate * Radius;
+			}
+		}
+	}
+	
+	/**
+	 * Gets the current seed.
+	 *
+	 * @return Current seed.
+	 */
+	uint32 GetCurrentSeed() const
+	{
+		return InitialSeed;
+	}
+	
+	
+	/**
+	 * Get the number of values generated since the stream was initialised / reset, i.e. the index of the next value,
+	 * modulo the period of the stream.
+	 */
+	uint32 GetPosition() const
+	{
+		// Seeds run InitialSeed..kSafeMaxSeed3D-1, then wrap to 0
+		constexpr uint32 Period = StevesRandConstants::kSafeMaxSeed3D;
+		return ((uint64)Base2Seed + Period - InitialSeed) % Period;
+	}
 
-				Mask = Mask << 2;
-				Add  = Add  << 2;
+	/**
+	 * Jump to a position in the sequence, as if the stream had been reset and then Rand3D had been
+	 * called Index times. Cost is O(log Index), not O(Index).
+	 * Values only depend on the position, so they're bit-identical to a stream which stepped there with Rand3D; the
+	 * same goes for Split partitions and batches, whatever way the work is divided up.
+	 * @param Index The number of values from the initial seed
+	 */
+	void SeekTo(uint64 Index)
+	{
+		constexpr uint64 Period = StevesRandConstants::kSafeMaxSeed3D;
+		const uint32 KeepInitialSeed = InitialSeed;
+		Initialize((uint32)(((uint64)InitialSeed + Index) % Period));
+		InitialSeed = KeepInitialSeed;
+	}
+
+	/**
+	 * Split the next Count values of this stream into contiguous partitions which can be generated independently,
+	 * e.g. one per worker in a ParallelFor. Partition i covers values [i * N, min((i + 1) * N, Count)) relative to the
+	 * current position, where N is the return value. This stream is not advanced; SeekTo past the range afterwards
+	 * if you want to carry on from the end of it.
+	 * @param NumPartitions The number of partitions
+	 * @param Count The total number of values to partition
+	 * @param OutStreams One stream per partition, positioned at the start of that partition
+	 * @return The number of values in each partition (the last one may have fewer)
+	 */
+	uint32 Split(int32 NumPartitions, uint32 Count, TArray<FStevesBalancedRandomStream3D>& OutStreams) const
+	{
+		NumPartitions = FMath::Max(1, NumPartitions);
+		const uint32 PerPartition = FMath::DivideAndRoundUp(Count, (uint32)NumPartitions);
+		const uint64 Start = GetPosition();
+		OutStreams.SetNum(NumPartitions);
+		for (int32 i = 0; i < NumPartitions; ++i)
+		{
+			OutStreams[i] = *this;
+			OutStreams[i].SeekTo(Start + (uint64)i * PerPartition);
+		}
+		return PerPartition;
+	}
+
+	/// Serialise the state compactly as the initial seed, position & current value
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("FStevesBalancedRandomStream(InitialSeed=%u, Seed=%u)"), InitialSeed, Base2Seed);
+	}	
+
+	
+};
+
+template<>
+struct TStructOpsTypeTraits<FStevesBalancedRandomStream3D> : public TStructOpsTypeTraitsBase2<FStevesBalancedRandomStream3D>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
+/// Helpers shared by the Sobol, R-d and scrambled Halton streams
+namespace StevesLowDiscrepancy
+{
+	/// Make sure a stream has at least MinDimensions dimensions, growing it at its current position if not. Growing
+	/// an R-d stream changes its sequence in every dimension, since the recurrence depends on the dimension count.
+	template <typename TStream>
+	void EnsureNumDimensions(TStream& Stream, int32 MinDimensions)
+	{
+		if (Stream.GetNumDimensions() < MinDimensions)
+		{
+			const uint64 Position = Stream.GetPosition();
+			Stream.SetNumDimensions(MinDimensions);
+			Stream.SeekTo(Position);
+		}
+	}
 
-				s *= StevesRandConstants::kOneOverThree;
+	/// Get the next 2D value from a stream, from its first 2 dimensions. Streams with fewer are grown to 2
+	template <typename TStream>
+	FVector2f Rand2D(TStream& Stream)
+	{
+		EnsureNumDimensions(Stream, 2);
+		float V[StevesRandConstants::kMaxLowDiscrepancyDimensions];
+		Stream.Next(TArrayView<float>(V, Stream.GetNumDimensions()));
+		return FVector2f(V[0], V[1]);
+	}
+
+	/// Get the next 3D value from a stream, from its first 3 dimensions. Streams with fewer are grown to 3, so this
+	/// always returns a real 3D point
+	template <typename TStream>
+	FVector Rand3D(TStream& Stream)
+	{
+		EnsureNumDimensions(Stream, 3);
+		float V[StevesRandConstants::kMaxLowDiscrepancyDimensions];
+		Stream.Next(TArrayView<float>(V, Stream.GetNumDimensions()));
+		return FVector(V[0], V[1], V[2]);
+	}
+}
+
+
+/// Owen-scrambled Sobol sequence, in up to kMaxLowDiscrepancyDimensions dimensions.
+/// Unlike the Halton streams, the seed doesn't pick a starting point in the sequence; it picks the scrambling, so
+/// every seed produces a different but equally well distributed sequence, and every prefix of it is well distributed
+/// (particularly power-of-two sized ones). Values are generated with integers only and don't lose precision, so the
+/// sequence runs for 2^32 values before repeating.
+USTRUCT(BlueprintType)
+struct STEVESUEHELPERS_API FStevesSobolRandomStream
+{
+	GENERATED_BODY()
+
+protected:
+	uint32 InitialSeed = 0;
+	uint32 Index = 0;
+	int32 NumDimensions = 3;
+	/// Unscrambled Sobol value for each dimension at Index
+	uint32 State[StevesRandConstants::kMaxLowDiscrepancyDimensions] = {};
+	uint32 ScrambleSeeds[StevesRandConstants::kMaxLowDiscrepancyDimensions] = {};
+	/// 32 direction numbers for each dimension
+	const uint32 (*Directions)[32] = nullptr;
+
+	static const uint32 (*GetDirectionNumbers())[32];
+
+	/// Nested uniform (Owen) scramble, using Laine-Karras style hashing (see Burley 2020, "Practical Hash-based Owen Scrambling")
+	static FORCEINLINE uint32 OwenScramble(uint32 X, uint32 Seed)
+	{
+		X = ReverseBits(X);
+		X += Seed;
+		X ^= X * 0x6c50b47cu;
+		X ^= X * 0xb82f1e52u;
+		X ^= X * 0xc7afe638u;
+		X ^= X * 0x8d22f6e6u;
+		return ReverseBits(X);
+	}
+
+public:
+
+	FStevesSobolRandomStream()
+	{
+		Initialize(0);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 * @param InNumDimensions The number of dimensions in each value
+	 */
+	FStevesSobolRandomStream( uint32 InSeed, int32 InNumDimensions = 3 )
+	{
+		SetNumDimensions(InNumDimensions);
+		Initialize(InSeed);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	FStevesSobolRandomStream( FName InName )
+	{
+		Initialize(InName);
+	}
+
+	/**
+	 * Initializes this random stream with the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 */
+	void Initialize( uint32 InSeed )
+	{
+		InitialSeed = InSeed;
+		Directions = GetDirectionNumbers();
+		for (int32 D = 0; D < StevesRandConstants::kMaxLowDiscrepancyDimensions; ++D)
+		{
+			ScrambleSeeds[D] = MurmurFinalize32(InSeed + D * 0x9e3779b9u);
+		}
+		SeekTo(0);
+	}
+
+	/**
+	 * Initializes this random stream using the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	void Initialize( FName InName )
+	{
+		uint32 StartSeed;
+		if (InName != NAME_None)
+		{
+			StartSeed = GetTypeHash(InName.ToString());
+		}
+		else
+		{
+			StartSeed = FPlatformTime::Cycles();
+		}
+		Initialize(StartSeed);
+	}
+
+	/**
+	 * Resets this random stream to the initial seed value.
+	 */
+	void Reset()
+	{
+		Initialize(InitialSeed);
+	}	
+
+	uint32 GetInitialSeed() const
+	{
+		return InitialSeed;
+	}
+
+	/**
+	 * Generates a new random seed.
+	 */
+	void GenerateNewSeed()
+	{
+		Initialize(FMath::Rand());
+	}
+
+	/// Change the number of dimensions in each value (1..kMaxLowDiscrepancyDimensions). Resets the stream.
+	void SetNumDimensions(int32 InNumDimensions)
+	{
+		NumDimensions = FMath::Clamp(InNumDimensions, 1, StevesRandConstants::kMaxLowDiscrepancyDimensions);
+		Reset();
+	}
+
+	int32 GetNumDimensions() const
+	{
+		return NumDimensions;
+	}
+
+	/// Get the index of the next value in the sequence
+	uint32 GetPosition() const
+	{
+		return Index;
+	}
+
+	/**
+	 * Jump to a position in the sequence. Cost is O(log Index) per dimension.
+	 * @param InIndex The index of the next value to generate
+	 */
+	void SeekTo(uint64 InIndex)
+	{
+		Index = (uint32)InIndex;
+		const uint32 Gray = Index ^ (Index >> 1);
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			const uint32* V = Directions[D];
+			State[D] = 0;
+			for (uint32 Bits = Gray; Bits; Bits &= Bits - 1)
+			{
+				State[D] ^= V[FMath::CountTrailingZeros(Bits)];
 			}
-			else
+		}
+	}
+
+	/**
+	 * Generate the next value as full range 32-bit integers, one per dimension. This is the fastest path.
+	 * @param OutValues Must have at least GetNumDimensions() elements
+	 */
+	FORCEINLINE void NextUInt(TArrayView<uint32> OutValues)
+	{
+		check(OutValues.Num() >= NumDimensions);
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = OwenScramble(State[D], ScrambleSeeds[D]);
+		}
+
+		// Gray code order: only one direction number changes per step
+		const uint32 Bit = FMath::CountTrailingZeros(~Index);
+		if (++Index == 0)
+		{
+			SeekTo(0);
+		}
+		else
+		{
+			for (int32 D = 0; D < NumDimensions; ++D)
 			{
-				CurrentValue.Y += s;     // we know digit n has gone from a to a + 1
-				break;
+				State[D] ^= Directions[D][Bit];
 			}
-		};
+		}
+	}
 
-		// base 5: use 3 bits for each base 5 digit.
-		Mask = 0x7;
-		Add  = 0x3;  // amount to add to force carry once digit==dmax
-		uint32_t Dmax = 0x5;  // max digit
+	/**
+	 * Generate the next value, one element per dimension, each between 0..1 (exclusive of 1).
+	 * @param OutValues Must have at least GetNumDimensions() elements
+	 */
+	FORCEINLINE void Next(TArrayView<float> OutValues)
+	{
+		uint32 Ints[StevesRandConstants::kMaxLowDiscrepancyDimensions];
+		NextUInt(TArrayView<uint32>(Ints, NumDimensions));
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = StevesRandConstants::UIntToUnitFloat(Ints[D]);
+		}
+	}
 
-		s = StevesRandConstants::kOneOverFive;
+	/// Return a 2D value with each element between 0..1, from the first 2 dimensions. See StevesLowDiscrepancy::Rand2D
+	FVector2f Rand2D()
+	{
+		return StevesLowDiscrepancy::Rand2D(*this);
+	}
 
-		Base5Seed++;
+	/// Return a 3D value with each element between 0..1, from the first 3 dimensions. See StevesLowDiscrepancy::Rand3D
+	FVector Rand3D()
+	{
+		return StevesLowDiscrepancy::Rand3D(*this);
+	}
 
-		// expected iterations: 1.25
-		while (true)
+	/// Serialise the state compactly as the initial seed, position & number of dimensions
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("FStevesSobolRandomStream(InitialSeed=%u, Index=%u, Dimensions=%d)"), InitialSeed, Index, NumDimensions);
+	}	
+};
+
+template<>
+struct TStructOpsTypeTraits<FStevesSobolRandomStream> : public TStructOpsTypeTraitsBase2<FStevesSobolRandomStream>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
+
+/// R-d low discrepancy sequence (additive recurrence based on the generalised golden ratio, "R2" in 2 dimensions),
+/// in up to kMaxLowDiscrepancyDimensions dimensions. See Martin Roberts, "The Unreasonable Effectiveness of
+/// Quasirandom Sequences". This is the cheapest of the low discrepancy streams: one integer add per dimension.
+/// The seed picks a random offset (Cranley-Patterson rotation) rather than a starting point in the sequence.
+/// Values are 64-bit fixed point internally so don't lose precision, and the sequence never needs to wrap.
+USTRUCT(BlueprintType)
+struct STEVESUEHELPERS_API FStevesRdRandomStream
+{
+	GENERATED_BODY()
+
+protected:
+	uint32 InitialSeed = 0;
+	uint64 Index = 0;
+	int32 NumDimensions = 3;
+	/// Fractional values in 0.64 fixed point
+	uint64 State[StevesRandConstants::kMaxLowDiscrepancyDimensions] = {};
+	uint64 Offsets[StevesRandConstants::kMaxLowDiscrepancyDimensions] = {};
+	const uint64* Alphas = nullptr;
+
+	/// Get the per-dimension increments, in 0.64 fixed point, for a number of dimensions
+	static const uint64* GetAlphas(int32 NumDimensions);
+
+public:
+
+	FStevesRdRandomStream()
+	{
+		Initialize(0);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 * @param InNumDimensions The number of dimensions in each value
+	 */
+	FStevesRdRandomStream( uint32 InSeed, int32 InNumDimensions = 3 )
+	{
+		SetNumDimensions(InNumDimensions);
+		Initialize(InSeed);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	FStevesRdRandomStream( FName InName )
+	{
+		Initialize(InName);
+	}
+
+	/**
+	 * Initializes this random stream with the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 */
+	void Initialize( uint32 InSeed )
+	{
+		InitialSeed = InSeed;
+		Alphas = GetAlphas(NumDimensions);
+		for (int32 D = 0; D < StevesRandConstants::kMaxLowDiscrepancyDimensions; ++D)
 		{
-			if ((Base5Seed & Mask) == Dmax)
-			{
-				Base5Seed += Add;          // force carry into next 3-bit digit
-				CurrentValue.Z -= 4 * s;
+			Offsets[D] = MurmurFinalize64(((uint64)InSeed << 32) | (uint64)D);
+		}
+		SeekTo(0);
+	}
 
-				Mask = Mask << 3;
-				Dmax = Dmax << 3;
-				Add  = Add  << 3;
+	/**
+	 * Initializes this random stream using the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	void Initialize( FName InName )
+	{
+		uint32 StartSeed;
+		if (InName != NAME_None)
+		{
+			StartSeed = GetTypeHash(InName.ToString());
+		}
+		else
+		{
+			StartSeed = FPlatformTime::Cycles();
+		}
+		Initialize(StartSeed);
+	}
+
+	/**
+	 * Resets this random stream to the initial seed value.
+	 */
+	void Reset()
+	{
+		Initialize(InitialSeed);
+	}	
+
+	uint32 GetInitialSeed() const
+	{
+		return InitialSeed;
+	}
+
+	/**
+	 * Generates a new random seed.
+	 */
+	void GenerateNewSeed()
+	{
+		Initialize(FMath::Rand());
+	}
+
+	/// Change the number of dimensions in each value (1..kMaxLowDiscrepancyDimensions). Resets the stream, and
+	/// changes the sequence in every dimension, since the recurrence depends on the dimension count.
+	void SetNumDimensions(int32 InNumDimensions)
+	{
+		NumDimensions = FMath::Clamp(InNumDimensions, 1, StevesRandConstants::kMaxLowDiscrepancyDimensions);
+		Reset();
+	}
+
+	int32 GetNumDimensions() const
+	{
+		return NumDimensions;
+	}
+
+	/// Get the index of the next value in the sequence
+	uint64 GetPosition() const
+	{
+		return Index;
+	}
+
+	/**
+	 * Jump to a position in the sequence. Cost is O(1).
+	 * @param InIndex The index of the next value to generate
+	 */
+	void SeekTo(uint64 InIndex)
+	{
+		Index = InIndex;
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			// Wraps modulo 1 in fixed point
+			State[D] = Offsets[D] + InIndex * Alphas[D];
+		}
+	}
+
+	/**
+	 * Generate the next value as full range 32-bit integers, one per dimension. This is the fastest path.
+	 * @param OutValues Must have at least GetNumDimensions() elements
+	 */
+	FORCEINLINE void NextUInt(TArrayView<uint32> OutValues)
+	{
+		check(OutValues.Num() >= NumDimensions);
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = (uint32)(State[D] >> 32);
+			State[D] += Alphas[D];
+		}
+		++Index;
+	}
+
+	/**
+	 * Generate the next value, one element per dimension, each between 0..1 (exclusive of 1).
+	 * @param OutValues Must have at least GetNumDimensions() elements
+	 */
+	FORCEINLINE void Next(TArrayView<float> OutValues)
+	{
+		uint32 Ints[StevesRandConstants::kMaxLowDiscrepancyDimensions];
+		NextUInt(TArrayView<uint32>(Ints, NumDimensions));
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = StevesRandConstants::UIntToUnitFloat(Ints[D]);
+		}
+	}
+
+	/// Return a 2D value with each element between 0..1, from the first 2 dimensions. See StevesLowDiscrepancy::Rand2D
+	FVector2f Rand2D()
+	{
+		return StevesLowDiscrepancy::Rand2D(*this);
+	}
+
+	/// Return a 3D value with each element between 0..1, from the first 3 dimensions. See StevesLowDiscrepancy::Rand3D
+	FVector Rand3D()
+	{
+		return StevesLowDiscrepancy::Rand3D(*this);
+	}
+
+	/// Serialise the state compactly as the initial seed, position & number of dimensions
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("FStevesRdRandomStream(InitialSeed=%u, Index=%llu, Dimensions=%d)"), InitialSeed, Index, NumDimensions);
+	}	
+};
+
+template<>
+struct TStructOpsTypeTraits<FStevesRdRandomStream> : public TStructOpsTypeTraitsBase2<FStevesRdRandomStream>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
+};
+
+
+/// Scrambled Halton sequence in up to kMaxLowDiscrepancyDimensions dimensions, using the first N primes as bases.
+/// Each dimension's digits are put through a random permutation picked by the seed, which breaks up the correlation
+/// between higher dimensions that makes plain Halton unusable beyond a few dimensions. Like the other low discrepancy
+/// streams the seed picks the scrambling, not a starting point. Unlike FStevesBalancedRandomStream3D this is integer
+/// only (0.64 fixed point), so it doesn't lose precision and runs for 2^32 values before repeating.
+USTRUCT(BlueprintType)
+struct STEVESUEHELPERS_API FStevesScrambledHaltonRandomStream
+{
+	GENERATED_BODY()
+
+protected:
+	static constexpr int32 MaxDigits = 32;
+
+	uint32 InitialSeed = 0;
+	uint32 Index = 0;
+	int32 NumDimensions = 3;
+	/// Fractional values in 0.64 fixed point
+	uint64 State[StevesRandConstants::kMaxLowDiscrepancyDimensions] = {};
+	/// Digits of Index in each dimension's base, least significant first
+	uint8 Digits[StevesRandConstants::kMaxLowDiscrepancyDimensions][MaxDigits] = {};
+	/// Digit permutation for each dimension. 0 always maps to 0 so trailing zero digits contribute nothing.
+	uint8 Permutations[StevesRandConstants::kMaxLowDiscrepancyDimensions][StevesRandConstants::kMaxHaltonBase] = {};
+	/// Fixed point weight of each digit position for each dimension
+	const uint64 (*Weights)[MaxDigits] = nullptr;
+
+	static const uint64 (*GetDigitWeights())[MaxDigits];
+
+public:
+
+	FStevesScrambledHaltonRandomStream()
+	{
+		Initialize(0);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 * @param InNumDimensions The number of dimensions in each value
+	 */
+	FStevesScrambledHaltonRandomStream( uint32 InSeed, int32 InNumDimensions = 3 )
+	{
+		SetNumDimensions(InNumDimensions);
+		Initialize(InSeed);
+	}
+
+	/**
+	 * Creates and initializes a new random stream from the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	FStevesScrambledHaltonRandomStream( FName InName )
+	{
+		Initialize(InName);
+	}
 
-				s *= StevesRandConstants::kOneOverFive;
+	/**
+	 * Initializes this random stream with the specified seed value.
+	 *
+	 * @param InSeed The seed value.
+	 */
+	void Initialize( uint32 InSeed )
+	{
+		InitialSeed = InSeed;
+		Weights = GetDigitWeights();
+		FRandomStream Shuffler(InSeed);
+		for (int32 D = 0; D < StevesRandConstants::kMaxLowDiscrepancyDimensions; ++D)
+		{
+			const int32 Base = StevesRandConstants::kHaltonBases[D];
+			for (int32 i = 0; i < Base; ++i)
+			{
+				Permutations[D][i] = (uint8)i;
 			}
-			else
+			// Fisher-Yates over 1..Base-1, leaving 0 in place
+			for (int32 i = Base - 1; i > 1; --i)
 			{
-				CurrentValue.Z += s;     // we know digit n has gone from a to a + 1
-				break;
+				Swap(Permutations[D][i], Permutations[D][Shuffler.RandRange(1, i)]);
 			}
-		};
+		}
+		SeekTo(0);
+	}
 
-		return FVector(Ret.X, Ret.Y, Ret.Z);
+	/**
+	 * Initializes this random stream using the specified name.
+	 *
+	 * @note If NAME_None is provided, the stream will be seeded using the current time.
+	 * @param InName The name value from which the stream will be initialized.
+	 */
+	void Initialize( FName InName )
+	{
+		uint32 StartSeed;
+		if (InName != NAME_None)
+		{
+			StartSeed = GetTypeHash(InName.ToString());
+		}
+		else
+		{
+			StartSeed = FPlatformTime::Cycles();
+		}
+		Initialize(StartSeed);
 	}
-	
 
-	/// Random point in a 3D box
-	FORCEINLINE FVector RandPointInBox(const FBox& Box)
+	/**
+	 * Resets this random stream to the initial seed value.
+	 */
+	void Reset()
 	{
-		const FVector R3 = Rand3D();
-		return FVector(FMath::Lerp(Box.Min.X, Box.Max.X, R3.X),
-		               FMath::Lerp(Box.Min.Y, Box.Max.Y, R3.Y),
-		               FMath::Lerp(Box.Min.Z, Box.Max.Z, R3.Z));
+		Initialize(InitialSeed);
+	}	
+
+	uint32 GetInitialSeed() const
+	{
+		return InitialSeed;
 	}
 
-	
-	/// Random point in a sphere
-	FORCEINLINE FVector RandPointInSphere(float Radius = 1.0)
+	/**
+	 * Generates a new random seed.
+	 */
+	void GenerateNewSeed()
 	{
-		// Just use rejection sampling for simplicity / speed
-		while (true)
+		Initialize(FMath::Rand());
+	}
+
+	/// Change the number of dimensions in each value (1..kMaxLowDiscrepancyDimensions). Resets the stream.
+	void SetNumDimensions(int32 InNumDimensions)
+	{
+		NumDimensions = FMath::Clamp(InNumDimensions, 1, StevesRandConstants::kMaxLowDiscrepancyDimensions);
+		Reset();
+	}
+
+	int32 GetNumDimensions() const
+	{
+		return NumDimensions;
+	}
+
+	/// Get the index of the next value in the sequence
+	uint32 GetPosition() const
+	{
+		return Index;
+	}
+
+	/**
+	 * Jump to a position in the sequence. Cost is O(log Index) per dimension.
+	 * @param InIndex The index of the next value to generate
+	 */
+	void SeekTo(uint64 InIndex)
+	{
+		Index = (uint32)InIndex;
+		for (int32 D = 0; D < NumDimensions; ++D)
 		{
-			const FVector Candidate = Rand3D();
-			if (Candidate.SquaredLength() <= 1.0)
+			const uint32 Base = StevesRandConstants::kHaltonBases[D];
+			State[D] = 0;
+			uint32 K = Index;
+			for (int32 i = 0; i < MaxDigits; ++i)
 			{
-				return Candidate * Radius;
+				Digits[D][i] = (uint8)(K % Base);
+				State[D] += Permutations[D][Digits[D][i]] * Weights[D][i];
+				K /= Base;
 			}
 		}
 	}
-	
+
 	/**
-	 * Gets the current seed.
-	 *
-	 * @return Current seed.
+	 * Generate the next value as full range 32-bit integers, one per dimension. This is the fastest path.
+	 * @param OutValues Must have at least GetNumDimensions() elements
 	 */
-	uint32 GetCurrentSeed() const
+	FORCEINLINE void NextUInt(TArrayView<uint32> OutValues)
 	{
-		return InitialSeed;
+		check(OutValues.Num() >= NumDimensions);
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = (uint32)(State[D] >> 32);
+
+			// Increment the digits with carry, updating the value as we go
+			// Expected iterations: Base / (Base - 1)
+			const uint32 Base = StevesRandConstants::kHaltonBases[D];
+			const uint64* W = Weights[D];
+			const uint8* Perm = Permutations[D];
+			for (int32 i = 0; i < MaxDigits; ++i)
+			{
+				uint8& Digit = Digits[D][i];
+				State[D] -= Perm[Digit] * W[i];
+				if (++Digit < Base)
+				{
+					State[D] += Perm[Digit] * W[i];
+					break;
+				}
+				Digit = 0;
+			}
+		}
+
+		// Digits in bases other than 2 don't wrap at 2^32 by themselves
+		if (++Index == 0)
+		{
+			SeekTo(0);
+		}
 	}
-	
-	
+
+	/**
+	 * Generate the next value, one element per dimension, each between 0..1 (exclusive of 1).
+	 * @param OutValues Must have at least GetNumDimensions() elements
+	 */
+	FORCEINLINE void Next(TArrayView<float> OutValues)
+	{
+		uint32 Ints[StevesRandConstants::kMaxLowDiscrepancyDimensions];
+		NextUInt(TArrayView<uint32>(Ints, NumDimensions));
+		for (int32 D = 0; D < NumDimensions; ++D)
+		{
+			OutValues[D] = StevesRandConstants::UIntToUnitFloat(Ints[D]);
+		}
+	}
+
+	/// Return a 2D value with each element between 0..1, from the first 2 dimensions. See StevesLowDiscrepancy::Rand2D
+	FVector2f Rand2D()
+	{
+		return StevesLowDiscrepancy::Rand2D(*this);
+	}
+
+	/// Return a 3D value with each element between 0..1, from the first 3 dimensions. See StevesLowDiscrepancy::Rand3D
+	FVector Rand3D()
+	{
+		return StevesLowDiscrepancy::Rand3D(*this);
+	}
+
+	/// Serialise the state compactly as the initial seed, position & number of dimensions
+	void SerializeState(FArchive& Ar);
+	bool Serialize(FArchive& Ar);
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 	FString ToString() const
 	{
-		return FString::Printf(TEXT("FStevesBalancedRandomStream(InitialSeed=%u, Seed=%u)"), InitialSeed, Base2Seed);
+		return FString::Printf(TEXT("FStevesScrambledHaltonRandomStream(InitialSeed=%u, Index=%u, Dimensions=%d)"), InitialSeed, Index, NumDimensions);
 	}	
+};
 
-	
+template<>
+struct TStructOpsTypeTraits<FStevesScrambledHaltonRandomStream> : public TStructOpsTypeTraitsBase2<FStevesScrambledHaltonRandomStream>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithNetSerializer = true,
+	};
 };
@@ -0,0 +1,99 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMeshBuilder.h"
+#include "LocalVertexFactory.h"
+#include "StaticMeshResources.h"
+#include "UObject/ObjectKey.h"
+
+class UStaticMesh;
+
+/**
+ * GPU geometry for one LOD of a static mesh, for drawing as debug wireframe. Shared between every debug proxy which
+ * draws that mesh & LOD, via FStevesDebugMeshCache. Only ever hold this in a TRefCountPtr; it's released on the
+ * render thread when the last reference goes.
+ */
+class STEVESUEHELPERS_API FStevesDebugMeshGeometry
+{
+public:
+	FStaticMeshVertexBuffers VertexBuffers;
+	FDynamicMeshIndexBuffer32 IndexBuffer;
+	FLocalVertexFactory VertexFactory;
+	/// Bounds of the vertices, in mesh space
+	FBox LocalBounds;
+
+	uint32 GetNumVertices() const { return VertexBuffers.PositionVertexBuffer.GetNumVertices(); }
+	uint32 GetNumTriangles() const { return IndexBuffer.Indices.Num() / 3; }
+
+	uint32 AddRef() const;
+	uint32 Release() const;
+	uint32 GetRefCount() const;
+
+private:
+	friend class FStevesDebugMeshCache;
+
+	struct FKey
+	{
+		TObjectKey<UStaticMesh> Mesh;
+		/// Incremented when the mesh is rebuilt, so we don't keep drawing stale geometry
+		uint32 Generation;
+		int32 LODIndex;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Mesh == Other.Mesh && Generation == Other.Generation && LODIndex == Other.LODIndex;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombineFast(HashCombineFast(GetTypeHash(Key.Mesh), ::GetTypeHash(Key.Generation)),
+			                       ::GetTypeHash(Key.LODIndex));
+		}
+	};
+
+	FStevesDebugMeshGeometry(const FKey& InKey);
+
+	FKey Key;
+	/// Guarded by the cache lock, so that a lookup can't revive an entry which is being released
+	mutable uint32 RefCount = 0;
+};
+
+/**
+ * Global cache of debug mesh geometry, keyed by static mesh and LOD. Lots of debug proxies which draw the same mesh
+ * then share one set of GPU buffers, and just draw it with their own transform and colour, rather than every proxy
+ * holding its own copy of the vertices and uploading them again every frame.
+ * Entries are ref counted, and removed when the last proxy using them goes away.
+ */
+class STEVESUEHELPERS_API FStevesDebugMeshCache
+{
+public:
+	static FStevesDebugMeshCache& Get();
+
+	/**
+	 * Get the shared geometry for a mesh LOD, creating it if it's not already cached. Call on the game thread.
+	 * @param Mesh The static mesh. Its CPU data must be accessible (always in editor, otherwise needs "Allow CPU Access")
+	 * @param LODIndex The LOD to use, clamped to the LODs the mesh has
+	 * @return The geometry, or null if the mesh has no geometry to use
+	 */
+	TRefCountPtr<FStevesDebugMeshGeometry> FindOrAdd(const UStaticMesh* Mesh, int32 LODIndex);
+
+	/// The number of mesh LODs currently cached
+	int32 Num() const;
+
+private:
+	friend class FStevesDebugMeshGeometry;
+
+	mutable FCriticalSection Lock;
+	TMap<FStevesDebugMeshGeometry::FKey, FStevesDebugMeshGeometry*> Entries;
+
+	/// How many times each mesh we've seen has been rebuilt. Only meshes in the editor are rebuilt in place
+	/// (e.g. reimport); game thread only
+	TMap<TObjectKey<UStaticMesh>, uint32> MeshGenerations;
+
+	uint32 GetMeshGeneration(const UStaticMesh* Mesh);
+#if WITH_EDITOR
+	void OnMeshBuilt(UStaticMesh* Mesh);
+#endif
+};
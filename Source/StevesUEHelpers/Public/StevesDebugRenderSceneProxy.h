@@ -5,6 +5,40 @@
 
 #include "CoreMinimal.h"
 #include "DebugRenderSceneProxy.h"
+#include "StevesDebugMeshCache.h"
+
+/// Categories of shape in FStevesDebugRenderSceneProxy, used to update only some of them
+enum class EStevesDebugShapes : uint16
+{
+	None = 0,
+	Lines = 1 << 0,
+	Arrows = 1 << 1,
+	Circles = 1 << 2,
+	Arcs = 1 << 3,
+	Spheres = 1 << 4,
+	Boxes = 1 << 5,
+	Cylinders = 1 << 6,
+	Capsules = 1 << 7,
+	Meshes = 1 << 8,
+	All = (1 << 9) - 1
+};
+ENUM_CLASS_FLAGS(EStevesDebugShapes)
+
+/// GPU copy of the pre-tessellated lines for one depth priority group of a FStevesDebugRenderSceneProxy, 2 vertices
+/// per line, so each frame only needs to choose which of them to draw
+class FStevesDebugLineGeometry
+{
+public:
+	FStaticMeshVertexBuffers VertexBuffers;
+	FLocalVertexFactory VertexFactory;
+
+	FStevesDebugLineGeometry()
+		: VertexFactory(GMaxRHIFeatureLevel, "FStevesDebugLineGeometry")
+	{
+	}
+
+	uint32 GetNumVertices() const { return VertexBuffers.PositionVertexBuffer.GetNumVertices(); }
+};
 
 /**
  * An extension to FDebugRenderSceneProxy to support other shapes, e.g. circles and arcs
@@ -17,11 +51,43 @@ public:
 	{
 	}
 
+	STEVESUEHELPERS_API virtual ~FStevesDebugRenderSceneProxy() override;
+
+	/// If true, Lines, ArrowLines, Spheres, Boxes and all of our own shapes are in component local space, and are
+	/// transformed by GetLocalToWorld() when drawn. This means the proxy doesn't need to be re-created when the
+	/// component moves. Other FDebugRenderSceneProxy shapes are not drawn in this mode.
+	bool bShapesInLocalSpace = false;
+
+	/// The number of levels of detail circles, arcs, spheres, cylinders and capsules are drawn at. Each LOD halves
+	/// the number of segments
+	static constexpr int32 NumShapeLODs = 3;
+	/// Individual shapes further than this from the view are not drawn. 0 means no limit
+	float MaxShapeDrawDistance = 0;
+	/// Whether to reduce the number of segments in shapes which are small on screen
+	bool bReduceShapeDetail = true;
+	/// The screen size (as in ComputeBoundsScreenSize) below which each LOD after the first is used
+	float ShapeLODScreenSizes[NumShapeLODs - 1] = { 0.1f, 0.03f };
+
 	STEVESUEHELPERS_API virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily,
 	                                    uint32 VisibilityMap, FMeshElementCollector& Collector) const override;
 
 	STEVESUEHELPERS_API virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override;
 
+	/**
+	 * Pick the level of detail to draw a shape at in a view, or cull it
+	 * @param View The view being drawn
+	 * @param Centre Centre of the shape's bounding sphere, in world space
+	 * @param Radius Radius of the shape's bounding sphere, in world space
+	 * @return The LOD, from 0 to NumShapeLODs - 1, or INDEX_NONE if the shape shouldn't be drawn
+	 */
+	STEVESUEHELPERS_API int32 GetShapeLOD(const FSceneView* View, const FVector& Centre, float Radius) const;
+
+	/// Reduce a number of segments for a shape LOD
+	static int32 GetLODSegments(int32 NumSegments, int32 LOD)
+	{
+		return FMath::Max(FMath::Min(NumSegments, 4), NumSegments >> LOD);
+	}
+
 	struct FDebugCircle
 	{
 		FDebugCircle(const FVector& InCentre, const FVector& InX, const FVector& InY, float InRadius, int InNumSegments,
@@ -113,10 +179,115 @@ public:
 		FColor Color;
 	};
 
+	/// A mesh whose geometry is shared with other proxies through FStevesDebugMeshCache, so we only need to supply
+	/// our own transform and colour. Much cheaper than FDebugMesh, which uploads its vertices again every frame.
+	struct FDebugMeshInstance
+	{
+		FDebugMeshInstance(const FMatrix& InLocalToWorld,
+			const TRefCountPtr<FStevesDebugMeshGeometry>& InGeometry,
+			const FColor& InColor)
+			: LocalToWorld(InLocalToWorld),
+			  Geometry(InGeometry),
+			  Color(InColor)
+		{
+		}
+
+		FMatrix LocalToWorld;
+		TRefCountPtr<FStevesDebugMeshGeometry> Geometry;
+		FColor Color;
+	};
+
 	TArray<FDebugCircle> Circles;
 	TArray<FDebugArc> Arcs;
 	TArray<FDebugCylinder> CylindersImproved; // Because we need our own
 	TArray<FCapsule> CapsulesImproved; // Because we need our own
 	TArray<FDebugMesh> MeshesImproved; // Because we need our own
+	TArray<FDebugMeshInstance> MeshInstances;
+
+	/// A replacement set of shapes for some categories, built on the game thread and applied on the render thread
+	struct FShapeUpdate
+	{
+		/// Which of the arrays below are included in this update
+		EStevesDebugShapes Shapes = EStevesDebugShapes::None;
+		/// If true, the shapes are added to the existing ones in each category, rather than replacing them
+		bool bAppend = false;
+		TArray<FDebugLine> Lines;
+		TArray<FArrowLine> ArrowLines;
+		TArray<FDebugCircle> Circles;
+		TArray<FDebugArc> Arcs;
+		TArray<FSphere> Spheres;
+		TArray<FDebugBox> Boxes;
+		TArray<FDebugCylinder> Cylinders;
+		TArray<FCapsule> Capsules;
+		TArray<FDebugMesh> Meshes;
+		TArray<FDebugMeshInstance> MeshInstances;
+	};
+
+	/// Replace (or append to) the shapes in the categories included in an update, leaving the others alone. Call on
+	/// the render thread once the proxy has been added to the scene, or on the game thread before then.
+	/// Also pre-tessellates the updated circles, arcs, cylinders and capsules, see TessellateShapes.
+	STEVESUEHELPERS_API void ApplyShapeUpdate(FShapeUpdate&& Update);
+
+	/**
+	 * Pre-tessellate circles, arcs, cylinders and capsules into line segments at each LOD, and upload the lines to the
+	 * GPU, so that drawing them each frame is one line list per depth priority group rather than recalculating every
+	 * shape. Thick lines still go through the PDI, which expands them to quads. Called for you by ApplyShapeUpdate;
+	 * if you change those arrays directly instead, call this again afterwards.
+	 * Tessellated lines are only used when the proxy has a uniform scale, since non-uniform scale is applied to these
+	 * shapes differently, so falls back on drawing each shape.
+	 * @param Shapes The categories to re-tessellate
+	 */
+	STEVESUEHELPERS_API void TessellateShapes(EStevesDebugShapes Shapes = EStevesDebugShapes::All);
+
+	/// A line segment from a pre-tessellated shape, in the same space as the shape
+	struct FTessellatedLine
+	{
+		FVector Start;
+		FVector End;
+		FColor Color;
+		float Thickness;
+	};
+
+	/// One pre-tessellated shape; its lines for each LOD are a range of the lines in FTessellatedShapes
+	struct FTessellatedShape
+	{
+		/// Bounding sphere, in the same space as the lines
+		FVector Centre;
+		float Radius;
+		int32 FirstLine[NumShapeLODs];
+		int32 NumLines[NumShapeLODs];
+	};
+
+	struct FTessellatedShapes
+	{
+		TArray<FTessellatedShape> Shapes;
+		TArray<FTessellatedLine> Lines;
+		/// Vertex of the first line in the line geometry for this category's depth priority group
+		int32 FirstVertex = 0;
+
+		void Reset()
+		{
+			Shapes.Reset();
+			Lines.Reset();
+		}
+	};
+
+protected:
+	/// Tessellate shapes from the given index in each category onwards, keeping those before it
+	void TessellateShapes(EStevesDebugShapes Shapes, int32 FirstCircle, int32 FirstArc, int32 FirstCylinder, int32 FirstCapsule);
+
+	bool bShapesTessellated = false;
+	FTessellatedShapes TessellatedCircles;
+	FTessellatedShapes TessellatedArcs;
+	FTessellatedShapes TessellatedCylinders;
+	FTessellatedShapes TessellatedCapsules;
+	/// Circles are drawn in the world depth priority group, arcs, cylinders and capsules in the foreground
+	FStevesDebugLineGeometry* WorldLineGeometry = nullptr;
+	FStevesDebugLineGeometry* ForegroundLineGeometry = nullptr;
+
+	/// Replace line geometry with the lines of some tessellated categories, one after the other
+	static void BuildLineGeometry(FStevesDebugLineGeometry*& Geometry, std::initializer_list<FTessellatedShapes*> Categories);
+	/// Release line geometry on the render thread, and clear the pointer
+	static void ReleaseLineGeometry(FStevesDebugLineGeometry*& Geometry);
 
 };
@@ -7,6 +7,8 @@
 #include "Components/PrimitiveComponent.h"
 #include "StevesEditorVisComponent.generated.h"
 
+enum class EStevesDebugShapes : uint16;
+
 
 USTRUCT(BlueprintType)
 struct STEVESUEHELPERS_API FStevesEditorVisLine
@@ -339,10 +341,58 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="StevesVisComponent")
 	TArray<FStevesEditorVisMesh> Meshes;
 
+	/// Individual shapes further than this from the camera are not drawn. 0 means no limit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="StevesVisComponent", meta=(ClampMin=0, Units="cm"))
+	float MaxShapeDrawDistance = 0;
+	/// Whether to draw circles, arcs, spheres, cylinders and capsules with fewer segments when they're small on screen
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="StevesVisComponent")
+	bool bReduceShapeDetail = true;
+
 	UStevesEditorVisComponent(const FObjectInitializer& ObjectInitializer);
 
 	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
 	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
-	/// Needs to update on transform since proxy is detached
-	virtual bool ShouldRecreateProxyOnUpdateTransform() const override { return true; }
+	/// Shapes are kept in local space by the proxy, so moving doesn't need a new one
+	virtual bool ShouldRecreateProxyOnUpdateTransform() const override { return false; }
+
+	/**
+	 * Call after changing the shape arrays from code, to send only the changed categories of shape to the existing
+	 * render proxy, rather than re-creating it.
+	 * @param Shapes The categories of shape which have changed
+	 */
+	void UpdateShapes(EStevesDebugShapes Shapes);
+
+	/// Call after changing the shape arrays, to update the rendered shapes without re-creating the render proxy
+	UFUNCTION(BlueprintCallable, Category="StevesVisComponent")
+	void MarkShapesChanged();
+
+	// Add a single shape. Cheaper than changing the arrays directly and calling UpdateShapes, since the cached bounds
+	// are extended rather than recalculated, and only the new shape is sent to the render proxy
+	void AddLine(const FStevesEditorVisLine& Line);
+	void AddArrow(const FStevesEditorVisLine& Arrow);
+	void AddCircle(const FStevesEditorVisCircle& Circle);
+	void AddArc(const FStevesEditorVisArc& Arc);
+	void AddSphere(const FStevesEditorVisSphere& Sphere);
+	void AddBox(const FStevesEditorVisBox& Box);
+	void AddCylinder(const FStevesEditorVisCylinder& Cylinder);
+	void AddCapsule(const FStevesEditorVisCapsule& Capsule);
+	void AddMesh(const FStevesEditorVisMesh& Mesh);
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+	/// Bounds of all shapes in local space, so moving the component doesn't need to recalculate them
+	mutable FBoxSphereBounds CachedLocalBounds;
+	mutable bool bLocalBoundsValid = false;
+
+	virtual void CreateRenderState_Concurrent(FRegisterComponentContext* Context) override;
+
+	FBoxSphereBounds CalcLocalBounds() const;
+	/// Extend cached bounds with a newly added shape, and send just that shape to the proxy
+	void ShapeAdded(const FBoxSphereBounds& ShapeBounds, EStevesDebugShapes Shapes, int32 Index);
+	/// Send shapes to the proxy, & bounds too since they might have changed. If FirstNewIndex > 0, only shapes from
+	/// that index on are sent, and added to those the proxy already has
+	void SendShapes(EStevesDebugShapes Shapes, int32 FirstNewIndex = 0);
 };
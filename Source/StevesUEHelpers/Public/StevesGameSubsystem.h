@@ -8,6 +8,7 @@
 #include "PaperSprite.h"
 #include "Framework/Application/IInputProcessor.h"
 #include "StevesHelperCommon.h"
+#include "StevesRandomStreamRegistry.h"
 #include "StevesTextureRenderTargetPool.h"
 #include "StevesUI/FocusSystem.h"
 #include "StevesUI/InputImage.h"
@@ -154,6 +155,7 @@ protected:
     bool bCheckedViewportClient = false;
 
     FTimerHandle ForegroundCheckHandle;
+    FTimerHandle RenderTargetPoolEvictHandle;
 
     UPROPERTY(BlueprintReadOnly, Category="StevesGameSubsystem")
     bool bIsForeground = true;
@@ -163,11 +165,14 @@ protected:
 
     TArray<FStevesTextureRenderTargetPoolPtr> TextureRenderTargetPools;
 
+    FStevesRandomStreamRegistry RandomStreamRegistry;
+
     void CreateInputDetector();
     void DestroyInputDetector();
     void InitTheme();
     void InitForegroundCheck();
     void CheckForeground();
+    void EvictIdleRenderTargets();
 	void InitViewport();
 	void ViewportResized(FViewport* Viewport, unsigned Unused);
 	void FullscreenToggled(bool bFullscreen);
@@ -336,6 +341,30 @@ public:
     */
     FStevesTextureRenderTargetPoolPtr GetTextureRenderTargetPool(FName Name, bool bAutoCreate = true);
 
+    /// Get all the texture render target pools which have been created
+    const TArray<FStevesTextureRenderTargetPoolPtr>& GetTextureRenderTargetPools() const { return TextureRenderTargetPools; }
+
+    /// Get the registry which hands out random streams to worker threads / tasks, derived from a master seed.
+    /// Streams obtained from it can be used on any thread without locking.
+    FStevesRandomStreamRegistry& GetRandomStreamRegistry() { return RandomStreamRegistry; }
+
+    /**
+     * Set the master seed which all task / thread random streams are derived from. Call this before dispatching any
+     * work which uses the streams, e.g. when starting to generate a level.
+     * @param Seed The master seed
+     */
+    UFUNCTION(BlueprintCallable, Category="StevesGameSubsystem")
+    void SetRandomMasterSeed(int32 Seed) { RandomStreamRegistry.Initialize(Seed); }
+
+    /**
+     * Get the random stream for a task, derived from the master seed. The same master seed & task index always
+     * produce the same stream, so results don't depend on the order tasks are processed.
+     * @param TaskIndex Your index for the piece of work
+     * @return A new stream for this task
+     */
+    UFUNCTION(BlueprintCallable, Category="StevesGameSubsystem")
+    FStevesBalancedRandomStream GetTaskRandomStream(int32 TaskIndex) const { return RandomStreamRegistry.GetTaskStream(TaskIndex); }
+
     /**
      * DEPRECATED - no longer required
      * Notify this subsystem that changes have been made to the Enhanced Input mappings, e.g. adding or removing a context.
@@ -9,6 +9,115 @@
 
 struct FKConvexElem;
 
+/// A cone with its trigonometry pre-calculated, for testing many shapes against the same cone
+struct FStevesPreparedCone
+{
+	/// Origin of the cone
+	FVector Origin;
+	/// Direction of the cone, normalised
+	FVector Dir;
+	/// Length of the cone
+	float Distance;
+	float SinHalfAngle;
+	float InvSinHalfAngle;
+	float CosHalfAngleSq;
+	float TanHalfAngle;
+
+	/**
+	 * @param InOrigin Origin of the cone
+	 * @param InDir Direction of the cone, must be normalised
+	 * @param HalfAngle Half-angle of the cone, in radians
+	 * @param InDistance Length of the cone
+	 */
+	FStevesPreparedCone(const FVector& InOrigin, const FVector& InDir, float HalfAngle, float InDistance)
+		: Origin(InOrigin),
+		  Dir(InDir),
+		  Distance(InDistance)
+	{
+		SinHalfAngle = FMath::Sin(HalfAngle);
+		InvSinHalfAngle = 1.f / SinHalfAngle;
+		const float CosHalfAngle = FMath::Cos(HalfAngle);
+		CosHalfAngleSq = CosHalfAngle * CosHalfAngle;
+		TanHalfAngle = FMath::Tan(HalfAngle);
+	}
+};
+
+/// A 2D distance field baked from a shape, for O(1) approximate distance lookups. See FStevesPreparedConvex2D::BakeDistanceField
+struct STEVESUEHELPERS_API FStevesDistanceField2D
+{
+	/// Position of the first sample
+	FVector2f Origin = FVector2f::ZeroVector;
+	/// Distance between samples
+	float CellSize = 1;
+	/// Number of samples in X
+	int32 SizeX = 0;
+	/// Number of samples in Y
+	int32 SizeY = 0;
+	/// Row-major distance samples, <= 0 inside the shape
+	TArray<float> Values;
+
+	/**
+	 * Look up the distance at a point, bilinearly interpolated between samples. Points outside the grid are clamped
+	 * to its edge, and the distance from the edge added.
+	 * @param Point The point, in the same space as the shape the field was baked from
+	 * @return The approximate distance to the shape. <= 0 if inside
+	 */
+	float Sample(const FVector2f& Point) const;
+};
+
+/**
+ * A convex polygon in 2D with its edge data pre-calculated, for evaluating the distance of many points from the same
+ * polygon. Gives the same results as StevesMathHelpers::GetDistanceToConvex2D, to within float precision.
+ */
+class STEVESUEHELPERS_API FStevesPreparedConvex2D
+{
+protected:
+	// Edge data, structure of arrays so that edges can be tested against 4 points at a time
+	TArray<float> StartX;
+	TArray<float> StartY;
+	TArray<float> LineX;
+	TArray<float> LineY;
+	TArray<float> InvLengthSq;
+	FBox2f Bounds;
+
+public:
+	FStevesPreparedConvex2D() : Bounds(ForceInit) {}
+
+	/// @param ConvexPoints Points on the convex polygon, anti-clockwise order, in a chosen space
+	explicit FStevesPreparedConvex2D(TConstArrayView<FVector2f> ConvexPoints);
+
+	/// Reinitialise with new points, anti-clockwise order
+	void Initialize(TConstArrayView<FVector2f> ConvexPoints);
+
+	/// Get the bounding box of the polygon
+	const FBox2f& GetBounds() const { return Bounds; }
+
+	/**
+	 * Return the distance to the polygon for a single point
+	 * @param LocalPoint Point to test, in same space as convex points
+	 * @return The distance to this convex polygon in 2D space. <= 0 if inside
+	 */
+	float GetDistance(const FVector2f& LocalPoint) const;
+
+	/**
+	 * Return the distances to the polygon for many points at once, 4 at a time using SIMD.
+	 * @param LocalPoints Points to test, in the same space as the convex points
+	 * @param OutDistances Distance of each point, same length as LocalPoints. <= 0 if inside
+	 * @param MaxDistance If you only care about points closer than this, groups of points which are all further
+	 *		than this from the bounding box aren't tested against the edges. Their result is the distance to the
+	 *		bounding box instead, which is less than the true distance but still greater than MaxDistance.
+	 */
+	void GetDistances(TConstArrayView<FVector2f> LocalPoints, TArrayView<float> OutDistances, float MaxDistance = UE_BIG_NUMBER) const;
+
+	/**
+	 * Bake the distance to this polygon into a grid, so that distances can be looked up in O(1).
+	 * @param CellSize Distance between samples; lookups are exact at sample points, and interpolated in between
+	 * @param Padding How far outside the bounds of the polygon to extend the grid
+	 * @param OutField The field to write to
+	 */
+	void BakeDistanceField(float CellSize, float Padding, FStevesDistanceField2D& OutField) const;
+};
+
 /// Helper maths routines that UE4 is missing, all static
 class STEVESUEHELPERS_API StevesMathHelpers
 {
@@ -25,55 +134,60 @@ public:
 	* @return True if the sphere overlaps the cone
 	*/
 	static bool SphereOverlapCone(const FVector& ConeOrigin, const FVector& ConeDir, float ConeHalfAngle, float Distance, const FVector& SphereCentre, float SphereRadius)
+	{
+		return SphereOverlapCone(FStevesPreparedCone(ConeOrigin, ConeDir, ConeHalfAngle, Distance), SphereCentre, SphereRadius);
+	}
+
+	/**
+	* @brief Return whether a sphere overlaps a cone, using a cone with pre-calculated trigonometry. Use this when
+	*	testing many spheres against the same cone.
+	* @param Cone The cone
+	* @param SphereCentre Centre of the sphere
+	* @param SphereRadius Radius of the sphere
+	* @return True if the sphere overlaps the cone
+	*/
+	static bool SphereOverlapCone(const FStevesPreparedCone& Cone, const FVector& SphereCentre, float SphereRadius)
 	{
 		// Algorithm from https://www.geometrictools.com/GTE/Mathematics/IntrSphere3Cone3.h
 		
-		const float SinHalfAngle = FMath::Sin(ConeHalfAngle);
-		const float InvSinHalfAngle =  1.f/SinHalfAngle;
-
-		const FVector U = ConeOrigin - (SphereRadius * InvSinHalfAngle) * ConeDir;
+		const FVector U = Cone.Origin - (SphereRadius * Cone.InvSinHalfAngle) * Cone.Dir;
 		const FVector CmU = SphereCentre - U;
-		const float AdCmU = FVector::DotProduct(ConeDir, CmU);
+		const float AdCmU = FVector::DotProduct(Cone.Dir, CmU);
 		if (AdCmU > 0)
 		{
-			const float CosHalfAngle = FMath::Cos(ConeHalfAngle);
-			const float CosHalfAngleSq = CosHalfAngle * CosHalfAngle;
-
 			const float sqrLengthCmU = FVector::DotProduct(CmU, CmU);
-			if (AdCmU * AdCmU >= sqrLengthCmU * CosHalfAngleSq)
+			if (AdCmU * AdCmU >= sqrLengthCmU * Cone.CosHalfAngleSq)
 			{
-				const FVector CmV = SphereCentre - ConeOrigin;
-				const float AdCmV = FVector::DotProduct(ConeDir, CmV);
+				const FVector CmV = SphereCentre - Cone.Origin;
+				const float AdCmV = FVector::DotProduct(Cone.Dir, CmV);
 				if (AdCmV < -SphereRadius)
 				{
 					return false;
 				}
 
-				if (AdCmV > Distance + SphereRadius)
+				if (AdCmV > Cone.Distance + SphereRadius)
 				{
 					return false;
 				}
 
-				const float rSinAngle = SphereRadius * SinHalfAngle;
+				const float rSinAngle = SphereRadius * Cone.SinHalfAngle;
 				if (AdCmV >= -rSinAngle)
 				{
-					if (AdCmV <= Distance - rSinAngle)
+					if (AdCmV <= Cone.Distance - rSinAngle)
 					{
 						return true;
 					}
 					else
 					{
-						const float TanHalfAngle = FMath::Tan(ConeHalfAngle);
-
-						const FVector barD = CmV - Distance * ConeDir;
-						const float lengthAxBarD = FVector::CrossProduct(ConeDir, barD).Size();
-						const float hmaxTanAngle = Distance * TanHalfAngle;
+						const FVector barD = CmV - Cone.Distance * Cone.Dir;
+						const float lengthAxBarD = FVector::CrossProduct(Cone.Dir, barD).Size();
+						const float hmaxTanAngle = Cone.Distance * Cone.TanHalfAngle;
 						if (lengthAxBarD <= hmaxTanAngle)
 						{
 							return true;
 						}
 
-						const float AdBarD = AdCmV - Distance;
+						const float AdBarD = AdCmV - Cone.Distance;
 						const float diff = lengthAxBarD - hmaxTanAngle;
 						const float sqrLengthCmBarK = AdBarD * AdBarD + diff * diff;
 						return sqrLengthCmBarK <= SphereRadius * SphereRadius;
@@ -89,6 +203,44 @@ public:
 		return false;
 	}
 
+	/**
+	 * Test many spheres against one cone at once, writing a bitmask of which ones overlap. Spheres are supplied as
+	 * separate arrays of each component (structure of arrays) so they can be tested 4 at a time with SIMD, and
+	 * large batches are split across worker threads.
+	 * Results match SphereOverlapCone except possibly for spheres within float precision of the cone surface.
+	 * @param Cone The cone
+	 * @param CentresX X components of the sphere centres
+	 * @param CentresY Y components of the sphere centres, same length as CentresX
+	 * @param CentresZ Z components of the sphere centres, same length as CentresX
+	 * @param Radii Radii of the spheres, same length as CentresX
+	 * @param OutMask Bitmask of results, bit (i % 32) of element (i / 32) is set if sphere i overlaps. Resized to fit.
+	 * @return The number of spheres which overlap the cone
+	 */
+	static int32 SphereOverlapConeBatch(const FStevesPreparedCone& Cone,
+	                                    TConstArrayView<float> CentresX,
+	                                    TConstArrayView<float> CentresY,
+	                                    TConstArrayView<float> CentresZ,
+	                                    TConstArrayView<float> Radii,
+	                                    TArray<uint32>& OutMask);
+
+	/**
+	 * Test many spheres against one cone at once, adding the indexes of those which overlap to a list. See the
+	 * bitmask version for details.
+	 * @param Cone The cone
+	 * @param CentresX X components of the sphere centres
+	 * @param CentresY Y components of the sphere centres, same length as CentresX
+	 * @param CentresZ Z components of the sphere centres, same length as CentresX
+	 * @param Radii Radii of the spheres, same length as CentresX
+	 * @param OutIndices Indexes of the overlapping spheres are appended to this, in ascending order
+	 * @return The number of spheres which overlap the cone
+	 */
+	static int32 SphereOverlapConeBatch(const FStevesPreparedCone& Cone,
+	                                    TConstArrayView<float> CentresX,
+	                                    TConstArrayView<float> CentresY,
+	                                    TConstArrayView<float> CentresZ,
+	                                    TConstArrayView<float> Radii,
+	                                    TArray<int32>& OutIndices);
+
 	/**
 	 * Explicitly test the overlap of any collision shape with a convex element.
 	 * @param Convex The convex element
@@ -189,5 +341,33 @@ public:
 	                                      std::function<bool(int, int)> CellIncludeFunc,
 	                                      TArray<FIntRect>& OutRects);
 
+	/**
+	 * Version of Fill2DRegionWithRectangles which takes a packed bitmap of valid cells instead of a callback, and
+	 * scans it a word at a time. This is much faster for large grids, and produces the same rectangles as the callback
+	 * version for the same cells (unless bParallel is true).
+	 * @param StartX The X index of the first cell, added to the results so they're in your own index space
+	 * @param StartY The Y index of the first cell, added to the results so they're in your own index space
+	 * @param Width The width of the area to fill
+	 * @param Height The height of the area to fill
+	 * @param CellBits Row-major bitmap of cells which are valid to be included in a rectangle. Cell X,Y is bit (X % 64)
+	 *		of element (Y * WordsPerRow + X / 64), where X and Y are relative to StartX / StartY.
+	 * @param WordsPerRow The number of elements in CellBits per row, at least ceil(Width / 64). Bits beyond Width are ignored.
+	 * @param OutRects Array of rectangles which this function should append results to. Will not be cleared before adding.
+	 * @param bParallel If true, split the area into tiles which are filled on worker threads, then merge rectangles
+	 *		which meet exactly across tile seams. The results are still non-overlapping and cover the valid area, but
+	 *		will be different to the single-threaded results.
+	 * @param TileSize The size of each tile in cells, when bParallel is true
+	 * @return The number of rectangles added by this call. Each rectangle is a min/max inclusive X/Y value.
+	 */
+	static int Fill2DRegionWithRectangles(int StartX,
+	                                      int StartY,
+	                                      int Width,
+	                                      int Height,
+	                                      TConstArrayView<uint64> CellBits,
+	                                      int WordsPerRow,
+	                                      TArray<FIntRect>& OutRects,
+	                                      bool bParallel = false,
+	                                      int TileSize = 256);
+
 	
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#pragma once
+#include <functional>
+#include "CoreMinimal.h"
+#include "StevesBalancedRandomStream.h"
+
+/**
+ * Poisson disk ("blue noise") point sampling using Bridson's algorithm, "Fast Poisson Disk Sampling in Arbitrary
+ * Dimensions", accelerated with a background grid. Unlike the balanced random streams, points are guaranteed to be no
+ * closer together than a minimum distance, while still filling the area without large gaps, which makes them suitable
+ * for spawners. All static.
+ *
+ * The distance between points can vary across the area by supplying a function which returns the minimum distance at
+ * a given location. Two points must be at least the larger of their two distances apart. The search is bounded by
+ * MaxDistance, so the function's results are clamped to [MinDistance, MaxDistance].
+ */
+class STEVESUEHELPERS_API StevesPoissonDiskSampling
+{
+public:
+	/**
+	 * Generate points in a 2D rectangle which are at least a fixed distance apart.
+	 * @param Rect The area to fill
+	 * @param Distance The minimum distance between points
+	 * @param Stream Random stream used to place candidate points
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it. Higher values fill
+	 *		the area more tightly but are slower.
+	 * @return The number of points added
+	 */
+	static int SampleRect(const FBox2D& Rect,
+	                      float Distance,
+	                      FStevesBalancedRandomStream& Stream,
+	                      TArray<FVector2D>& OutPoints,
+	                      int MaxAttempts = 30);
+
+	/**
+	 * Generate points in a 2D rectangle where the minimum distance between them varies by location.
+	 * @param Rect The area to fill
+	 * @param MinDistance The smallest distance DistanceFunc will return
+	 * @param MaxDistance The largest distance DistanceFunc will return
+	 * @param DistanceFunc Function returning the minimum distance between points at a given location
+	 * @param Stream Random stream used to place candidate points
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @return The number of points added
+	 */
+	static int SampleRect(const FBox2D& Rect,
+	                      float MinDistance,
+	                      float MaxDistance,
+	                      std::function<float(const FVector2D&)> DistanceFunc,
+	                      FStevesBalancedRandomStream& Stream,
+	                      TArray<FVector2D>& OutPoints,
+	                      int MaxAttempts = 30);
+
+	/**
+	 * Generate points in a 2D rectangle on multiple threads. The area is split into tiles which are sampled in
+	 * 4 passes, where no two tiles in the same pass are adjacent, so the result is deterministic for a given seed
+	 * regardless of the number of threads (but is different to SampleRect).
+	 * @param Rect The area to fill
+	 * @param MinDistance The minimum distance between points
+	 * @param MaxDistance The largest distance DistanceFunc will return. Ignored if DistanceFunc is null.
+	 * @param DistanceFunc Optional function returning the minimum distance between points at a given location. Will
+	 *		be called from multiple threads at once. If null, MinDistance is used everywhere.
+	 * @param Seed Seed for the random streams, one of which is created for each tile
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @param TileSize The size of each tile. Will be increased if needed so that tiles are larger than the largest
+	 *		distance. If 0, a size is picked to give roughly 1000 points per tile.
+	 * @return The number of points added
+	 */
+	static int SampleRectParallel(const FBox2D& Rect,
+	                              float MinDistance,
+	                              float MaxDistance,
+	                              std::function<float(const FVector2D&)> DistanceFunc,
+	                              uint32 Seed,
+	                              TArray<FVector2D>& OutPoints,
+	                              int MaxAttempts = 30,
+	                              float TileSize = 0);
+
+	/**
+	 * Generate points in a 3D box which are at least a fixed distance apart.
+	 * @param Box The volume to fill
+	 * @param Distance The minimum distance between points
+	 * @param Stream Random stream used to place candidate points
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it. Higher values fill
+	 *		the volume more tightly but are slower.
+	 * @return The number of points added
+	 */
+	static int SampleBox(const FBox& Box,
+	                     float Distance,
+	                     FStevesBalancedRandomStream& Stream,
+	                     TArray<FVector>& OutPoints,
+	                     int MaxAttempts = 30);
+
+	/**
+	 * Generate points in a 3D box where the minimum distance between them varies by location.
+	 * @param Box The volume to fill
+	 * @param MinDistance The smallest distance DistanceFunc will return
+	 * @param MaxDistance The largest distance DistanceFunc will return
+	 * @param DistanceFunc Function returning the minimum distance between points at a given location
+	 * @param Stream Random stream used to place candidate points
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @return The number of points added
+	 */
+	static int SampleBox(const FBox& Box,
+	                     float MinDistance,
+	                     float MaxDistance,
+	                     std::function<float(const FVector&)> DistanceFunc,
+	                     FStevesBalancedRandomStream& Stream,
+	                     TArray<FVector>& OutPoints,
+	                     int MaxAttempts = 30);
+
+	/**
+	 * Generate points in a 3D box on multiple threads. See SampleRectParallel; tiles are sampled in 8 passes.
+	 * @param Box The volume to fill
+	 * @param MinDistance The minimum distance between points
+	 * @param MaxDistance The largest distance DistanceFunc will return. Ignored if DistanceFunc is null.
+	 * @param DistanceFunc Optional function returning the minimum distance between points at a given location. Will
+	 *		be called from multiple threads at once. If null, MinDistance is used everywhere.
+	 * @param Seed Seed for the random streams, one of which is created for each tile
+	 * @param OutPoints Array to append results to. Will not be cleared before adding.
+	 * @param MaxAttempts The number of candidates to try around each point before giving up on it
+	 * @param TileSize The size of each tile. Will be increased if needed so that tiles are larger than the largest
+	 *		distance. If 0, a size is picked to give roughly 1000 points per tile.
+	 * @return The number of points added
+	 */
+	static int SampleBoxParallel(const FBox& Box,
+	                             float MinDistance,
+	                             float MaxDistance,
+	                             std::function<float(const FVector&)> DistanceFunc,
+	                             uint32 Seed,
+	                             TArray<FVector>& OutPoints,
+	                             int MaxAttempts = 30,
+	                             float TileSize = 0);
+};
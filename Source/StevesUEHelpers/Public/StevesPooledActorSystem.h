@@ -9,26 +9,216 @@
 #include "Engine/World.h"
 #include "StevesPooledActorSystem.generated.h"
 
+class UPrimitiveComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnPooledActorPreWarmProgress, TSubclassOf<AActor>, ActorClass, int, NumReady, int, NumRequested);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPooledActorPreWarmComplete, TSubclassOf<AActor>, ActorClass);
+
+/// What to do when an actor is requested but the pool for that class has reached its maximum size
+UENUM(BlueprintType)
+enum class EStevesPoolOverflowBehaviour : uint8
+{
+	/// Return null instead of spawning another actor
+	Refuse,
+	/// Take the actor which has been in use the longest and re-use it
+	RecycleOldest
+};
+
+/**
+ * Sizing policy for the pool of a single actor class. Without a policy, pools grow without limit and only shrink
+ * when drained explicitly.
+ * Usage is tracked as a high-water mark of actors in use at once. Surplus pooled actors over that high-water mark plus
+ * TargetHeadroom are destroyed gradually once the pool has gone IdleTrimDelay seconds without reaching a new high.
+ */
+USTRUCT(BlueprintType)
+struct STEVESUEHELPERS_API FStevesPooledActorPolicy
+{
+	GENERATED_BODY()
+
+	/// The minimum number of actors to keep in the pool; trimming will never go below this
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	int MinPooled = 0;
+
+	/// The maximum number of actors of this class, in use and pooled combined. 0 means unlimited
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	int MaxActors = 0;
+
+	/// How many spare actors to keep in the pool over the high-water mark of actors in use
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	int TargetHeadroom = 4;
+
+	/// How many seconds usage must stay below the high-water mark before surplus actors start being trimmed.
+	/// 0 disables trimming.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	float IdleTrimDelay = 30;
+
+	/// How many surplus actors to destroy per second when trimming
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	float IdleTrimRate = 10;
+
+	/// What to do when MaxActors has been reached and another actor is requested
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	EStevesPoolOverflowBehaviour OverflowBehaviour = EStevesPoolOverflowBehaviour::Refuse;
+};
+
+/**
+ * Describes how actors of a class are deactivated while they're in the pool, to reduce their cost to near zero.
+ * Without a profile, pooled actors are just hidden, have physics disabled and are moved to the storage location.
+ * Everything changed by a profile is restored to its previous state when the actor is taken from the pool.
+ */
+USTRUCT(BlueprintType)
+struct STEVESUEHELPERS_API FStevesPooledActorDeactivationProfile
+{
+	GENERATED_BODY()
+
+	/// Disable the actor's own tick while pooled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	bool bDisableActorTick = true;
+
+	/// Disable ticking of all the actor's components while pooled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	bool bDisableComponentTick = true;
+
+	/// Disable collision for the whole actor while pooled. Because a hidden actor with no collision can't affect
+	/// anything, this also skips the teleport to the storage location, saving the overlap updates that involves.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	bool bDisableCollision = true;
+
+	/// Make primitive components invisible while pooled, which removes them from the scene entirely. Hiding the actor
+	/// already does this for most primitives, but not those which cast hidden shadows or affect indirect lighting
+	/// while hidden.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pooling")
+	bool bDestroyRenderState = false;
+};
+
 /**
  * General actor pooling system
  */
 UCLASS()
-class STEVESUEHELPERS_API UStevesPooledActorSystem : public UWorldSubsystem
+class STEVESUEHELPERS_API UStevesPooledActorSystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 protected:
-	TMap<UClass*, TDeque<TObjectPtr<AActor>>> Pools;
+	/// A pool of inactive actors of a single class. Actors are taken from & returned to the end of the list, so we
+	/// get the most recently used actor for better potential cache use
+	struct FActorPool
+	{
+		TArray<TObjectPtr<AActor>> Actors;
+
+		/// Cached so we don't have to check the interface on every get / release
+		bool bImplementsPooledActor = false;
+
+		FStevesPooledActorPolicy Policy;
+		bool bHasPolicy = false;
+
+		FStevesPooledActorDeactivationProfile DeactivationProfile;
+		bool bHasDeactivationProfile = false;
+
+		/// Number of actors of this class currently handed out
+		int32 NumActive = 0;
+		/// Most actors in use at once, decays towards NumActive when trimming
+		int32 HighWaterActive = 0;
+		/// World time when HighWaterActive was last reached
+		float HighWaterTime = 0;
+		/// Fractional actors owed to trimming, since the trim rate is per second
+		float TrimAccumulator = 0;
+
+		/// Lifetime statistics, for tuning pre-warm counts & policies
+		uint32 NumHits = 0;
+		uint32 NumRecycled = 0;
+		uint32 NumMisses = 0;
+		uint32 NumRefused = 0;
+		uint32 NumPreWarmed = 0;
+
+		/// Actors in use in the order they were handed out, only maintained for RecycleOldest policies.
+		/// Entries are invalidated lazily by comparing serials with the membership entry.
+		struct FActiveRecord
+		{
+			AActor* Actor;
+			uint32 Serial;
+		};
+		TDeque<FActiveRecord> ActiveOrder;
+
+		int32 NumTotal() const { return NumActive + Actors.Num(); }
+	};
+	TMap<UClass*, FActorPool> Pools;
+
+	/// Membership record for every actor the pool system knows about, whether currently pooled or in use.
+	/// This lets us reject double-releases and evict destroyed actors from the pool in O(1).
+	struct FPooledActorEntry
+	{
+		UClass* PoolClass = nullptr;
+		/// Index into the pool's actor list if currently pooled, INDEX_NONE if in use
+		int32 PoolIndex = INDEX_NONE;
+		/// Incremented every time the actor is handed out, to validate FActiveRecord
+		uint32 ActiveSerial = 0;
+
+		/// State switched off by a deactivation profile while pooled, so exactly that can be restored
+		bool bRestoreActorTick = false;
+		bool bRestoreCollision = false;
+		TArray<TWeakObjectPtr<UActorComponent>> RestoreTickComponents;
+		TArray<TWeakObjectPtr<UPrimitiveComponent>> RestoreVisibleComponents;
+
+		bool IsPooled() const { return PoolIndex != INDEX_NONE; }
+	};
+	TMap<const AActor*, FPooledActorEntry> PooledActorEntries;
 
 	/// The location that actors in the pool are stored at
 	UPROPERTY(BlueprintReadWrite, Category="Pooling")
 	FVector StorageLocation = FVector(0,0,-100000);
 
-	TDeque<TObjectPtr<AActor>>* GetPool(UClass* Class, bool bCreate);
-	void DisableActor(AActor* Actor);
-	void ReviveActor(AActor* Actor, const FVector& Location, const FRotator& Rotator);
+	/// The maximum number of actors spawned per frame by PreWarmActorPoolAsync, across all classes
+	UPROPERTY(BlueprintReadWrite, Category="Pooling")
+	int PreWarmMaxSpawnsPerFrame = 10;
+
+	/// The maximum time in milliseconds spent spawning actors per frame by PreWarmActorPoolAsync. At least one actor
+	/// is always spawned per frame while a pre-warm is pending, so that progress is guaranteed.
+	UPROPERTY(BlueprintReadWrite, Category="Pooling")
+	float PreWarmMaxFrameTimeMs = 2.0f;
+
+	/// The maximum number of surplus actors destroyed per frame by pool policies, across all classes
+	UPROPERTY(BlueprintReadWrite, Category="Pooling")
+	int TrimMaxActorsPerFrame = 4;
+
+	/// Number of pools with a policy which requires trimming
+	int NumTrimmingPools = 0;
+
+	struct FPendingPreWarm
+	{
+		TWeakObjectPtr<UClass> Class;
+		int TargetCount;
+
+		FPendingPreWarm(UClass* InClass, int InTargetCount) : Class(InClass), TargetCount(InTargetCount) {}
+	};
+	/// Async pre-warms in the order requested
+	TArray<FPendingPreWarm> PendingPreWarms;
+
+	FActorPool* GetPool(UClass* Class, bool bCreate);
+	FActorPool* SpawnIntoPool(UClass* Class);
+	void TickPreWarm();
+	void TickTrim(float DeltaTime);
+	int GetPreWarmLimit(const FActorPool* pPool, int Count) const;
+	bool IsPreWarmPending(const UClass* Class) const;
+	void MarkActive(FActorPool* pPool, AActor* Actor, FPooledActorEntry& Entry);
+	AActor* RecycleOldestActive(FActorPool* pPool);
+	bool IsPoolAtMax(const FActorPool* pPool) const;
+	void DisableActor(AActor* Actor, const FActorPool* pPool, FPooledActorEntry& Entry);
+	/// pPool and Entry are only read before any actor code runs, so may be invalidated by it
+	void ReviveActor(AActor* Actor, const FTransform& Transform, bool bApplyScale, const FActorPool* pPool, FPooledActorEntry& Entry);
 
-	AActor* SpawnNewActor(UClass* ActorClass, const FVector& Location, const FRotator& Rotation);
-	void DrainPool(TDeque<TObjectPtr<AActor>>* pPool, int NumberToKeep);
+	AActor* SpawnNewActor(UClass* ActorClass, const FTransform& Transform);
+	/// Remove actors from a pool, without destroying them yet since that runs actor code which may change the pools
+	void DrainPool(FActorPool* pPool, int NumberToKeep, TArray<AActor*>& OutActorsToDestroy);
+	static void DestroyActors(TConstArrayView<AActor*> Actors);
+
+	FPooledActorEntry& TrackActor(AActor* Actor, UClass* Class, FActorPool* pPool);
+	void UntrackActor(AActor* Actor);
+	void PushToPool(FActorPool* pPool, AActor* Actor, FPooledActorEntry& Entry);
+	AActor* PopFromPool(FActorPool* pPool);
+	void RemoveFromPoolAt(FActorPool* pPool, int32 Index);
+
+	UFUNCTION()
+	void OnPooledActorDestroyed(AActor* Actor);
 
 public:
 
@@ -49,19 +239,24 @@ public:
 
 	/**
 	 * Add an actor to the pool. Will make the actor invisible, teleport it to the storage location, and disable all
-	 * physics. You must NOT destroy this actor!
+	 * physics. Adding an actor which is already in the pool does nothing. If the actor is destroyed while in the pool,
+	 * it is removed from the pool automatically.
 	 * @param Actor 
 	 */
 	UFUNCTION(BlueprintCallable, Category="Pooling")
 	void AddActorToPool(AActor* Actor);
 	/**
 	 * Release an actor back to the pool, instead of destroying it. Will make the actor invisible, teleport it to a
-	 * far away location, and disable physics. You must NOT destroy this actor!
+	 * far away location, and disable physics. Releasing an actor which is already in the pool does nothing.
 	 * @param Actor 
 	 */
 	UFUNCTION(BlueprintCallable, Category="Pooling")
 	void ReleasePooledActor(AActor* Actor);
 
+	/// Return whether an actor is currently sitting in the pool, i.e. has been added / released and not yet re-used
+	UFUNCTION(BlueprintPure, Category="Pooling")
+	bool IsActorInPool(const AActor* Actor) const;
+
 	/**
 	 * Re-use or spawn an actor of a given class. Note that if the actor is re-used, you will need to re-enable physics
 	 * yourself since we do not store that state or assume it will be the same. It will be teleported to the correct location and set visible.
@@ -71,6 +266,7 @@ public:
 	 * @param bWasReUsed This is set to true if the actor was re-used from the pool, and therefore will need to have its
 	 *	physics reset by the caller (if not done by an IStevesPooledActor implementation)
 	 * @return Spawned or re-used actor. Remember to check physics settings, both will be disabled if re-used.
+	 *	May be null if a pool policy limits the number of actors and its overflow behaviour is Refuse.
 	 */
 	UFUNCTION(BlueprintCallable, Category="Pooling")
 	AActor* GetPooledActor(TSubclassOf<AActor> ActorClass,
@@ -92,6 +288,50 @@ public:
 		return Cast<T>(GetPooledActor(Class, Location, Rotation, Dummy));
 	}
 
+	/**
+	 * Re-use or spawn a batch of actors of a given class in one call. This is cheaper than calling GetPooledActor
+	 * repeatedly since the pool is only resolved once, all re-used actors are taken from the pool before any are
+	 * revived, and the shortfall is spawned together at the end.
+	 * @param ActorClass The class of the actors
+	 * @param Transforms World transforms for each actor (including scale). One actor is requested per transform.
+	 * @param OutActors The actors, in the same order as Transforms. Re-used actors are at the start.
+	 * @param OutNumReused The number of actors at the start of OutActors which were re-used from the pool, and so
+	 *	will need to have their physics reset by the caller (if not done by an IStevesPooledActor implementation)
+	 * @return The number of actors returned. May be fewer than requested if a pool policy limits the number of actors.
+	 */
+	int GetPooledActors(UClass* ActorClass,
+	                    TArrayView<const FTransform> Transforms,
+	                    TArray<AActor*>& OutActors,
+	                    int& OutNumReused);
+
+	template< class T >
+	int GetPooledActors(UClass* Class, TArrayView<const FTransform> Transforms, TArray<T*>& OutActors)
+	{
+		TArray<AActor*> Actors;
+		int NumReused;
+		GetPooledActors(Class, Transforms, Actors, NumReused);
+		OutActors.Reset(Actors.Num());
+		for (AActor* Actor : Actors)
+		{
+			OutActors.Add(Cast<T>(Actor));
+		}
+		return OutActors.Num();
+	}
+
+	/**
+	 * Re-use or spawn a batch of actors of a given class in one call, see GetPooledActors.
+	 * @param ActorClass The class of the actors
+	 * @param Transforms World transforms for each actor. One actor is requested per transform.
+	 * @param OutActors The actors, in the same order as Transforms. Re-used actors are at the start.
+	 * @param NumReused The number of actors at the start of OutActors which were re-used from the pool
+	 * @return The number of actors returned
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling", meta=(DisplayName="Get Pooled Actors"))
+	int GetPooledActorsForTransforms(TSubclassOf<AActor> ActorClass,
+	                                 const TArray<FTransform>& Transforms,
+	                                 TArray<AActor*>& OutActors,
+	                                 int& NumReused);
+
 	/**
 	 * Pre-warm the actor pool by creating a number of instances and making them invisible
 	 * @param ActorClass The class of actors to pre-warm the pool with
@@ -100,6 +340,88 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Pooling")
 	void PreWarmActorPool(TSubclassOf<AActor> ActorClass, int Count = 20);
 
+	/**
+	 * Pre-warm the actor pool over a number of frames, instead of all at once. Spawning is limited per frame by
+	 * PreWarmMaxSpawnsPerFrame and PreWarmMaxFrameTimeMs. Listen to OnPreWarmProgress / OnPreWarmComplete, or poll
+	 * GetPreWarmStatus, to find out when the pool is ready.
+	 * @param ActorClass The class of actors to pre-warm the pool with
+	 * @param Count The number of actors the pool should contain when complete
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void PreWarmActorPoolAsync(TSubclassOf<AActor> ActorClass, int Count = 20);
+
+	/**
+	 * Get the state of the pool for a given class, including any async pre-warm in progress
+	 * @param ActorClass The class of actor
+	 * @param NumReady The number of actors currently in the pool, ready to be used
+	 * @param NumQueued The number of actors still waiting to be spawned by an async pre-warm
+	 * @return True if an async pre-warm is still in progress for this class
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	bool GetPreWarmStatus(TSubclassOf<AActor> ActorClass, int& NumReady, int& NumQueued);
+
+	/// Return whether any async pre-warms are still in progress
+	UFUNCTION(BlueprintPure, Category="Pooling")
+	bool IsPreWarming() const { return PendingPreWarms.Num() > 0; }
+
+	/// Event raised each frame that an async pre-warm spawns actors for a class
+	UPROPERTY(BlueprintAssignable)
+	FOnPooledActorPreWarmProgress OnPreWarmProgress;
+
+	/// Event raised when an async pre-warm for a class has finished
+	UPROPERTY(BlueprintAssignable)
+	FOnPooledActorPreWarmComplete OnPreWarmComplete;
+
+	/**
+	 * Set the sizing policy for the pool of a given class. Replaces any previous policy for this class.
+	 * @param ActorClass The class of actor
+	 * @param Policy The policy to use
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void SetPoolPolicy(TSubclassOf<AActor> ActorClass, const FStevesPooledActorPolicy& Policy);
+
+	/// Remove the sizing policy for a class of actor, returning to unlimited growth
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void ClearPoolPolicy(TSubclassOf<AActor> ActorClass);
+
+	/**
+	 * Get the sizing policy for the pool of a given class
+	 * @param ActorClass The class of actor
+	 * @param OutPolicy The policy, if one exists
+	 * @return Whether a policy has been set for this class
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	bool GetPoolPolicy(TSubclassOf<AActor> ActorClass, FStevesPooledActorPolicy& OutPolicy);
+
+	/**
+	 * Set how actors of a given class are deactivated while in the pool. Only affects actors added to the pool after
+	 * this call.
+	 * @param ActorClass The class of actor
+	 * @param Profile The deactivation profile to use
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void SetPoolDeactivationProfile(TSubclassOf<AActor> ActorClass, const FStevesPooledActorDeactivationProfile& Profile);
+
+	/// Remove the deactivation profile for a class of actor, returning to the default deactivation behaviour
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void ClearPoolDeactivationProfile(TSubclassOf<AActor> ActorClass);
+
+	/**
+	 * Get the current usage of the pool for a given class
+	 * @param ActorClass The class of actor
+	 * @param NumActive The number of actors of this class currently in use
+	 * @param NumPooled The number of actors of this class waiting in the pool
+	 * @param HighWater The most actors of this class in use at once, recently
+	 */
+	UFUNCTION(BlueprintCallable, Category="Pooling")
+	void GetPoolUsage(TSubclassOf<AActor> ActorClass, int& NumActive, int& NumPooled, int& HighWater);
+
+	/**
+	 * Write occupancy & hit rate statistics for every pool to an output device. Also available from the console
+	 * as Steves.DumpPools.
+	 */
+	void DumpStats(FOutputDevice& Ar) const;
+
 	/**
 	 * Drain the actor pool for a single class of actor, destroying any surplus actors.
 	 * @param ActorClass The actor class to drain the pool for
@@ -116,4 +438,9 @@ public:
 	
 	virtual void Deinitialize() override;
 
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
 };
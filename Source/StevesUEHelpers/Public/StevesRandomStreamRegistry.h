@@ -0,0 +1,77 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#pragma once
+
+#include <atomic>
+#include "CoreMinimal.h"
+#include "StevesBalancedRandomStream.h"
+
+/**
+ * Hands out independent random streams to worker threads / tasks, derived from a single master seed, so that content
+ * generated in parallel doesn't need to share (and lock) a single stream.
+ *
+ * For results which are reproducible regardless of scheduling, key streams by your own task index (e.g. the index
+ * in a ParallelFor) using GetTaskStream or GetTaskSeed. These are pure functions of the master seed and task index,
+ * so need no locks at all.
+ *
+ * GetThreadStream is also available for convenience when there's no natural task index, but since which thread
+ * runs which piece of work depends on scheduling, the values each piece of work receives are not reproducible.
+ *
+ * Initialize is not thread safe; call it before dispatching work which uses the registry.
+ */
+class STEVESUEHELPERS_API FStevesRandomStreamRegistry
+{
+public:
+	/// Default number of values in the master sequence reserved for each task
+	static constexpr uint32 DefaultTaskStride = 65536;
+
+protected:
+	/// Master stream at its start position; only ever copied after initialisation
+	FStevesBalancedRandomStream Master;
+	uint32 TaskStride = DefaultTaskStride;
+	/// Unique per registry, so per-thread streams know which registry they came from
+	uint32 Id;
+	/// Incremented on Initialize, so per-thread streams know to re-derive themselves
+	std::atomic<uint32> Generation {0};
+	std::atomic<uint32> NextThreadSlot {0};
+
+public:
+	FStevesRandomStreamRegistry();
+	explicit FStevesRandomStreamRegistry(uint32 MasterSeed, uint32 InTaskStride = DefaultTaskStride);
+
+	/**
+	 * (Re-)initialise the registry. Existing per-thread streams will be re-derived the next time they're requested.
+	 * @param MasterSeed The seed all streams are derived from
+	 * @param InTaskStride The number of values in the master sequence reserved for each task stream. Task streams
+	 *	don't overlap until the master sequence wraps, after kSafeMaxSeed3D / InTaskStride tasks.
+	 */
+	void Initialize(uint32 MasterSeed, uint32 InTaskStride = DefaultTaskStride);
+
+	uint32 GetMasterSeed() const { return Master.GetInitialSeed(); }
+	uint32 GetTaskStride() const { return TaskStride; }
+
+	/**
+	 * Get the balanced stream for a task. Each task gets its own run of TaskStride values from the master sequence,
+	 * so the values of all tasks together are as well distributed as the master sequence itself. Lock free and
+	 * deterministic; the same master seed and task index always give the same stream, on any thread.
+	 * @param TaskIndex Your index for this piece of work
+	 */
+	FStevesBalancedRandomStream GetTaskStream(uint32 TaskIndex) const;
+
+	/**
+	 * Get a seed for a task, for use with other stream types (FRandomStream, Sobol, R-d etc), or to make several
+	 * independent streams per task. Lock free and deterministic.
+	 * @param TaskIndex Your index for this piece of work
+	 * @param Salt Use different values to get unrelated seeds for the same task
+	 */
+	uint32 GetTaskSeed(uint32 TaskIndex, uint32 Salt = 0) const;
+
+	/**
+	 * Get a stream owned by the calling thread, which can be used without locks. The stream is created the first time
+	 * a thread asks for it, and persists across calls on that thread until the registry is re-initialised. Each
+	 * registry has its own stream per thread, so a thread can alternate between registries.
+	 * @note Which thread handles which work is down to the scheduler, so prefer GetTaskStream if you need results
+	 * to be reproducible.
+	 */
+	FStevesBalancedRandomStream& GetThreadStream();
+};
@@ -5,8 +5,26 @@
 
 #include "CoreMinimal.h"
 #include "Math/RandomStream.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "UObject/Class.h"
+#include "StevesUEHelpersVersion.h"
 #include "StevesShuffleBag.generated.h"
 
+/// Serialise the state of a random stream used by a shuffle bag. FRandomStream has no way to restore its
+/// current seed directly, so use its reflected properties.
+inline void StevesSerializeRandomStream(FArchive& Ar, FRandomStream& Stream)
+{
+	TBaseStructure<FRandomStream>::Get()->SerializeBin(Ar, &Stream);
+}
+
+/// Serialise the state of a random stream used by a shuffle bag, for streams which provide a SerializeState,
+/// such as FStevesBalancedRandomStream
+template<typename TRandStream>
+void StevesSerializeRandomStream(FArchive& Ar, TRandStream& Stream)
+{
+	Stream.SerializeState(Ar);
+}
+
 /// A shufflebag is an array that contains a certain number of items, and can randomly withdraw one
 /// at a time until there are none left. No repeat items will be retrieved until the bag is empty.
 /// Requires a type T which is the contained item (keep it small, will be copied around), and optionally
@@ -165,6 +183,424 @@ public:
 		return Bag.Num();
 	}
 
+	/// Serialise the bag so it can resume exactly where it left off. The contents are stored in their current
+	/// order, since that's the permutation future draws index into, along with the compact stream state.
+	friend FArchive& operator<<(FArchive& Ar, FStevesShuffleBag& ShuffleBag)
+	{
+		Ar << ShuffleBag.Bag;
+		Ar << ShuffleBag.SentinelIndex;
+		StevesSerializeRandomStream(Ar, ShuffleBag.RandomStream);
+		return Ar;
+	}
+
+};
+
+/// A weighted shufflebag, where each distinct item has an integer weight which behaves as if that many copies of
+/// the item had been added to an FStevesShuffleBag; an item with weight 3 is pulled 3 times per cycle of the bag.
+/// Unlike adding copies, remaining weights are held in a Fenwick tree so pulling, changing weights and removing
+/// items are all O(log n) in the number of distinct items, regardless of how large the weights are.
+/// T must be usable as a TMap key. Like FStevesShuffleBag, TRandStream must implement the FRandomStream interface.
+template<typename T, typename TRandStream = FRandomStream>
+struct FStevesWeightedShuffleBag
+{
+protected:
+	struct FEntry
+	{
+		T Item;
+		/// Total weight, restored on Reset
+		int32 Weight = 0;
+		/// Weight which has not been pulled yet
+		int32 Remaining = 0;
+	};
+
+	/// Entries by slot; slots of removed items are recycled
+	TArray<FEntry> Entries;
+	/// Fenwick tree of remaining weights per slot, 1-based so Tree[0] is unused
+	TArray<int64> Tree;
+	TMap<T, int32> SlotsByItem;
+	TArray<int32> FreeSlots;
+	TRandStream RandomStream;
+	int64 TotalWeight = 0;
+	int64 TotalRemaining = 0;
+
+	void TreeAdd(int32 Slot, int64 Delta)
+	{
+		for (int32 i = Slot + 1; i < Tree.Num(); i += i & -i)
+		{
+			Tree[i] += Delta;
+		}
+	}
+
+	/// Sum of the remaining weights of the first Count slots
+	int64 TreePrefix(int32 Count) const
+	{
+		int64 Sum = 0;
+		for (int32 i = Count; i > 0; i -= i & -i)
+		{
+			Sum += Tree[i];
+		}
+		return Sum;
+	}
+
+	/// Find the slot which contains a given offset into the total remaining weight
+	int32 TreeFind(int64 Offset) const
+	{
+		int32 Step = 1;
+		while (Step * 2 < Tree.Num())
+		{
+			Step *= 2;
+		}
+		int32 Pos = 0;
+		for (; Step > 0; Step >>= 1)
+		{
+			const int32 Next = Pos + Step;
+			if (Next < Tree.Num() && Tree[Next] <= Offset)
+			{
+				Pos = Next;
+				Offset -= Tree[Next];
+			}
+		}
+		// Pos is the number of slots entirely before the offset, which is the 0-based slot containing it
+		return Pos;
+	}
+
+	/// Rebuild the whole tree from the entries, O(n)
+	void RebuildTree()
+	{
+		Tree.SetNumUninitialized(Entries.Num() + 1);
+		Tree[0] = 0;
+		for (int32 i = 0; i < Entries.Num(); ++i)
+		{
+			Tree[i + 1] = Entries[i].Remaining;
+		}
+		for (int32 i = 1; i < Tree.Num(); ++i)
+		{
+			const int32 Parent = i + (i & -i);
+			if (Parent < Tree.Num())
+			{
+				Tree[Parent] += Tree[i];
+			}
+		}
+	}
+
+	/// Find or allocate a slot for an item, with zero weight if new. If bUpdateTree is false, the tree must be
+	/// rebuilt afterwards.
+	int32 FindOrAddSlot(const T& Item, bool bUpdateTree)
+	{
+		if (const int32* Existing = SlotsByItem.Find(Item))
+		{
+			return *Existing;
+		}
+
+		int32 Slot;
+		if (FreeSlots.Num() > 0)
+		{
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+			Slot = FreeSlots.Pop(EAllowShrinking::No);
+#else
+			Slot = FreeSlots.Pop(false);
+#endif
+			Entries[Slot].Item = Item;
+		}
+		else
+		{
+			Slot = Entries.Add(FEntry { Item, 0, 0 });
+			if (bUpdateTree)
+			{
+				// The new node covers (i - lowbit(i), i], all of which except itself is already in the tree
+				const int32 i = Slot + 1;
+				Tree.Add(TreePrefix(i - 1) - TreePrefix(i - (i & -i)));
+			}
+		}
+		SlotsByItem.Add(Item, Slot);
+		return Slot;
+	}
+
+	void SetSlotWeight(int32 Slot, int32 NewWeight, int32 NewRemaining, bool bUpdateTree)
+	{
+		FEntry& Entry = Entries[Slot];
+		TotalWeight += NewWeight - Entry.Weight;
+		const int64 Delta = NewRemaining - Entry.Remaining;
+		TotalRemaining += Delta;
+		if (Delta != 0 && bUpdateTree)
+		{
+			TreeAdd(Slot, Delta);
+		}
+		Entry.Weight = NewWeight;
+		Entry.Remaining = NewRemaining;
+	}
+
+	/// Remove an item's slot entirely, returning the weight it had
+	int32 FreeSlot(int32 Slot, bool bUpdateTree)
+	{
+		const int32 Weight = Entries[Slot].Weight;
+		SetSlotWeight(Slot, 0, 0, bUpdateTree);
+		SlotsByItem.Remove(Entries[Slot].Item);
+		Entries[Slot].Item = T();
+		FreeSlots.Add(Slot);
+		return Weight;
+	}
+
+public:
+	/// Construct using a zero seed & standard capacity
+	FStevesWeightedShuffleBag()
+	{
+		Init(0);
+	}
+
+	/// Construct using a known seed & capacity
+	FStevesWeightedShuffleBag(int32 Seed, int Capacity = 32)
+	{
+		Init(Seed, Capacity);
+	}
+
+	/// (Re-)initialise the shuffle bag, emptying its contents and resetting the seed.
+	void Init(int32 Seed, int Capacity = 32)
+	{
+		Empty();
+		Reserve(Capacity);
+		RandomStream.Initialize(Seed);
+	}
+
+	/// Reserve space for a given number of distinct items
+	void Reserve(int Capacity)
+	{
+		Entries.Reserve(Capacity);
+		Tree.Reserve(Capacity + 1);
+		SlotsByItem.Reserve(Capacity);
+	}
+
+	/**
+	 * Add weight to an item in the bag, adding the item if it's not already present. O(log n).
+	 * @param NewItem The item to add
+	 * @param Weight The weight to add, equivalent to the number of copies in FStevesShuffleBag
+	 * @note Unlike FStevesShuffleBag, added weight is available to be pulled immediately, even if you've already
+	 * started pulling items from the bag.
+	 */
+	void Add(const T& NewItem, int32 Weight = 1)
+	{
+		if (Weight <= 0)
+		{
+			return;
+		}
+		const int32 Slot = FindOrAddSlot(NewItem, true);
+		const FEntry& Entry = Entries[Slot];
+		SetSlotWeight(Slot, Entry.Weight + Weight, Entry.Remaining + Weight, true);
+	}
+
+	/**
+	 * Add many items at once, rebuilding the tree once at the end, O(n + k).
+	 * @param Items The items to add
+	 * @param Weights The weights of each item, the same length as Items. If empty, each item gets a weight of 1.
+	 */
+	void AddRange(TConstArrayView<T> Items, TConstArrayView<int32> Weights = TConstArrayView<int32>())
+	{
+		check(Weights.Num() == 0 || Weights.Num() == Items.Num());
+		Reserve(Entries.Num() + Items.Num());
+		for (int32 i = 0; i < Items.Num(); ++i)
+		{
+			const int32 Weight = Weights.Num() > 0 ? Weights[i] : 1;
+			if (Weight > 0)
+			{
+				const int32 Slot = FindOrAddSlot(Items[i], false);
+				const FEntry& Entry = Entries[Slot];
+				SetSlotWeight(Slot, Entry.Weight + Weight, Entry.Remaining + Weight, false);
+			}
+		}
+		RebuildTree();
+	}
+
+	/**
+	 * Change the total weight of an item, adding it if needed, or removing it if the weight is <= 0. The amount of
+	 * this item already pulled is preserved, so if you reduce the weight below that, nothing will remain. O(log n).
+	 */
+	void SetWeight(const T& Item, int32 Weight)
+	{
+		if (Weight <= 0)
+		{
+			RemoveAll(Item);
+			return;
+		}
+		const int32 Slot = FindOrAddSlot(Item, true);
+		const FEntry& Entry = Entries[Slot];
+		const int32 Pulled = Entry.Weight - Entry.Remaining;
+		SetSlotWeight(Slot, Weight, FMath::Max(0, Weight - Pulled), true);
+	}
+
+	/// Get the total weight of an item, or 0 if it's not in the bag
+	int32 GetWeight(const T& Item) const
+	{
+		const int32* Slot = SlotsByItem.Find(Item);
+		return Slot ? Entries[*Slot].Weight : 0;
+	}
+
+	/// Get the weight of an item which has not been pulled yet
+	int32 GetRemainingWeight(const T& Item) const
+	{
+		const int32* Slot = SlotsByItem.Find(Item);
+		return Slot ? Entries[*Slot].Remaining : 0;
+	}
+
+	/// Remove weight from an item and discard it, removing the item entirely if no weight is left. Weight which has
+	/// already been pulled is removed first. O(log n).
+	/// Returns the amount of weight removed.
+	int32 Remove(const T& Item, int32 Weight = 1)
+	{
+		const int32* Slot = SlotsByItem.Find(Item);
+		if (!Slot || Weight <= 0)
+		{
+			return 0;
+		}
+		const FEntry& Entry = Entries[*Slot];
+		if (Weight >= Entry.Weight)
+		{
+			return FreeSlot(*Slot, true);
+		}
+		const int32 NewWeight = Entry.Weight - Weight;
+		SetSlotWeight(*Slot, NewWeight, FMath::Min(Entry.Remaining, NewWeight), true);
+		return Weight;
+	}
+
+	/// Remove an item from the bag entirely. O(log n).
+	/// Returns the weight removed.
+	int32 RemoveAll(const T& Item)
+	{
+		const int32* Slot = SlotsByItem.Find(Item);
+		return Slot ? FreeSlot(*Slot, true) : 0;
+	}
+
+	/// Remove many items from the bag entirely, rebuilding the tree once at the end, O(n + k).
+	/// Returns the total weight removed.
+	int64 RemoveRange(TConstArrayView<T> Items)
+	{
+		int64 Removed = 0;
+		for (const T& Item : Items)
+		{
+			if (const int32* Slot = SlotsByItem.Find(Item))
+			{
+				Removed += FreeSlot(*Slot, false);
+			}
+		}
+		RebuildTree();
+		return Removed;
+	}
+
+	/// Empty the bag, discarding the contents
+	void Empty()
+	{
+		// Keep allocations
+		Entries.Reset();
+		Tree.Reset();
+		Tree.Add(0);
+		SlotsByItem.Reset();
+		FreeSlots.Reset();
+		TotalWeight = 0;
+		TotalRemaining = 0;
+	}
+
+	/// Reset the bag, returning all previously retrieved contents to the bag. O(n).
+	void Reset()
+	{
+		for (FEntry& Entry : Entries)
+		{
+			Entry.Remaining = Entry.Weight;
+		}
+		TotalRemaining = TotalWeight;
+		RebuildTree();
+	}
+
+	/// Pull a random item from those remaining in the bag, with probability proportional to its remaining weight.
+	/// If the bag is empty, it will be refilled (via Reset). O(log n).
+	T Next()
+	{
+		if (TotalRemaining <= 0)
+		{
+			Reset();
+		}
+
+		// Empty bag
+		if (TotalRemaining <= 0)
+		{
+			return T();
+		}
+
+		const int64 Offset = TotalRemaining <= MAX_int32
+			                     ? RandomStream.RandRange(0, (int32)TotalRemaining - 1)
+			                     : FMath::Min((int64)(RandomStream.GetFraction() * TotalRemaining), TotalRemaining - 1);
+		const int32 Slot = TreeFind(Offset);
+		FEntry& Entry = Entries[Slot];
+		--Entry.Remaining;
+		--TotalRemaining;
+		TreeAdd(Slot, -1);
+		return Entry.Item;
+	}
+
+	/// Get the total weight left in the bag
+	int64 GetNumRemaining() const
+	{
+		return TotalRemaining;
+	}
+
+	/// Get the total weight which has already been pulled from the bag
+	int64 GetNumPulled() const
+	{
+		return TotalWeight - TotalRemaining;
+	}
+
+	/// Get the total weight both remaining in the bag and which has already been pulled from it
+	int64 GetNumTotal() const
+	{
+		return TotalWeight;
+	}
+
+	/// Get the number of distinct items in the bag
+	int GetNumItems() const
+	{
+		return SlotsByItem.Num();
+	}
+
+	/// Serialise the bag so it can resume exactly where it left off. Only items still in the bag are stored, in
+	/// slot order so that draws after loading are the same; the tree is rebuilt on load.
+	friend FArchive& operator<<(FArchive& Ar, FStevesWeightedShuffleBag& ShuffleBag)
+	{
+		int32 NumItems = ShuffleBag.SlotsByItem.Num();
+		Ar << NumItems;
+		if (Ar.IsLoading())
+		{
+			ShuffleBag.Empty();
+			ShuffleBag.Reserve(NumItems);
+			for (int32 i = 0; i < NumItems && !Ar.IsError(); ++i)
+			{
+				T Item;
+				uint32 Weight, Remaining;
+				Ar << Item;
+				Ar.SerializeIntPacked(Weight);
+				Ar.SerializeIntPacked(Remaining);
+				if (Weight > 0 && Weight <= MAX_int32)
+				{
+					const int32 Slot = ShuffleBag.FindOrAddSlot(Item, false);
+					ShuffleBag.SetSlotWeight(Slot, Weight, FMath::Min(Remaining, Weight), false);
+				}
+			}
+			ShuffleBag.RebuildTree();
+		}
+		else
+		{
+			for (FEntry& Entry : ShuffleBag.Entries)
+			{
+				// Free slots have no weight, skipping them doesn't change which item each offset maps to
+				if (Entry.Weight > 0)
+				{
+					uint32 Weight = Entry.Weight, Remaining = Entry.Remaining;
+					Ar << Entry.Item;
+					Ar.SerializeIntPacked(Weight);
+					Ar.SerializeIntPacked(Remaining);
+				}
+			}
+		}
+		StevesSerializeRandomStream(Ar, ShuffleBag.RandomStream);
+		return Ar;
+	}
 };
 
 /// A shufflebag is an array that contains a certain number of items, and can randomly withdraw one
@@ -188,6 +624,16 @@ public:
 	UStevesIndexShuffleBag()
 	{
 	}
+
+	virtual void Serialize(FArchive& Ar) override
+	{
+		Super::Serialize(Ar);
+		Ar.UsingCustomVersion(FStevesUEHelpersVersion::GUID);
+		if (FStevesUEHelpersVersion::Get(Ar) >= FStevesUEHelpersVersion::CompactRandomState)
+		{
+			Ar << IndexBag;
+		}
+	}
 	
 	/// Reinitialise the shuffle bag with a new size / seed.
 	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
@@ -258,3 +704,135 @@ public:
 	
 };
 
+/// Blueprint counterpart of FStevesWeightedShuffleBag, which like UStevesIndexShuffleBag provides indexes
+/// into another array rather than the items themselves. Instead of adding multiple entries to your array to
+/// customise the probabilities, give each index a weight.
+/// Use MakeWeightedIndexShuffleBag to create.
+UCLASS(BlueprintType)
+class UStevesWeightedIndexShuffleBag : public UObject
+{
+	GENERATED_BODY()
+
+protected:
+	FStevesWeightedShuffleBag<int> IndexBag;
+	/// The number of indexes which have been allocated, including those since removed
+	int NumIndexes = 0;
+public:
+
+	UStevesWeightedIndexShuffleBag()
+	{
+	}
+
+	virtual void Serialize(FArchive& Ar) override
+	{
+		Super::Serialize(Ar);
+		Ar.UsingCustomVersion(FStevesUEHelpersVersion::GUID);
+		if (FStevesUEHelpersVersion::Get(Ar) >= FStevesUEHelpersVersion::CompactRandomState)
+		{
+			Ar << NumIndexes;
+			Ar << IndexBag;
+		}
+	}
+
+	/// Reinitialise the shuffle bag with new weights / seed. Indexes will be 0..Weights.Num()-1
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	void Reinitialise(const TArray<int>& Weights, int32 Seed)
+	{
+		IndexBag.Init(Seed, Weights.Num());
+		NumIndexes = 0;
+		AddRange(Weights);
+	}
+
+	/**
+	 * Create a new weighted shuffle bag of indexes for accessing items in an array
+	 * @param Outer The owner of the new object
+	 * @param Weights The weight of each item in the array you'll be accessing with these indexes
+	 * @param Seed The seed for the random number generator
+	 * @return The new weighted index shuffle bag
+	 */
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	static UStevesWeightedIndexShuffleBag* MakeWeightedIndexShuffleBag(UObject* Outer, const TArray<int>& Weights, int32 Seed = 0)
+	{
+		auto Ret = NewObject<UStevesWeightedIndexShuffleBag>(Outer);
+		Ret->Reinitialise(Weights, Seed);
+		return Ret;
+	}
+
+	/// Add new indexes to the end of the bag with the given weights, for when you've added items to your array.
+	/// Returns the first new index.
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	int AddRange(const TArray<int>& Weights)
+	{
+		const int First = NumIndexes;
+		TArray<int> Indexes;
+		Indexes.SetNumUninitialized(Weights.Num());
+		for (int i = 0; i < Weights.Num(); ++i)
+		{
+			Indexes[i] = NumIndexes++;
+		}
+		IndexBag.AddRange(Indexes, Weights);
+		return First;
+	}
+
+	/// Remove indexes from the bag entirely. Other indexes are unchanged.
+	/// Returns the total weight removed.
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	int64 RemoveRange(const TArray<int>& Indexes)
+	{
+		return IndexBag.RemoveRange(Indexes);
+	}
+
+	/// Change the weight of an index. The amount already pulled is preserved.
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	void SetWeight(int Index, int Weight)
+	{
+		if (Index >= 0 && Index < NumIndexes)
+		{
+			IndexBag.SetWeight(Index, Weight);
+		}
+	}
+
+	/// Get the weight of an index
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Shuffle Bag")
+	int GetWeight(int Index) const
+	{
+		return IndexBag.GetWeight(Index);
+	}
+
+	/// Get the total weight left in the bag
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Shuffle Bag")
+	int64 GetNumRemaining() const
+	{
+		return IndexBag.GetNumRemaining();
+	}
+
+	/// Get the total weight which has already been pulled from the bag
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Shuffle Bag")
+	int64 GetNumPulled() const
+	{
+		return IndexBag.GetNumPulled();
+	}
+
+	/// Get the total weight both remaining in the bag and which has already been pulled from it
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Shuffle Bag")
+	int64 GetNumTotal() const
+	{
+		return IndexBag.GetNumTotal();
+	}
+
+	/// Reset the bag, returning all previously retrieved contents to the bag
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	void Reset()
+	{
+		IndexBag.Reset();
+	}
+
+	/// Pull a random index from those remaining in the bag, weighted by remaining weight. If the bag is empty, it
+	/// will be refilled (via Reset). Returns -1 if there is nothing with any weight in the bag.
+	UFUNCTION(BlueprintCallable, Category="Shuffle Bag")
+	int Next()
+	{
+		return IndexBag.GetNumTotal() > 0 ? IndexBag.Next() : INDEX_NONE;
+	}
+};
+
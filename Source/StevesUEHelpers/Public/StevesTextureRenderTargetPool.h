@@ -3,13 +3,27 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Deque.h"
+#include "Containers/Ticker.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "RenderCommandFence.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "UObject/GCObject.h"
 
 typedef TSharedPtr<struct FStevesTextureRenderTargetReservation> FStevesTextureRenderTargetReservationPtr;
 typedef TSharedPtr<struct FStevesTextureRenderTargetPool> FStevesTextureRenderTargetPoolPtr;
 
+/// How a texture render target pool matches requested sizes to the textures it holds
+enum class EStevesTextureRenderTargetSizing : uint8
+{
+	/// Textures are only re-used for requests of exactly the same size (default)
+	Exact,
+	/// Requested sizes are rounded up to the next power of two in each dimension
+	PowerOfTwo,
+	/// Requested sizes are rounded up to the next multiple of the pool's bucket granularity in each dimension
+	Bucketed
+};
+
 /// Holder for an assigned texture. While this structure exists, the texture will be considered assigned 
 /// and will not be returned from any other request. Once this structure is destroyed the texture will
 /// be free for re-use. For that reason, only pass this structure around by SharedRef/SharedPtr.
@@ -22,6 +36,12 @@ public:
 	TWeakObjectPtr<UTextureRenderTarget2D> Texture;
 	TWeakPtr<struct FStevesTextureRenderTargetPool> ParentPool;
 	TWeakObjectPtr<const UObject> CurrentOwner;
+	/// The size that was requested. If the pool rounds sizes up, the texture may be larger than this, in which case
+	/// only the top-left region of this size should be used, see GetValidRect / GetValidUVScale
+	FIntPoint RequestedSize = FIntPoint::ZeroValue;
+	/// True if this reservation was made asynchronously and the texture's resource is still being initialised by the
+	/// render thread. Don't render to or sample the texture until this is false.
+	bool bPending = false;
 	
 	FStevesTextureRenderTargetReservation() = default;
 
@@ -30,14 +50,55 @@ public:
 	                                      const UObject* InOwner)
 		: Texture(InTexture),
 		  ParentPool(InParent),
-		  CurrentOwner(InOwner)
+		  CurrentOwner(InOwner),
+		  RequestedSize(InTexture ? FIntPoint(InTexture->SizeX, InTexture->SizeY) : FIntPoint::ZeroValue)
 	
 	{
 	}
+
+	FStevesTextureRenderTargetReservation(UTextureRenderTarget2D* InTexture,
+	                                      FStevesTextureRenderTargetPoolPtr InParent,
+	                                      const UObject* InOwner,
+	                                      FIntPoint InRequestedSize)
+		: Texture(InTexture),
+		  ParentPool(InParent),
+		  CurrentOwner(InOwner),
+		  RequestedSize(InRequestedSize)
+	
+	{
+	}
+
+	/// Whether the texture is available and ready to use
+	bool IsReady() const { return !bPending && Texture.IsValid(); }
+
+	/// Get the region of the texture, in pixels, which corresponds to the requested size
+	FIntRect GetValidRect() const { return FIntRect(FIntPoint::ZeroValue, RequestedSize); }
+
+	/// Get the scale to apply to UVs (0..1) to address only the valid region of the texture
+	FVector2D GetValidUVScale() const
+	{
+		if (Texture.IsValid() && Texture->SizeX > 0 && Texture->SizeY > 0)
+		{
+			return FVector2D((double)RequestedSize.X / Texture->SizeX, (double)RequestedSize.Y / Texture->SizeY);
+		}
+		return FVector2D::UnitVector;
+	}
 	
 	~FStevesTextureRenderTargetReservation();
 };
 
+/// Called when a reservation made with ReserveTextureAsync is ready to use
+DECLARE_DELEGATE_OneParam(FOnStevesTextureRenderTargetReady, FStevesTextureRenderTargetReservationPtr);
+
+/// A size / format combination to create up front in a texture render target pool
+struct FStevesTextureRenderTargetPreWarmSpec
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+	ETextureRenderTargetFormat Format = RTF_RGBA16f;
+	/// The number of textures of this size & format to create
+	int32 Count = 1;
+};
+
 
 /**
  * A pool of render target textures. To save pre-creating render textures as assets, and to control the re-use of
@@ -80,27 +141,93 @@ protected:
 	TMultiMap<FTextureKey, TObjectPtr<UTextureRenderTarget2D>> UnreservedTextures;
 	TSet<TObjectPtr<UTextureRenderTarget2D>> ReservedTextures;
 
-	/// Weak reverse tracking of reservations, mostly for debugging
+	/// Weak reverse tracking of reservations
 	struct FReservationInfo
 	{
 		FTextureKey Key;
-		TWeakObjectPtr<const UObject> Owner;
-		TWeakObjectPtr<UTextureRenderTarget2D> Texture;
+		TObjectKey<UObject> Owner;
+		/// The reservation holding this texture, so that a stale reservation can't release a texture which has been
+		/// revoked and reserved again by someone else. Only used for identity, never dereferenced.
+		const FStevesTextureRenderTargetReservation* Reservation = nullptr;
 
-		FReservationInfo(const FTextureKey& InKey, const UObject* InOwner, UTextureRenderTarget2D* InTexture)
+		FReservationInfo(const FTextureKey& InKey, const UObject* InOwner)
 			: Key(InKey),
-			  Owner(InOwner),
-			  Texture(InTexture)
+			  Owner(InOwner)
 		{
 		}
 	};
-	TArray<FReservationInfo> Reservations;
+	/// Unreserved textures in the order they were released, oldest first, for LRU eviction. Records aren't removed
+	/// when a texture is reserved again, instead they're skipped if they don't match the texture's UnreservedTimes entry
+	struct FUnreservedRecord
+	{
+		const UTextureRenderTarget2D* Texture = nullptr;
+		double Time = 0;
+	};
+	TDeque<FUnreservedRecord> UnreservedOrder;
+	/// The time each unreserved texture was returned to the pool
+	TMap<const UTextureRenderTarget2D*, double> UnreservedTimes;
+
+	/// Textures which were created without blocking, and the fences which complete once their resources are initialised
+	TMap<const UTextureRenderTarget2D*, FRenderCommandFence> PendingTextures;
+	struct FPendingReservation
+	{
+		TWeakPtr<FStevesTextureRenderTargetReservation> Reservation;
+		FOnStevesTextureRenderTargetReady OnReady;
+	};
+	/// Async reservations waiting for their texture to be ready
+	TArray<FPendingReservation> PendingReservations;
+	FTSTicker::FDelegateHandle PendingTickHandle;
+
+	/// Reservations indexed by texture
+	TMap<const UTextureRenderTarget2D*, FReservationInfo> Reservations;
+	/// Reserved textures indexed by owner, so revoking by owner only visits that owner's reservations
+	TMultiMap<TObjectKey<UObject>, const UTextureRenderTarget2D*> ReservationsByOwner;
+
+	/// Statistics, for tuning
+	uint32 NumHits = 0;
+	uint32 NumMisses = 0;
+	/// Estimated memory used by all textures created by this pool
+	uint64 TotalMemory = 0;
+
+	EStevesTextureRenderTargetSizing Sizing = EStevesTextureRenderTargetSizing::Exact;
+	int32 BucketGranularity = 32;
+	/// When rounding sizes up, the largest ratio of texture area to requested area we'll accept when re-using a
+	/// larger texture than the rounded size
+	float MaxBestFitAreaRatio = 4.0f;
+	/// Cap on TotalMemory, 0 for unlimited
+	uint64 MaxMemory = 0;
+	/// Soft limit on TotalMemory, unreserved textures are evicted while it's exceeded. 0 for unlimited
+	uint64 MemoryBudget = 0;
+	/// Unreserved textures which haven't been used for this many seconds are evicted. 0 to keep them indefinitely
+	double IdleEvictTime = 0;
+	/// Number of unreserved textures released because of the memory budget / cap or idle time
+	uint32 NumEvictions = 0;
+
+	static uint64 GetTextureMemorySize(const UTextureRenderTarget2D* Tex);
+	static uint64 EstimateTextureMemorySize(FIntPoint Size, ETextureRenderTargetFormat Format);
+	FIntPoint GetPooledSize(FIntPoint RequestedSize) const;
+	UTextureRenderTarget2D* TakeUnreservedTexture(const FTextureKey& Key, FIntPoint RequestedSize);
+	bool MakeRoomFor(uint64 Bytes);
+	void ReleaseTexture(UTextureRenderTarget2D* Tex);
+	/// Create a new texture, with its memory accounted for. If bAsync, the texture is pending until its fence completes
+	UTextureRenderTarget2D* CreateTexture(const FTextureKey& Key, bool bAsync);
+	FStevesTextureRenderTargetReservationPtr ReserveTextureInternal(FIntPoint Size, ETextureRenderTargetFormat Format, const UObject* Owner, bool bAsync);
+	void StartPendingTicker();
+	bool TickPending(float DeltaTime);
+	void AddUnreservedTexture(const FTextureKey& Key, UTextureRenderTarget2D* Tex);
+	/// Find the least recently used unreserved texture, returns false if there are none
+	bool GetOldestUnreservedTexture(FUnreservedRecord& OutRecord);
+	/// Release the least recently used unreserved texture, returns false if there are none
+	bool EvictOldestUnreservedTexture();
+	void EnforceMemoryBudget();
 	
 
 	friend struct FStevesTextureRenderTargetReservation;
 	/// Release a reservation on a texture, allowing it back into the pool
 	/// Protected because only FStevesTextureRenderTargetReservation will need to do this.
-	void ReleaseReservation(UTextureRenderTarget2D* Tex);
+	void ReleaseReservation(UTextureRenderTarget2D* Tex, const FStevesTextureRenderTargetReservation* Reservation);
+	/// Return a reserved texture to the unreserved list, without touching ReservationsByOwner
+	void UnreserveTexture(const UTextureRenderTarget2D* Tex, const FReservationInfo& Info);
 public:
 
 	explicit FStevesTextureRenderTargetPool(const FName& InName, UObject* InOwner)
@@ -121,15 +248,43 @@ public:
 #endif
 	/**
 	 * Reserve a texture for use as a render target. This will create a new texture target if needed. 
+	 * If the pool's sizing mode is not Exact, the texture may be larger than requested; see
+	 * FStevesTextureRenderTargetReservation::GetValidRect.
 	 * @param Size The dimensions of the texture
 	 * @param Format Format of the texture
 	 * @param Owner The UObject which will temporarily own this texture (mostly for debugging, this object won't in fact "own" it
 	 * as per garbage collection rules, the reference is weak
 	 * @return A shared pointer to a structure which holds the reservation for this texture. When that structure is
-	 * destroyed, it will release the texture back to the pool.
+	 * destroyed, it will release the texture back to the pool. Null if a new texture was needed but would have
+	 * exceeded the pool's memory cap.
 	 */
 	FStevesTextureRenderTargetReservationPtr ReserveTexture(FIntPoint Size, ETextureRenderTargetFormat Format, const UObject* Owner);
 
+	/**
+	 * Reserve a texture for use as a render target, without blocking on the render thread if a new texture has to be
+	 * created. Unlike ReserveTexture, new textures are cleared by the renderer rather than immediately.
+	 * @param Size The dimensions of the texture
+	 * @param Format Format of the texture
+	 * @param Owner The UObject which will temporarily own this texture, see ReserveTexture
+	 * @param OnReady Called once the texture is ready to use. If a ready texture was available in the pool, this is
+	 * called before this function returns.
+	 * @return The reservation, which will be pending (see FStevesTextureRenderTargetReservation::IsReady) until
+	 * OnReady is called. Null if a new texture was needed but would have exceeded the pool's memory cap.
+	 */
+	FStevesTextureRenderTargetReservationPtr ReserveTextureAsync(FIntPoint Size,
+	                                                             ETextureRenderTargetFormat Format,
+	                                                             const UObject* Owner,
+	                                                             FOnStevesTextureRenderTargetReady OnReady = FOnStevesTextureRenderTargetReady());
+
+	/**
+	 * Create unreserved textures up front, e.g. during loading, so that later reservations don't need to create them.
+	 * Textures are created without blocking on the render thread. Sizes are rounded as per the pool's sizing mode.
+	 * Stops early rather than exceed the pool's memory cap or budget.
+	 * @param Specs The sizes, formats and number of textures to create
+	 * @return The number of textures created
+	 */
+	int32 PreWarm(TConstArrayView<FStevesTextureRenderTargetPreWarmSpec> Specs);
+
 	/**
 	 * Forcibly revoke reservations in this pool, either for all owners or for a specific owner.
 	 * Reservations which are revoked will have their weak texture pointers invalidated.
@@ -145,6 +300,64 @@ public:
 	 * as well (the weak pointer on their reservations will cease to be valid)
 	 */
 	void DrainPool(bool bForceAndRevokeReservations = false);
+
+	/**
+	 * Change how requested sizes are matched to pooled textures. When sizes are rounded up, a request can also be
+	 * served by the smallest larger unreserved texture of the same format, so long as it's not too wasteful.
+	 * Only affects future reservations.
+	 * @param InSizing The sizing mode
+	 * @param InBucketGranularity For Bucketed mode, the multiple that sizes are rounded up to
+	 * @param InMaxBestFitAreaRatio The largest ratio of texture area to rounded area to accept when re-using a larger texture
+	 */
+	void SetSizing(EStevesTextureRenderTargetSizing InSizing, int32 InBucketGranularity = 32, float InMaxBestFitAreaRatio = 4.0f);
+
+	/// Get the sizing mode of this pool
+	EStevesTextureRenderTargetSizing GetSizing() const { return Sizing; }
+
+	/**
+	 * Cap the estimated memory used by all textures in this pool, reserved or not. When creating a texture would
+	 * exceed this, unreserved textures are released to make room; if that's not enough, the reservation fails.
+	 * @param Bytes The maximum memory, or 0 for unlimited
+	 */
+	void SetMaxMemory(uint64 Bytes) { MaxMemory = Bytes; }
+
+	/// Get the memory cap for this pool, 0 if unlimited
+	uint64 GetMaxMemory() const { return MaxMemory; }
+
+	/**
+	 * Set a soft memory budget for this pool. Unlike the memory cap this never causes a reservation to fail, but while
+	 * the estimated memory of all textures exceeds it, unreserved textures are released, least recently used first.
+	 * @param Bytes The budget, or 0 for unlimited
+	 */
+	void SetMemoryBudget(uint64 Bytes);
+
+	/// Get the soft memory budget for this pool, 0 if unlimited
+	uint64 GetMemoryBudget() const { return MemoryBudget; }
+
+	/**
+	 * Release unreserved textures once they've gone unused for a period of time. Textures are only checked when
+	 * EvictIdleTextures is called; pools created by UStevesGameSubsystem are checked periodically.
+	 * @param Seconds The idle time, or 0 to keep unreserved textures until drained
+	 */
+	void SetIdleEvictTime(double Seconds) { IdleEvictTime = FMath::Max(0.0, Seconds); }
+
+	/// Get the time unreserved textures are kept before being evicted, 0 if indefinitely
+	double GetIdleEvictTime() const { return IdleEvictTime; }
+
+	/// Release any unreserved textures which have been idle for longer than the idle evict time
+	void EvictIdleTextures();
+
+	/// Get the number of reservations which re-used an existing texture
+	uint32 GetNumHits() const { return NumHits; }
+	/// Get the number of reservations which had to create a new texture
+	uint32 GetNumMisses() const { return NumMisses; }
+	/// Get the estimated memory used by all textures in this pool, reserved or not
+	uint64 GetTotalMemory() const { return TotalMemory; }
+	/// Get the number of unreserved textures released because of memory limits or idle time
+	uint32 GetNumEvictions() const { return NumEvictions; }
+
+	/// Write occupancy, hit rate & memory statistics to an output device, broken down by format and size
+	void DumpStats(FOutputDevice& Ar) const;
 	
 };
 
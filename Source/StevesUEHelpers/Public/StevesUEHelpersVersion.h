@@ -0,0 +1,33 @@
+// Copyright Steve Streeting 2020 onwards
+// Released under the MIT license
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Guid.h"
+
+/// Custom serialisation version for natively serialised types in this plugin
+struct STEVESUEHELPERS_API FStevesUEHelpersVersion
+{
+	enum Type
+	{
+		BeforeCustomVersionWasAdded = 0,
+		/// Random streams & shuffle bags serialise their state compactly
+		CompactRandomState,
+		/// Balanced 2D/3D random streams also save their current value, so loading is bit-identical
+		RandomStreamCurrentValue,
+
+		// -----<new versions can be added above this line>-------------------------------------------------
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	const static FGuid GUID;
+
+	/// Get the version of this plugin's data in an archive. Archives which carry no custom versions at all, such as
+	/// a plain FMemoryReader, were written by this build so are treated as the latest version, rather than as
+	/// pre-dating the custom version like FArchive::CustomVer would.
+	static int32 Get(const FArchive& Ar);
+
+private:
+	FStevesUEHelpersVersion() {}
+};